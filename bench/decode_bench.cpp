@@ -0,0 +1,942 @@
+// Link G4X Monitor - Host-side decoder microbenchmark
+//
+// Compares the original hand-written parseCustomStream1/2/3 + switch,
+// bare and with the same staleness bookkeeping, against the table-driven
+// SignalDecoder on the same frame mix, and checks/times the Haltech IC7
+// and Generic Dash 2 layouts and a multiplexed frame. Also checks the
+// per-signal staleness timeouts, the backlog's priority order, both
+// capture ring overflow policies, the log writer's block hand-over and
+// file rotation and recovery of its files after a power cut, LOG_CHANGES
+// deadband encoding through the writer's blocks, and a LOG_SESSION
+// recording read back through its index. Then runs the receive path
+// suite (src/pipeline_bench.cpp) that also runs on the Tab5, which prints
+// one JSON line per case; --json prints only those.
+//
+//   ./build.sh bench
+//   ./build.sh bench --json > results.jsonl
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "can_capture.h"
+#include "can_log_writer.h"
+#include "can_pipeline.h"
+#include "ecu_data.h"
+#include "pipeline_bench.h"
+#include "session_log.h"
+#include "signal_changes.h"
+#include "signal_decoder.h"
+
+#define BENCH_HOST_PASSES 2000   // Receive path suite passes over each 1024-frame mix
+
+struct BenchFrame {
+  uint32_t id;
+  uint8_t length;
+  uint8_t data[8];
+};
+
+// ========== LEGACY DECODER (pre table-driven) ==========
+static void legacyStream1(const uint8_t* d, ECUData& e) {
+  e.rpm = ((d[1] << 8) | d[0]) * 0.1;
+  e.tps = d[2] * 0.5;
+  e.aps = d[3] * 0.5;
+  e.mgp = ((d[5] << 8) | d[4]) * 0.1;
+  e.ect = d[6] - 40;
+  e.iat = d[7] - 40;
+}
+
+static void legacyStream2(const uint8_t* d, ECUData& e) {
+  e.lambda = ((d[1] << 8) | d[0]) * 0.001;
+  e.lambda_target = ((d[3] << 8) | d[2]) * 0.001;
+  e.injector_duty = d[4] * 0.5;
+  e.ethanol_percent = d[5];
+  e.battery = ((d[7] << 8) | d[6]) * 0.01;
+}
+
+static void legacyStream3(const uint8_t* d, ECUData& e) {
+  e.oil_press = ((d[1] << 8) | d[0]) * 0.1;
+  e.fuel_press = ((d[3] << 8) | d[2]) * 0.1;
+  e.current_boost_map = d[4];
+  e.current_ethrottle_map = d[5];
+  e.launch_control_active = (d[6] & 0x01) != 0;
+  e.anti_lag_active = (d[6] & 0x02) != 0;
+}
+
+static void legacyDecode(const BenchFrame& f, ECUData& e) {
+  if (f.length < 8) return;
+  switch (f.id) {
+    case CUSTOM_STREAM_ID_1: legacyStream1(f.data, e); break;
+    case CUSTOM_STREAM_ID_2: legacyStream2(f.data, e); break;
+    case CUSTOM_STREAM_ID_3: legacyStream3(f.data, e); break;
+  }
+}
+
+// The switch with the staleness bookkeeping SignalDecoder does on every
+// frame - signal stamps, valid bits and the period estimate - written out
+// by hand, so the two decoders are timed on the same work
+struct LegacyTiming {
+  uint32_t last_ms;
+  uint32_t interval_ewma;
+  bool seen;
+};
+
+static LegacyTiming legacy_timing[3];
+
+static void legacyTrackPeriod(LegacyTiming& t, uint32_t now_ms) {
+  if (t.seen) {
+    uint32_t interval = now_ms - t.last_ms;
+    if (t.interval_ewma == 0) {
+      t.interval_ewma = interval << STALE_EWMA_SHIFT;
+    } else {
+      if (interval > STALE_MIN_TIMEOUT_MS) {
+        uint32_t timeout = (t.interval_ewma >> STALE_EWMA_SHIFT) * STALE_INTERVALS;
+        if (timeout < STALE_MIN_TIMEOUT_MS) timeout = STALE_MIN_TIMEOUT_MS;
+        if (interval > timeout) interval = timeout;
+      }
+      t.interval_ewma += interval - (t.interval_ewma >> STALE_EWMA_SHIFT);
+    }
+  }
+  t.seen = true;
+  t.last_ms = now_ms;
+}
+
+template <SignalId... Ids>
+static void legacyStamp(ECUData& e, uint32_t now_ms) {
+  ((e.signal_updated_ms[Ids] = now_ms), ...);
+  e.signal_valid |= ((1UL << Ids) | ...);
+}
+
+static void legacyDecodeStamped(const BenchFrame& f, ECUData& e, uint32_t now_ms) {
+  if (f.length < 8) return;
+  switch (f.id) {
+    case CUSTOM_STREAM_ID_1:
+      legacyStream1(f.data, e);
+      legacyStamp<SIG_RPM, SIG_TPS, SIG_APS, SIG_MGP, SIG_ECT, SIG_IAT>(e, now_ms);
+      legacyTrackPeriod(legacy_timing[0], now_ms);
+      break;
+    case CUSTOM_STREAM_ID_2:
+      legacyStream2(f.data, e);
+      legacyStamp<SIG_LAMBDA, SIG_LAMBDA_TARGET, SIG_INJECTOR_DUTY, SIG_ETHANOL, SIG_BATTERY>(e, now_ms);
+      legacyTrackPeriod(legacy_timing[1], now_ms);
+      break;
+    case CUSTOM_STREAM_ID_3:
+      legacyStream3(f.data, e);
+      legacyStamp<SIG_OIL_PRESS, SIG_FUEL_PRESS, SIG_BOOST_MAP, SIG_ETHROTTLE_MAP, SIG_LAUNCH_ACTIVE,
+                  SIG_ANTI_LAG_ACTIVE>(e, now_ms);
+      legacyTrackPeriod(legacy_timing[2], now_ms);
+      break;
+  }
+}
+
+// ========== FRAME MIX ==========
+// Custom stream rates are 20/20/10 Hz; add unrelated bus traffic so the
+// miss path is exercised as well.
+static std::vector<BenchFrame> buildFrameMix(size_t count) {
+  static const uint32_t ids[] = {0x500, 0x501, 0x500, 0x501, 0x502, 0x3E8, 0x123, 0x7DF};
+  std::vector<BenchFrame> frames(count);
+  uint32_t seed = 0x12345678;
+  for (size_t i = 0; i < count; i++) {
+    frames[i].id = ids[i % (sizeof(ids) / sizeof(ids[0]))];
+    frames[i].length = 8;
+    for (int b = 0; b < 8; b++) {
+      seed = seed * 1664525u + 1013904223u;
+      frames[i].data[b] = seed >> 24;
+    }
+  }
+  return frames;
+}
+
+static bool sameDecodedData(const ECUData& a, const ECUData& b) {
+  for (int i = 0; i < SIG_COUNT; i++) {
+    const SignalField& f = SIGNAL_FIELDS[i];
+    switch (f.kind) {
+      case KIND_FLOAT: {
+        float diff = a.*f.f - b.*f.f;
+        if (diff > 0.001f || diff < -0.001f) return false;
+        break;
+      }
+      case KIND_U8: if (a.*f.u8 != b.*f.u8) return false; break;
+      case KIND_BOOL: if (a.*f.flag != b.*f.flag) return false; break;
+    }
+  }
+  return true;
+}
+
+// ========== HALTECH IC7 ==========
+static BenchFrame ic7Frame(uint32_t id, const uint16_t (&words)[4]) {
+  BenchFrame f = {id, 8, {}};
+  for (int i = 0; i < 4; i++) {
+    f.data[i * 2] = words[i] >> 8;
+    f.data[i * 2 + 1] = words[i] & 0xFF;
+  }
+  return f;
+}
+
+static bool near(float value, float expected) {
+  float diff = value - expected;
+  return diff < 0.01f && diff > -0.01f;
+}
+
+// Known raw values at the default base ID (864) through to physical units
+static bool checkHaltechIC7(SignalDecoder& decoder) {
+  ECUData e;
+  const BenchFrame frames[] = {
+    ic7Frame(0x360, {6500, 2013, 455, 0}),       // 6500 rpm, 201.3 kPa MAP, 45.5% TPS
+    ic7Frame(0x361, {3000, 4500, 0, 0}),         // fuel 300.0 kPa, oil 450.0 kPa
+    ic7Frame(0x362, {725, 120, (uint16_t)-55, 0}),  // duty 72.5/12.0%, timing -5.5 deg
+    ic7Frame(0x368, {980, 1020, 0, 0}),          // lambda 0.980 / 1.020
+    ic7Frame(0x3E0, {3632, 3032, 3132, 3732}),   // 90.05/30.05/40.05/100.05 C
+  };
+  for (const BenchFrame& f : frames) {
+    if (!decoder.decode(f.id, f.data, f.length, e, 0)) return false;
+  }
+  return near(e.rpm, 6500) && near(e.mgp, 100.0f) && near(e.tps, 45.5f) &&
+         near(e.fuel_press, 300.0f) && near(e.oil_press, 450.0f) &&
+         near(e.injector_duty, 72.5f) && near(e.injector_duty_2, 12.0f) &&
+         near(e.ignition_timing, -5.5f) &&
+         near(e.lambda, 0.980f) && near(e.lambda_2, 1.020f) &&
+         near(e.ect, 90.05f) && near(e.iat, 30.05f) &&
+         near(e.fuel_temp, 40.05f) && near(e.oil_temp, 100.05f);
+}
+
+// ========== GENERIC DASH 2 ==========
+// Worked example from docs/Link_G4X_Dash2Pro_Protocol.md
+static bool checkGenericDash2(SignalDecoder& decoder) {
+  ECUData e;
+  const BenchFrame frames[] = {
+    {1000, 8, {0x40, 0x1F, 0xC8, 0x64, 0x46, 0x84, 0x03, 0x78}},
+    {1001, 8, {0x87, 0x00, 0xB4, 0x00, 0x90, 0x01, 0x00, 0x00}},
+    {1002, 8, {0x40, 0x01, 0x5E, 0x01, 0xE8, 0x03, 0x00, 0x00}},
+    {1003, 8, {0x55, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+  };
+  for (const BenchFrame& f : frames) {
+    if (!decoder.decode(f.id, f.data, f.length, e, 0)) return false;
+  }
+  return decoder.provides(SIG_VEHICLE_SPEED) &&
+         near(e.rpm, 8000) && near(e.tps, 100.0f) && near(e.ect, 60.0f) &&
+         near(e.iat, 30.0f) && near(e.mgp, 90.0f) && near(e.battery, 12.0f) &&
+         near(e.oil_temp, 95.0f) && near(e.ignition_timing, 18.0f) && near(e.speed, 40.0f) &&
+         near(e.oil_press, 320.0f) && near(e.fuel_press, 350.0f) && near(e.lambda, 1.0f) &&
+         near(e.ecu_temp, 45.0f);
+}
+
+// ========== STALENESS ==========
+// 0x500 every 50ms: fresh while it keeps coming, stale three periods
+// after it stops; signals of frames never seen stay invalid throughout
+static bool checkStaleness(SignalDecoder& decoder) {
+  ECUData e;
+  const uint8_t data[8] = {};
+  uint32_t now = 1000;
+  for (int i = 0; i < 20; i++, now += 50) {
+    decoder.decode(CUSTOM_STREAM_ID_1, data, 8, e, now);
+    decoder.refreshValidity(e, now);
+    if (!e.valid(SIG_RPM) || e.valid(SIG_LAMBDA)) return false;
+  }
+  uint8_t slot = 0;
+  if (decoder.frameInterval(slot) != 50 || decoder.frameTimeout(slot) != 150) return false;
+
+  uint32_t last = now - 50;
+  decoder.refreshValidity(e, last + 150);
+  if (!e.valid(SIG_RPM)) return false;
+  decoder.refreshValidity(e, last + 151);
+  return !e.valid(SIG_RPM) && e.signal_updated_ms[SIG_RPM] == last;
+}
+
+// ========== MULTIPLEXED FRAMES ==========
+// One ID, page index in byte 0, a different set of channels per page
+const uint16_t MUX_EXAMPLE_ID = 0x510;
+
+inline constexpr SignalDescriptor MUX_EXAMPLE_SIGNALS[] = {
+  // Page 0 - Temperatures
+  {MUX_EXAMPLE_ID, 1, 1, SIG_LITTLE_ENDIAN, 0, 1.0f, -40.0f, SIG_OIL_TEMP, 0},
+  {MUX_EXAMPLE_ID, 2, 1, SIG_LITTLE_ENDIAN, 0, 1.0f, -40.0f, SIG_FUEL_TEMP, 0},
+  {MUX_EXAMPLE_ID, 3, 1, SIG_LITTLE_ENDIAN, 0, 1.0f, -40.0f, SIG_ECU_TEMP, 0},
+
+  // Page 1 - Second bank
+  {MUX_EXAMPLE_ID, 1, 2, SIG_LITTLE_ENDIAN, 0, 0.001f, 0.0f, SIG_LAMBDA_2, 1},
+  {MUX_EXAMPLE_ID, 3, 1, SIG_LITTLE_ENDIAN, 0, 0.5f, 0.0f, SIG_INJECTOR_DUTY_2, 1},
+  {MUX_EXAMPLE_ID, 4, 2, SIG_LITTLE_ENDIAN | SIG_SIGNED, 0, 0.1f, 0.0f, SIG_IGNITION_TIMING, 1},
+
+  // Page 5 - Chassis (pages need not be consecutive)
+  {MUX_EXAMPLE_ID, 1, 2, SIG_LITTLE_ENDIAN, 0, 0.1f, 0.0f, SIG_VEHICLE_SPEED, 5},
+
+  // Plain frame alongside
+  {CUSTOM_STREAM_ID_1, 0, 2, SIG_LITTLE_ENDIAN, 0, 0.1f, 0.0f, SIG_RPM},
+};
+
+inline constexpr auto MUX_EXAMPLE_FRAMES =
+    compileSignalTable<MUX_EXAMPLE_SIGNALS, sizeof(MUX_EXAMPLE_SIGNALS) / sizeof(MUX_EXAMPLE_SIGNALS[0])>();
+
+// Each page decodes its own channels and keeps its own freshness; pages
+// without a layout are ignored; an ID cannot be both plain and multiplexed
+static bool checkMultiplexed(SignalDecoder& decoder) {
+  if (decoder.frameCount() != 4) return false;
+
+  ECUData e;
+  const BenchFrame frames[] = {
+    {MUX_EXAMPLE_ID, 8, {0, 130, 70, 85, 0, 0, 0, 0}},                 // 90/30/45 C
+    {MUX_EXAMPLE_ID, 8, {1, 0xFC, 0x03, 50, 0x9E, 0x00, 0, 0}},       // 1.020, 25.0%, 15.8 deg
+    {MUX_EXAMPLE_ID, 8, {5, 0xC4, 0x09, 0, 0, 0, 0, 0}},               // 250.0 km/h
+    {MUX_EXAMPLE_ID, 8, {2, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}}, // No page 2
+  };
+  uint32_t now = 1000;
+  for (const BenchFrame& f : frames) {
+    if (!decoder.decode(f.id, f.data, f.length, e, now)) return false;
+  }
+  if (!near(e.oil_temp, 90.0f) || !near(e.fuel_temp, 30.0f) || !near(e.ecu_temp, 45.0f) ||
+      !near(e.lambda_2, 1.020f) || !near(e.injector_duty_2, 25.0f) || !near(e.ignition_timing, 15.8f) ||
+      !near(e.speed, 250.0f)) {
+    return false;
+  }
+
+  // Page 0 keeps coming, page 1 stops (1000ms default timeout, one frame seen)
+  for (int i = 0; i < 25; i++) {
+    now += 50;
+    decoder.decode(MUX_EXAMPLE_ID, frames[0].data, 8, e, now);
+  }
+  decoder.refreshValidity(e, now);
+  if (!e.valid(SIG_OIL_TEMP) || e.valid(SIG_LAMBDA_2) || e.valid(SIG_RPM)) return false;
+
+  FrameLayout layouts[2] = {MUX_EXAMPLE_FRAMES[0], MUX_EXAMPLE_FRAMES[0]};
+  layouts[1].mux = SIG_NOT_MULTIPLEXED;
+  static SignalDecoder rejected;
+  if (rejected.configure(layouts, 2)) return false;
+  layouts[1].mux = layouts[0].mux;
+  return !rejected.configure(layouts, 2);
+}
+
+// ========== BACKLOG ==========
+// A backlogged IC7 batch: temperatures and injection ahead of two engine
+// frames. Only the newer engine frame is decoded, and before the rest.
+static bool checkBacklog(SignalDecoder& decoder) {
+  static CANStatsTable stats;
+  if (!stats.allocate()) return false;
+  BusLoadMeter bus_load;
+  ECUData e;
+  CANPipeline pipeline(stats, bus_load, decoder, e);
+
+  const BenchFrame frames[] = {
+    ic7Frame(0x3E0, {3632, 3032, 3132, 3732}),   // Slow
+    ic7Frame(0x362, {725, 120, 0, 0}),           // Normal
+    ic7Frame(0x360, {3000, 1013, 0, 0}),         // Critical, superseded
+    ic7Frame(0x360, {6500, 2013, 0, 0}),         // Critical
+  };
+  for (const BenchFrame& f : frames) {
+    RxFrame frame = {0, f.id, 0, f.length, {}};
+    memcpy(frame.data, f.data, 8);
+    pipeline.defer(frame, 0, 0);
+  }
+
+  uint32_t order[4], decoded = 0;
+  pipeline.flushDeferred(0, 0, [&](const RxFrame& frame) {
+    if (decoded < 4) order[decoded] = frame.identifier;
+    decoded++;
+  });
+
+  const CANDecodeCounters& counters = pipeline.counters();
+  return decoded == 3 && order[0] == 0x360 && order[1] == 0x362 && order[2] == 0x3E0 &&
+         near(e.rpm, 6500) && stats.idCount() == 3 && counters.superseded[PRIORITY_CRITICAL] == 1 &&
+         counters.processed[PRIORITY_CRITICAL] == 1 && counters.processed[PRIORITY_NORMAL] == 1 &&
+         counters.processed[PRIORITY_SLOW] == 1 && counters.backlog_batches == 1;
+}
+
+// 0x360 every 20ms, backlogged five frames to a batch: one frame in five
+// is decoded, but the period stays 20ms rather than 100. A frame too
+// short for the layout is neither decoded nor counted.
+static bool checkBacklogPeriod() {
+  static CANStatsTable stats;
+  static SignalDecoder decoder;
+  if (!stats.allocate() || !decoder.configure(HALTECH_IC7_FRAMES.data(), HALTECH_IC7_FRAMES.size(), 864)) {
+    return false;
+  }
+  BusLoadMeter bus_load;
+  ECUData e;
+  CANPipeline pipeline(stats, bus_load, decoder, e);
+
+  BenchFrame f = ic7Frame(0x360, {3000, 1013, 0, 0});
+  RxFrame frame = {0, f.id, 0, f.length, {}};
+  memcpy(frame.data, f.data, 8);
+  uint32_t now_us = 0;
+  for (int batch = 0; batch < 20; batch++) {
+    for (int i = 0; i < 5; i++) {
+      now_us += 20000;
+      frame.timestamp_us = now_us;
+      pipeline.defer(frame, now_us / 1000, now_us);
+    }
+    pipeline.flushDeferred(now_us / 1000, now_us, [](const RxFrame&) {});
+  }
+
+  frame.data_length = 4;   // 0x360 needs 6
+  pipeline.process(frame, now_us / 1000, now_us);
+  pipeline.defer(frame, now_us / 1000, now_us);
+  pipeline.flushDeferred(now_us / 1000, now_us, [](const RxFrame&) {});
+
+  const CANDecodeCounters& counters = pipeline.counters();
+  uint8_t slot = decoder.slotFor(0x360, frame.data, 8);
+  return decoder.frameInterval(slot) == 20 && counters.processed[PRIORITY_CRITICAL] == 20 &&
+         counters.superseded[PRIORITY_CRITICAL] == 80;
+}
+
+// ========== FRAME CAPTURE ==========
+// Ten frames into a four-record ring: KEEP_NEWEST ends holding frames 6-9,
+// KEEP_OLDEST frames 0-3, and the losses land in the matching counter.
+// The ring wraps mid-pop on the way.
+static bool checkCapture(CANCapturePolicy policy) {
+  CANCaptureRing ring;
+  if (!ring.allocate(4)) return false;
+  ring.setPolicy(policy);
+
+  CANLogRecord records[4];
+  RxFrame frame = {0, 0, 0, 8, {}};
+  for (uint32_t n = 0; n < 3; n++) ring.push(frame);
+  if (ring.pop(records, 4) != 3) return false;
+
+  for (uint32_t n = 0; n < 10; n++) {
+    frame = {n * 1000 + 7, n == 9 ? 0x18FEF100 : 0x360 + n, (uint8_t)(n == 9), (uint8_t)(n % 9), {(uint8_t)n}};
+    ring.push(frame);
+  }
+  if (ring.depth() != 4 || ring.peakDepth() != 4 || ring.capturedFrames() != (policy == CAPTURE_KEEP_NEWEST ? 13u : 7u)) {
+    return false;
+  }
+
+  uint32_t first = policy == CAPTURE_KEEP_NEWEST ? 6 : 0;
+  if (ring.pop(records, 4) != 4 || ring.pop(records, 4) != 0) return false;
+  for (uint32_t i = 0; i < 4; i++) {
+    uint32_t n = first + i;
+    const CANLogRecord& record = records[i];
+    if (record.timestampUs() != ((n * 1000 + 7) & ~CAN_LOG_DLC_MASK) || record.length() != n % 9 ||
+        record.data[0] != n || record.extended() != (n == 9) ||
+        record.identifier() != (n == 9 ? 0x18FEF100 : 0x360 + n)) {
+      return false;
+    }
+  }
+  return policy == CAPTURE_KEEP_NEWEST ? ring.overwrittenFrames() == 6 && ring.droppedFrames() == 0
+                                       : ring.droppedFrames() == 6 && ring.overwrittenFrames() == 0;
+}
+
+// ========== LOG WRITER ==========
+// Files in memory, preallocated with zeros; records which were opened
+// and removed, and how much of each was written when it was closed
+struct MemoryLogSink : LogFileSink {
+  std::vector<uint8_t> files[8];
+  uint32_t written[8] = {};
+  uint32_t current = 0;
+  size_t position = 0;
+  std::vector<uint32_t> opened, removed;
+
+  bool open(uint32_t index, uint32_t preallocate_bytes) override {
+    current = index;
+    position = 0;
+    files[index].assign(preallocate_bytes, 0);
+    opened.push_back(index);
+    return true;
+  }
+  bool write(const uint8_t* data, size_t length) override {
+    if (position + length > files[current].size()) return false;
+    memcpy(files[current].data() + position, data, length);
+    position += length;
+    return true;
+  }
+  void close(uint32_t written_bytes) override { written[current] = written_bytes; }
+  void remove(uint32_t index) override { removed.push_back(index); }
+};
+
+struct MemoryLogFile {
+  const std::vector<uint8_t>* bytes;
+  size_t position;
+};
+
+static size_t readMemoryLog(void* context, char* buffer, size_t length) {
+  MemoryLogFile& file = *(MemoryLogFile*)context;
+  size_t left = file.bytes->size() - file.position;
+  if (length > left) length = left;
+  memcpy(buffer, file.bytes->data() + file.position, length);
+  file.position += length;
+  return length;
+}
+
+// Blocks a reader recovers from file, and why it stopped. Checks every
+// record continues the frame numbering from first_frame.
+static CANLogBlockStatus recoverLog(const std::vector<uint8_t>& bytes, uint32_t first_frame, uint32_t& blocks) {
+  static uint8_t block[CAN_LOG_BLOCK_BYTES];
+  MemoryLogFile file = {&bytes, 0};
+  CANLogBlockReader reader;
+  reader.begin(readMemoryLog, &file);
+
+  uint32_t n = first_frame;
+  CANLogBlockStatus status;
+  while ((status = reader.next(block)) == LOG_BLOCK_OK) {
+    const CANLogBlockHeader* header = (const CANLogBlockHeader*)block;
+    for (uint32_t i = 0; i < header->record_count; i++, n++) {
+      const CANLogRecord& record = logBlockRecords(block)[i];
+      if (record.timestampUs() != n << 4 || record.data[0] != (uint8_t)n) return LOG_BLOCK_TORN;
+    }
+  }
+  blocks = reader.blockCount();
+  return status;
+}
+
+static uint32_t bench_clock_us = 0;
+static uint32_t benchLogClock() { return bench_clock_us += 250; }
+
+// 2500 frames: two full blocks go out, the filler stalls (once, however
+// often it polls) with both queued, and the remainder leaves as a partial block once it is
+// CAN_LOG_FLUSH_MS old. Files hold two blocks, start at 5 and remove
+// files two back. A reader then recovers both files, stops at the
+// unwritten half of the second, and at a torn or a stale block.
+static bool checkLogWriter() {
+  CANCaptureRing ring;
+  CANLogWriter writer;
+  MemoryLogSink sink;
+  if (!ring.allocate(4096) || !writer.allocate()) return false;
+  writer.begin(&sink, benchLogClock, CAN_LOG_CONTENT_FRAMES, 0x5E55, 5, 2 * CAN_LOG_BLOCK_BYTES + 100, 2);
+
+  for (uint32_t n = 0; n < 2500; n++) {
+    RxFrame frame = {n << 4, 0x360, 0, 8, {(uint8_t)n, (uint8_t)(n >> 8)}};
+    ring.push(frame);
+  }
+  writer.fill(ring, 0);
+  writer.fill(ring, 0);   // The same stall, polled again
+  if (writer.fillStalls() != 1 || writer.writeReady() != true || writer.writeReady() != true) return false;
+
+  writer.fill(ring, 1);
+  writer.fill(ring, CAN_LOG_FLUSH_MS);
+  if (writer.writeReady() || ring.depth() != 0) return false;   // Partial block, not yet due
+  writer.fill(ring, 1 + CAN_LOG_FLUSH_MS);
+  if (!writer.writeReady() || writer.writeReady() || !writer.idle()) return false;
+  writer.end();
+
+  CANLogWriterStats stats = {};
+  writer.readStats(stats);
+  if (sink.opened != std::vector<uint32_t>{5, 6} || sink.removed != std::vector<uint32_t>{3, 4} ||
+      stats.bytes_written != 3 * CAN_LOG_BLOCK_BYTES || stats.blocks_written != 3 || stats.files_opened != 2 ||
+      stats.file_index != 6 || stats.file_bytes != CAN_LOG_BLOCK_BYTES || stats.worst_write_us != 250 ||
+      sink.files[5].size() != 2 * CAN_LOG_BLOCK_BYTES) {
+    return false;
+  }
+
+  uint32_t blocks;
+  if (recoverLog(sink.files[5], 0, blocks) != LOG_BLOCK_END || blocks != 2) return false;
+  if (recoverLog(sink.files[6], 2 * CAN_LOG_BLOCK_RECORDS, blocks) != LOG_BLOCK_UNWRITTEN || blocks != 1) return false;
+
+  // The same session's block from another file in the unwritten half
+  std::vector<uint8_t> stale = sink.files[6];
+  memcpy(stale.data() + CAN_LOG_BLOCK_BYTES, sink.files[5].data() + CAN_LOG_BLOCK_BYTES, CAN_LOG_BLOCK_BYTES);
+  if (recoverLog(stale, 2 * CAN_LOG_BLOCK_RECORDS, blocks) != LOG_BLOCK_STALE || blocks != 1) return false;
+
+  // Power lost part way through the second block
+  std::vector<uint8_t> torn = sink.files[5];
+  torn[CAN_LOG_BLOCK_BYTES + 5000] ^= 0x01;
+  if (recoverLog(torn, 0, blocks) != LOG_BLOCK_TORN || blocks != 1) return false;
+  torn.resize(CAN_LOG_BLOCK_BYTES + 5000);
+  return recoverLog(torn, 0, blocks) == LOG_BLOCK_TORN && blocks == 1;
+}
+
+// ========== SIGNAL CHANGES ==========
+// Ten minutes of cruise sampled every 20 ms: RPM, lambda and pressures
+// jitter inside their deadbands, RPM and speed drift, ECT warms, one map
+// change. Every sample's groups are decoded straight back, and at every
+// sample each decoded value must be within its deadband of the truth.
+// Then the file must recover to the same number of values, with a
+// keyframe at the start of every block, in a tenth of the bytes of the
+// frames behind it (IC7 at 210 frames/s).
+static bool checkSignalChanges() {
+  const uint32_t samples = 30000, sample_ms = 20, frames_per_s = 210;
+  CANLogWriter writer;
+  MemoryLogSink sink;
+  if (!writer.allocate()) return false;
+  writer.begin(&sink, benchLogClock, CAN_LOG_CONTENT_CHANGES, 0xC4A6, 0, 32 * CAN_LOG_BLOCK_BYTES, 8);
+
+  SignalChangeEncoder encoder;
+  SignalChangeDecoder decoder;
+  float decoded[SIG_COUNT] = {};
+  auto keep = [&](uint32_t, SignalId signal, float value) { decoded[signal] = value; };
+
+  ECUData data;
+  data.signal_valid = (1UL << SIG_COUNT) - 1;
+  uint32_t seed = 1;
+  auto jitter = [&](float range) {
+    seed = seed * 1103515245 + 12345;
+    return ((int32_t)((seed >> 16) % 2001) - 1000) / 1000.0f * range;
+  };
+  uint32_t blocks = 0;
+  for (uint32_t n = 0; n < samples; n++) {
+    uint32_t now_ms = n * sample_ms;
+    data.rpm = 2500 + 200 * (n % 6000 < 3000 ? n % 3000 : 3000 - n % 3000) / 3000.0f + jitter(4);
+    data.speed = data.rpm / 25;
+    data.lambda = 1.0f + jitter(0.002f);
+    data.oil_press = 320 + jitter(0.9f);
+    data.fuel_press = 300 + jitter(0.9f);
+    data.ect = 80 + n / 3000.0f;
+    data.current_boost_map = n < samples / 2 ? 1 : 2;
+
+    bool fresh;
+    uint8_t* out = writer.reserve(SIGNAL_CHANGE_GROUP_MAX, now_ms, fresh);
+    if (!out) return false;
+    if (fresh) {
+      encoder.restart();
+      decoder.restart();
+      blocks++;
+    }
+    size_t length = encoder.encode(data, now_ms, out);
+    if (fresh && length == 0) return false;   // Keyframe
+    writer.commit(length);
+    if (!decoder.decode(out, length, keep)) return false;
+    while (writer.writeReady()) {}
+
+    for (uint8_t s = 0; s < SIG_COUNT; s++) {
+      const SignalLogStep& step = SIGNAL_LOG_STEPS[s];
+      float error = decoded[s] - signalValue(data, (SignalId)s);
+      if (error < 0) error = -error;
+      if (error > (step.deadband + 0.5f) / step.counts_per_unit + 1e-3f) return false;
+    }
+  }
+  writer.flush();
+  while (writer.writeReady()) {}
+  writer.end();
+
+  const SignalChangeStats& stats = encoder.stats();
+  uint32_t raw_bytes = samples * sample_ms / 1000 * frames_per_s * sizeof(CANLogRecord);
+  if (stats.samples != samples || stats.groups == 0 || stats.bytes * 10 > raw_bytes) return false;
+
+  // The file: blocks of changes that each decode on their own
+  static uint8_t block[CAN_LOG_BLOCK_BYTES];
+  MemoryLogFile file = {&sink.files[0], 0};
+  CANLogBlockReader reader;
+  reader.begin(readMemoryLog, &file);
+  uint32_t values = 0, keyframes = 0;
+  while (reader.next(block) == LOG_BLOCK_OK) {
+    const CANLogBlockHeader* header = (const CANLogBlockHeader*)block;
+    if (header->content != CAN_LOG_CONTENT_CHANGES) return false;
+    // The first group holds every signal, at its absolute time
+    decoder.restart();
+    uint32_t first_ms = UINT32_MAX, first_values = 0;
+    if (!decoder.decode(logBlockPayload(block), header->record_count, [&](uint32_t time_ms, SignalId, float) {
+          if (first_ms == UINT32_MAX) first_ms = time_ms;
+          if (time_ms == first_ms) first_values++;
+          values++;
+        })) {
+      return false;
+    }
+    if (first_values == SIG_COUNT) keyframes++;
+  }
+  return reader.blockCount() == blocks && reader.recordCount() == stats.bytes && values == stats.changes &&
+         keyframes == blocks;
+}
+
+// ========== SESSION LOG ==========
+static uint32_t sessionRpm(uint32_t time_ms) { return 2000 + time_ms / 20 % 400; }
+
+// Block sequence of a session, found the way a viewer would: by file and
+// position, without reading the blocks before it, and checked by its
+// header
+static const uint8_t* sessionBlock(const MemoryLogSink& sink, const SessionFooter& footer, uint32_t sequence) {
+  const std::vector<uint8_t>& file = sink.files[footer.first_file_index + sequence / footer.blocks_per_file];
+  size_t position = (size_t)(sequence % footer.blocks_per_file) * CAN_LOG_BLOCK_BYTES;
+  if (position + CAN_LOG_BLOCK_BYTES > file.size()) return nullptr;
+  const CANLogBlockHeader* header = (const CANLogBlockHeader*)(file.data() + position);
+  return header->sequence == sequence ? file.data() + position : nullptr;
+}
+
+// Ten minutes recorded at a 10 ms loop with every signal decoded every
+// 20 ms, into files of 16 blocks from number 2, keeping two files: only
+// the older files 0 and 1 are removed, never the session's own. A viewer then goes from
+// the last block of the last file to the index and straight to the
+// chunk for a few seconds, reading RPM alone; RPM must be there at every
+// update and ECT at 1 Hz. Reading every block in order finds the same.
+static bool checkSessionLog() {
+  const uint32_t start_ms = 1000, samples = 60000;
+  CANLogWriter writer;
+  MemoryLogSink sink;
+  SessionLogEncoder session;
+  if (!writer.allocate() || !session.allocate(SESSION_INDEX_ENTRIES)) return false;
+  writer.begin(&sink, benchLogClock, CAN_LOG_CONTENT_SESSION, 0x5E5, 2, 16 * CAN_LOG_BLOCK_BYTES, 2);
+  session.begin(start_ms);
+
+  ECUData data;
+  data.signal_valid = (1UL << SIG_COUNT) - 1;
+  bool fresh;
+  uint32_t now_ms = start_ms;
+  for (uint32_t n = 0; n < samples; n++, now_ms += 10) {
+    if (n % 2 == 0) {
+      for (uint8_t s = 0; s < SIG_COUNT; s++) data.signal_updated_ms[s] = now_ms;
+      data.rpm = sessionRpm(now_ms);
+      data.tps = now_ms / 20 % 100 * 0.5f;
+      data.ect = 80 + (now_ms - start_ms) / 60000;
+    }
+    if (session.chunkDue(now_ms)) {
+      size_t length = session.chunkBytes();
+      uint8_t* chunk = length ? writer.reserve(length, now_ms, fresh) : nullptr;
+      if (length && !chunk) return false;
+      session.closeChunk(chunk, writer.fillSequence(), writer.fillOffset(), now_ms);
+      writer.commit(length);
+      while (writer.writeReady()) {}
+    }
+    session.sample(data, now_ms);
+  }
+
+  // As finishSessionLog() does it
+  size_t length = session.chunkBytes();
+  uint8_t* chunk = length ? writer.reserve(length, now_ms, fresh) : nullptr;
+  session.closeChunk(chunk, writer.fillSequence(), writer.fillOffset(), now_ms);
+  writer.commit(length);
+  writer.flush();
+  const uint8_t* index = session.finishIndex(writer.fillSequence(), 2, writer.blocksPerFile(), length);
+  for (size_t done = 0; done < length;) {
+    size_t piece = std::min(length - done, (size_t)CAN_LOG_BLOCK_PAYLOAD);
+    while (writer.writeReady()) {}
+    uint8_t* out = writer.reserve(piece, now_ms, fresh);
+    if (!out) return false;
+    memcpy(out, index + done, piece);
+    writer.commit(piece);
+    done += piece;
+  }
+  writer.flush();
+  while (writer.writeReady()) {}
+  writer.end();
+
+  const SessionLogStats& stats = session.stats();
+  if (stats.dropped || stats.unindexed || sink.opened.size() < 3 ||
+      sink.removed != std::vector<uint32_t>{0, 1}) {
+    return false;
+  }
+
+  // The footer ends the last block of the last file
+  uint32_t last = sink.opened.back();
+  if (sink.written[last] < CAN_LOG_BLOCK_BYTES) return false;
+  const uint8_t* block = sink.files[last].data() + sink.written[last] - CAN_LOG_BLOCK_BYTES;
+  const CANLogBlockHeader* header = (const CANLogBlockHeader*)block;
+  SessionFooter footer;
+  if (header->content != CAN_LOG_CONTENT_SESSION ||
+      !readSessionFooter(logBlockPayload(block), header->record_count, footer) ||
+      footer.entry_count != stats.chunks || footer.first_file_index != 2 || footer.blocks_per_file != 16) {
+    return false;
+  }
+
+  std::vector<uint8_t> index_bytes;
+  for (uint32_t sequence = footer.index_sequence; index_bytes.size() < footer.index_bytes; sequence++) {
+    const uint8_t* index_block = sessionBlock(sink, footer, sequence);
+    if (!index_block) return false;
+    const uint8_t* payload = logBlockPayload(index_block);
+    index_bytes.insert(index_bytes.end(), payload, payload + ((const CANLogBlockHeader*)index_block)->record_count);
+  }
+  if (index_bytes.size() != footer.index_bytes || index_bytes[0] != SESSION_INDEX_TAG || index_bytes[1] != SIG_COUNT) {
+    return false;
+  }
+
+  static const uint32_t seconds[] = {0, 1, 137, 420, 599};
+  for (uint32_t second : seconds) {
+    uint32_t time_ms = start_ms + second * 1000 + 500;
+    uint32_t i = findSessionChunk(index_bytes.data(), footer.entry_count, time_ms);
+    SessionIndexEntry entry = sessionIndexEntry(index_bytes.data(), i);
+    if (entry.start_ms > time_ms ||
+        (i + 1 < footer.entry_count && sessionIndexEntry(index_bytes.data(), i + 1).start_ms <= time_ms)) {
+      return false;
+    }
+
+    const uint8_t* chunk_block = sessionBlock(sink, footer, entry.sequence);
+    if (!chunk_block) return false;
+    const CANLogBlockHeader* chunk_header = (const CANLogBlockHeader*)chunk_block;
+    uint32_t rpm_samples = 0;
+    bool exact = true;
+    size_t chunk_length = decodeSessionChunk(logBlockPayload(chunk_block) + entry.offset,
+                                             chunk_header->record_count - entry.offset, 1UL << SIG_RPM,
+                                             [&](SignalId signal, uint32_t sample_ms, float value) {
+                                               if (signal != SIG_RPM || value != sessionRpm(sample_ms)) exact = false;
+                                               rpm_samples++;
+                                             });
+    if (!chunk_length || !exact || rpm_samples != SESSION_CHUNK_MS / 20) return false;
+  }
+
+  // Every block in order, chunks until the index
+  static uint8_t scan[CAN_LOG_BLOCK_BYTES];
+  uint32_t values = 0, rpm_samples = 0, ect_samples = 0;
+  bool in_index = false;
+  for (uint32_t file_index : sink.opened) {
+    std::vector<uint8_t> bytes(sink.files[file_index].begin(), sink.files[file_index].begin() + sink.written[file_index]);
+    MemoryLogFile file = {&bytes, 0};
+    CANLogBlockReader reader;
+    reader.begin(readMemoryLog, &file);
+    while (!in_index && reader.next(scan) == LOG_BLOCK_OK) {
+      const CANLogBlockHeader* scan_header = (const CANLogBlockHeader*)scan;
+      const uint8_t* payload = logBlockPayload(scan);
+      for (size_t offset = 0; offset < scan_header->record_count;) {
+        if (payload[offset] == SESSION_INDEX_TAG) {
+          in_index = true;
+          break;
+        }
+        size_t chunk_length = decodeSessionChunk(payload + offset, scan_header->record_count - offset, UINT32_MAX,
+                                                 [&](SignalId signal, uint32_t, float) {
+                                                   values++;
+                                                   rpm_samples += signal == SIG_RPM;
+                                                   ect_samples += signal == SIG_ECT;
+                                                 });
+        if (!chunk_length) return false;
+        offset += chunk_length;
+      }
+    }
+  }
+  return in_index && values == stats.values && rpm_samples == samples / 2 &&
+         ect_samples >= samples / 100 && ect_samples <= samples / 100 + 1;
+}
+
+// Keep the compiler from merging or dropping stores across frames
+static inline void clobberMemory() {
+  asm volatile("" : : : "memory");
+}
+
+template <typename Fn>
+static double framesPerSecond(const std::vector<BenchFrame>& frames, int passes, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int p = 0; p < passes; p++) {
+    for (const BenchFrame& f : frames) {
+      fn(f);
+      clobberMemory();
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+  return (double)frames.size() * passes / seconds;
+}
+
+static void printLine(const char* line) {
+  printf("%s\n", line);
+}
+
+int main(int argc, char** argv) {
+  bool json_only = argc > 1 && strcmp(argv[1], "--json") == 0;
+  const size_t frame_count = 4096;
+  const int passes = 2000;
+  std::vector<BenchFrame> frames = buildFrameMix(frame_count);
+
+  static SignalDecoder decoder;
+  if (!decoder.configure(CUSTOM_STREAM_FRAMES.data(), CUSTOM_STREAM_FRAMES.size())) {
+    fprintf(stderr, "decoder table rejected\n");
+    return 1;
+  }
+
+  // Both paths must agree before their speed means anything
+  ECUData legacy_data, table_data;
+  for (const BenchFrame& f : frames) {
+    legacyDecode(f, legacy_data);
+    decoder.decode(f.id, f.data, f.length, table_data, 0);
+    if (!sameDecodedData(legacy_data, table_data)) {
+      fprintf(stderr, "decode mismatch on ID 0x%03X\n", (unsigned)f.id);
+      return 1;
+    }
+  }
+
+  static SignalDecoder stale_decoder;
+  stale_decoder.configure(CUSTOM_STREAM_FRAMES.data(), CUSTOM_STREAM_FRAMES.size());
+  if (!checkStaleness(stale_decoder)) {
+    fprintf(stderr, "staleness check failed\n");
+    return 1;
+  }
+
+  static SignalDecoder ic7_decoder;
+  if (!ic7_decoder.configure(HALTECH_IC7_FRAMES.data(), HALTECH_IC7_FRAMES.size(), 864) ||
+      !checkHaltechIC7(ic7_decoder)) {
+    fprintf(stderr, "Haltech IC7 decode check failed\n");
+    return 1;
+  }
+  if (!checkBacklog(ic7_decoder) || !checkBacklogPeriod()) {
+    fprintf(stderr, "backlog priority check failed\n");
+    return 1;
+  }
+
+  static SignalDecoder dash2_decoder;
+  if (!dash2_decoder.configure(GENERIC_DASH2_FRAMES.data(), GENERIC_DASH2_FRAMES.size()) ||
+      !checkGenericDash2(dash2_decoder)) {
+    fprintf(stderr, "Generic Dash 2 decode check failed\n");
+    return 1;
+  }
+
+  static SignalDecoder mux_decoder;
+  if (!mux_decoder.configure(MUX_EXAMPLE_FRAMES.data(), MUX_EXAMPLE_FRAMES.size()) ||
+      !checkMultiplexed(mux_decoder)) {
+    fprintf(stderr, "multiplexed frame check failed\n");
+    return 1;
+  }
+
+  if (!checkCapture(CAPTURE_KEEP_NEWEST) || !checkCapture(CAPTURE_KEEP_OLDEST)) {
+    fprintf(stderr, "frame capture ring check failed\n");
+    return 1;
+  }
+  if (!checkLogWriter()) {
+    fprintf(stderr, "log writer check failed\n");
+    return 1;
+  }
+  if (!checkSignalChanges()) {
+    fprintf(stderr, "signal change log check failed\n");
+    return 1;
+  }
+  if (!checkSessionLog()) {
+    fprintf(stderr, "session log check failed\n");
+    return 1;
+  }
+
+  // Decoders checked - timings only from here
+  if (json_only) {
+    return runPipelineBenchmarks("host", BENCH_HOST_PASSES, printLine) ? 0 : 1;
+  }
+
+  double legacy_fps = framesPerSecond(frames, passes, [&](const BenchFrame& f) {
+    legacyDecode(f, legacy_data);
+  });
+  double stamped_fps = framesPerSecond(frames, passes, [&](const BenchFrame& f) {
+    legacyDecodeStamped(f, legacy_data, 0);
+  });
+  double table_fps = framesPerSecond(frames, passes, [&](const BenchFrame& f) {
+    decoder.decode(f.id, f.data, f.length, table_data, 0);
+  });
+
+  // IC7 at full rate: 0x360-0x362 at 50Hz, 0x368 at 20Hz, 0x3E0 at 5Hz
+  std::vector<BenchFrame> ic7_frames = buildFrameMix(frame_count);
+  static const uint32_t ic7_ids[] = {0x360, 0x361, 0x362, 0x360, 0x361, 0x362, 0x368, 0x3E0};
+  for (size_t i = 0; i < ic7_frames.size(); i++) {
+    ic7_frames[i].id = ic7_ids[i % (sizeof(ic7_ids) / sizeof(ic7_ids[0]))];
+  }
+  ECUData ic7_data;
+  double ic7_fps = framesPerSecond(ic7_frames, passes, [&](const BenchFrame& f) {
+    ic7_decoder.decode(f.id, f.data, f.length, ic7_data, 0);
+  });
+
+  // Generic Dash 2: 1000-1003 at 20Hz each (80Hz combined)
+  std::vector<BenchFrame> dash2_frames = buildFrameMix(frame_count);
+  for (size_t i = 0; i < dash2_frames.size(); i++) {
+    dash2_frames[i].id = GENERIC_DASH2_ID_1 + (i % 4);
+  }
+  ECUData dash2_data;
+  double dash2_fps = framesPerSecond(dash2_frames, passes, [&](const BenchFrame& f) {
+    dash2_decoder.decode(f.id, f.data, f.length, dash2_data, 0);
+  });
+
+  // Multiplexed: pages 0, 1 and 5 of one ID in turn
+  std::vector<BenchFrame> mux_frames = buildFrameMix(frame_count);
+  static const uint8_t mux_pages[] = {0, 1, 5};
+  for (size_t i = 0; i < mux_frames.size(); i++) {
+    mux_frames[i].id = MUX_EXAMPLE_ID;
+    mux_frames[i].data[0] = mux_pages[i % 3];
+  }
+  ECUData mux_data;
+  double mux_fps = framesPerSecond(mux_frames, passes, [&](const BenchFrame& f) {
+    mux_decoder.decode(f.id, f.data, f.length, mux_data, 0);
+  });
+
+  printf("frames per pass: %zu, passes: %d\n", frame_count, passes);
+  printf("legacy switch decoder: %12.0f frames/s\n", legacy_fps);
+  printf("legacy + staleness:    %12.0f frames/s\n", stamped_fps);
+  printf("table-driven decoder:  %12.0f frames/s (%.0f%% of legacy + staleness)\n", table_fps,
+         100.0 * table_fps / stamped_fps);
+  printf("haltech ic7 decoder:   %12.0f frames/s\n", ic7_fps);
+  printf("generic dash 2:        %12.0f frames/s (%.0fx the 80Hz stream)\n", dash2_fps, dash2_fps / 80.0);
+  printf("multiplexed 0x510:     %12.0f frames/s\n", mux_fps);
+  printf("checksum: %.3f\n", legacy_data.rpm + table_data.rpm + ic7_data.rpm + dash2_data.rpm + mux_data.speed);
+
+  printf("\nreceive path suite:\n");
+  runPipelineBenchmarks("host", BENCH_HOST_PASSES, printLine);
+  return 0;
+}
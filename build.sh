@@ -135,6 +135,45 @@ deps() {
     print_success "Dependencies updated!"
 }
 
+# Host benchmark function
+bench() {
+    check_project
+
+    if ! command -v g++ &> /dev/null; then
+        print_error "g++ is required for host benchmarks."
+        exit 1
+    fi
+
+    mkdir -p .pio/bench
+    print_status "Building host decoder benchmark..." >&2
+    g++ -O2 -std=gnu++17 -Wall -Isrc bench/decode_bench.cpp src/pipeline_bench.cpp src/signal_decoder.cpp \
+        src/can_stats.cpp src/can_capture.cpp src/can_log_writer.cpp src/can_log_format.cpp \
+        src/bus_load.cpp src/signal_changes.cpp src/session_log.cpp -o .pio/bench/decode_bench
+
+    if [ $? -eq 0 ]; then
+        .pio/bench/decode_bench "$@"
+    else
+        print_error "Benchmark build failed!"
+        exit 1
+    fi
+}
+
+# Native host build function
+native() {
+    check_project
+    activate_venv
+
+    print_status "Building native host core (SocketCAN)..."
+    pio run --environment native
+
+    if [ $? -eq 0 ]; then
+        print_success "Build completed: .pio/build/native/program -i vcan0"
+    else
+        print_error "Native build failed!"
+        exit 1
+    fi
+}
+
 # Show help
 show_help() {
     echo "Link G4X Dashboard Build Script"
@@ -148,6 +187,8 @@ show_help() {
     echo "  monitor   - Start serial monitor"
     echo "  clean     - Clean build files"
     echo "  deps      - Install/update dependencies"
+    echo "  bench     - Build and run host-side decoder benchmarks"
+    echo "  native    - Build the display-less core for Linux (SocketCAN)"
     echo "  help      - Show this help message"
     echo ""
     echo "Examples:"
@@ -177,6 +218,12 @@ case "$1" in
     deps)
         deps
         ;;
+    bench)
+        bench "${@:2}"
+        ;;
+    native)
+        native
+        ;;
     help|--help|-h)
         show_help
         ;;
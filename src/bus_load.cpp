@@ -0,0 +1,74 @@
+// Link G4X Monitor - CAN bus load estimator
+#include "bus_load.h"
+
+#include <string.h>
+
+static_assert(canFrameBits(false, 8) == 135, "11-bit, 8 byte frame is 135 bits worst case");
+static_assert(canFrameBits(true, 8) == 160, "29-bit, 8 byte frame is 160 bits worst case");
+
+static const uint16_t WINDOW_SLOTS[BUS_LOAD_WINDOW_COUNT] = {1, 10, 100};
+
+void BusLoadMeter::reset(uint32_t now_us) {
+  memset(slots_, 0, sizeof(slots_));
+  memset(sums_, 0, sizeof(sums_));
+  memset(peak_bits_, 0, sizeof(peak_bits_));
+  head_ = 0;
+  filled_ = 0;
+  current_bits_ = 0;
+  slot_start_us_ = now_us;
+}
+
+void BusLoadMeter::advance(uint32_t now_us) {
+  uint32_t elapsed = now_us - slot_start_us_;
+  if ((int32_t)elapsed < BUS_LOAD_SLOT_US) return;   // Also ignores slightly stale timestamps
+
+  // More than the whole history has passed: everything is silent slots
+  uint32_t slots = elapsed / BUS_LOAD_SLOT_US;
+  if (slots > BUS_LOAD_SLOTS) slots = BUS_LOAD_SLOTS + 1;
+
+  for (uint32_t i = 0; i < slots; i++) {
+    closeSlot();
+  }
+  slot_start_us_ += (elapsed / BUS_LOAD_SLOT_US) * BUS_LOAD_SLOT_US;
+}
+
+void BusLoadMeter::closeSlot() {
+  // Slots leaving each window as the newest one is added
+  for (uint8_t w = 0; w < BUS_LOAD_WINDOW_COUNT; w++) {
+    uint16_t span = WINDOW_SLOTS[w];
+    if (filled_ >= span) {
+      sums_[w] -= slots_[(head_ + BUS_LOAD_SLOTS - span) % BUS_LOAD_SLOTS];
+    }
+    sums_[w] += current_bits_;
+  }
+
+  slots_[head_] = current_bits_;
+  head_ = (head_ + 1) % BUS_LOAD_SLOTS;
+  if (filled_ < BUS_LOAD_SLOTS) filled_++;
+  current_bits_ = 0;
+
+  // Peaks compare like with like: scale a partly filled window up
+  for (uint8_t w = 0; w < BUS_LOAD_WINDOW_COUNT; w++) {
+    uint32_t slots = windowSlots((BusLoadWindow)w);
+    uint32_t bits = (uint32_t)((uint64_t)sums_[w] * WINDOW_SLOTS[w] / slots);
+    if (bits > peak_bits_[w]) peak_bits_[w] = bits;
+  }
+}
+
+uint32_t BusLoadMeter::windowSlots(BusLoadWindow window) const {
+  uint32_t span = WINDOW_SLOTS[window];
+  if (filled_ < span) return filled_ > 0 ? filled_ : 1;
+  return span;
+}
+
+float BusLoadMeter::load(BusLoadWindow window, uint32_t bitrate) const {
+  if (filled_ == 0 || bitrate == 0) return 0;
+  float seconds = windowSlots(window) * (BUS_LOAD_SLOT_US / 1000000.0f);
+  return sums_[window] * 100.0f / (bitrate * seconds);
+}
+
+float BusLoadMeter::peakLoad(BusLoadWindow window, uint32_t bitrate) const {
+  if (bitrate == 0) return 0;
+  float seconds = WINDOW_SLOTS[window] * (BUS_LOAD_SLOT_US / 1000000.0f);
+  return peak_bits_[window] * 100.0f / (bitrate * seconds);
+}
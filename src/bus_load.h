@@ -0,0 +1,67 @@
+// Link G4X Monitor - CAN bus load estimator
+//
+// Every received frame is charged its worst-case on-wire length: header,
+// data, CRC and the maximum number of stuff bits, plus the fixed-form
+// tail (CRC/ACK delimiters, EOF) and 3-bit intermission. Bits are summed
+// into 100ms slots; a ring of 100 slots gives the 100ms, 1s and 10s
+// windows with running sums, so the RX path only does a table lookup and
+// an add.
+#pragma once
+
+#include <stdint.h>
+
+#define BUS_LOAD_SLOT_US 100000   // 100ms per slot
+#define BUS_LOAD_SLOTS 100        // 10s of history
+
+enum BusLoadWindow : uint8_t {
+  BUS_LOAD_100MS = 0,
+  BUS_LOAD_1S = 1,
+  BUS_LOAD_10S = 2,
+  BUS_LOAD_WINDOW_COUNT
+};
+
+// Worst-case bits on the wire for one data frame, including intermission.
+// Stuffable region: SOF..CRC = 34 (11-bit) or 54 (29-bit) bits + 8 * DLC,
+// with at most one stuff bit per 4 bits after the first.
+constexpr uint16_t canFrameBits(bool extended, uint8_t dlc) {
+  uint16_t stuffable = (extended ? 54 : 34) + 8 * (dlc > 8 ? 8 : dlc);
+  return stuffable + (stuffable - 1) / 4 + 13;
+}
+
+class BusLoadMeter {
+public:
+  void reset(uint32_t now_us);
+
+  void addFrame(bool extended, uint8_t dlc, uint32_t timestamp_us) {
+    advance(timestamp_us);
+    current_bits_ += FRAME_BITS[extended ? 1 : 0][dlc > 8 ? 8 : dlc];
+  }
+
+  // Close any slots that ended before now_us; call regularly even when
+  // the bus is quiet so the windows drain
+  void advance(uint32_t now_us);
+
+  // Utilisation in percent over a window of closed slots (shorter while
+  // the window is still filling after a reset)
+  float load(BusLoadWindow window, uint32_t bitrate) const;
+  float peakLoad(BusLoadWindow window, uint32_t bitrate) const;
+
+private:
+  static constexpr uint16_t FRAME_BITS[2][9] = {
+    {canFrameBits(false, 0), canFrameBits(false, 1), canFrameBits(false, 2), canFrameBits(false, 3), canFrameBits(false, 4),
+     canFrameBits(false, 5), canFrameBits(false, 6), canFrameBits(false, 7), canFrameBits(false, 8)},
+    {canFrameBits(true, 0), canFrameBits(true, 1), canFrameBits(true, 2), canFrameBits(true, 3), canFrameBits(true, 4),
+     canFrameBits(true, 5), canFrameBits(true, 6), canFrameBits(true, 7), canFrameBits(true, 8)},
+  };
+
+  void closeSlot();
+  uint32_t windowSlots(BusLoadWindow window) const;
+
+  uint32_t slots_[BUS_LOAD_SLOTS] = {};   // Closed slots, oldest at head_
+  uint16_t head_ = 0;
+  uint16_t filled_ = 0;
+  uint32_t slot_start_us_ = 0;
+  uint32_t current_bits_ = 0;             // Slot still open
+  uint32_t sums_[BUS_LOAD_WINDOW_COUNT] = {};
+  uint32_t peak_bits_[BUS_LOAD_WINDOW_COUNT] = {};
+};
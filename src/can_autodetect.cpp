@@ -0,0 +1,54 @@
+// Link G4X Monitor - CAN stream fingerprinting
+#include "can_autodetect.h"
+
+#include <string.h>
+
+void ProtocolDetector::clear() {
+  memset(longest_, 0, sizeof(longest_));
+  frame_count_ = 0;
+}
+
+uint8_t ProtocolDetector::framesSeen(const DetectCandidate& candidate) const {
+  uint8_t seen = 0;
+  for (uint8_t i = 0; i < candidate.count; i++) {
+    uint32_t can_id = (uint32_t)candidate.frames[i].can_id + candidate.id_base;
+    if (can_id >= CAN_STD_ID_COUNT) continue;
+    uint8_t need = candidate.frames[i].min_length;
+    if (longest_[can_id] >= (need ? need : 1)) seen++;
+  }
+  return seen;
+}
+
+int ProtocolDetector::completeMatch(const DetectCandidate* candidates, uint8_t count) const {
+  int best = DETECT_NO_MATCH;
+  for (uint8_t i = 0; i < count; i++) {
+    if (candidates[i].count == 0 || framesSeen(candidates[i]) != candidates[i].count) continue;
+    if (best == DETECT_NO_MATCH || candidates[i].count > candidates[best].count) best = i;
+  }
+  return best;
+}
+
+int ProtocolDetector::bestMatch(const DetectCandidate* candidates, uint8_t count) const {
+  int best = DETECT_NO_MATCH;
+  bool tied = false;
+  uint32_t best_seen = 0, best_total = 1;
+
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t total = candidates[i].count;
+    uint32_t seen = framesSeen(candidates[i]);
+    if (total == 0 || seen * 2 < total) continue;
+
+    // Compare seen/total fractions without division
+    uint32_t lhs = seen * best_total;
+    uint32_t rhs = best_seen * total;
+    if (best == DETECT_NO_MATCH || lhs > rhs) {
+      best = i;
+      best_seen = seen;
+      best_total = total;
+      tied = false;
+    } else if (lhs == rhs) {
+      tied = true;
+    }
+  }
+  return tied ? DETECT_NO_MATCH : best;
+}
@@ -0,0 +1,51 @@
+// Link G4X Monitor - CAN stream fingerprinting
+//
+// While the controller listens at a candidate bitrate, every received
+// frame is recorded here: one byte per 11-bit ID holding the longest DLC
+// seen. A stream layout matches once every one of its frame IDs has been
+// seen at least as long as the layout needs. Matching is a scan over a
+// handful of IDs per candidate, so it can run after every frame.
+#pragma once
+
+#include <stdint.h>
+#include "signal_decoder.h"
+
+#define DETECT_NO_MATCH -1
+
+// One stream layout the bus may be carrying
+struct DetectCandidate {
+  const FrameLayout* frames;
+  uint8_t count;
+  uint16_t id_base;    // Added to every frame ID, as in SignalDecoder::configure()
+};
+
+class ProtocolDetector {
+public:
+  ProtocolDetector() { clear(); }
+
+  void clear();
+
+  void addFrame(uint32_t can_id, bool extended, uint8_t length) {
+    frame_count_++;
+    if (extended || can_id >= CAN_STD_ID_COUNT) return;
+    if (length > longest_[can_id]) longest_[can_id] = length;
+  }
+
+  // Candidate whose every frame has been seen, preferring the one with
+  // the most frames when several are complete. DETECT_NO_MATCH if none.
+  int completeMatch(const DetectCandidate* candidates, uint8_t count) const;
+
+  // Best candidate so far: the highest fraction of frames seen, at least
+  // half of them, and strictly ahead of every other candidate.
+  // DETECT_NO_MATCH if nothing qualifies.
+  int bestMatch(const DetectCandidate* candidates, uint8_t count) const;
+
+  // Frames of one candidate seen so far
+  uint8_t framesSeen(const DetectCandidate& candidate) const;
+
+  uint32_t frameCount() const { return frame_count_; }
+
+private:
+  uint8_t longest_[CAN_STD_ID_COUNT];   // 0 = never seen (or only DLC 0)
+  uint32_t frame_count_;
+};
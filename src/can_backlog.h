@@ -0,0 +1,66 @@
+// Link G4X Monitor - Priority-ordered decode backlog
+//
+// When loop() falls behind - a full-screen gauge redraw, an SD card
+// flush - the receive ring holds several frames of every ID, and decoding
+// them in arrival order spends the catch-up on values that are already
+// out of date while RPM and oil pressure wait behind temperatures. Under
+// backlog, frames are queued here instead: one entry per decoder layout,
+// so a newer frame for the same layout (the same ID, or the same page of
+// a multiplexed ID) supersedes the queued one in place, and the queue is
+// drained one priority class at a time, critical first. Within a class
+// layouts keep the order their first frame arrived in.
+//
+// Only the decode is skipped for a superseded frame; statistics and bus
+// load still count it (see CANPipeline::defer()).
+#pragma once
+
+#include <stdint.h>
+#include "can_ring.h"
+#include "signal_decoder.h"
+
+#define CAN_BACKLOG_FRAMES 32   // Ring depth at which readCANData() switches to priority order
+
+class CANBacklog {
+public:
+  CANBacklog() { clear(); }
+
+  // Drop every queued frame
+  void clear() {
+    for (uint8_t slot = 0; slot < DECODER_MAX_FRAMES; slot++) queued_[slot] = false;
+    for (uint8_t p = 0; p < PRIORITY_CLASSES; p++) count_[p] = 0;
+  }
+
+  // Queue frame for layout slot. Returns true if it superseded a frame
+  // already queued for that slot.
+  bool add(uint8_t slot, FramePriority priority, const RxFrame& frame) {
+    frames_[slot] = frame;
+    if (queued_[slot]) return true;
+
+    queued_[slot] = true;
+    order_[priority][count_[priority]++] = slot;
+    return false;
+  }
+
+  // Hand every queued frame to fn(slot, priority, frame), critical class
+  // first, and empty the queue. Returns the number of frames handed over.
+  template <typename Fn>
+  uint32_t drain(Fn&& fn) {
+    uint32_t drained = 0;
+    for (uint8_t p = 0; p < PRIORITY_CLASSES; p++) {
+      for (uint8_t i = 0; i < count_[p]; i++) {
+        uint8_t slot = order_[p][i];
+        queued_[slot] = false;
+        fn(slot, (FramePriority)p, frames_[slot]);
+      }
+      drained += count_[p];
+      count_[p] = 0;
+    }
+    return drained;
+  }
+
+private:
+  RxFrame frames_[DECODER_MAX_FRAMES];     // Newest frame per layout slot
+  bool queued_[DECODER_MAX_FRAMES];
+  uint8_t order_[PRIORITY_CLASSES][DECODER_MAX_FRAMES];
+  uint8_t count_[PRIORITY_CLASSES];
+};
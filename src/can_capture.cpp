@@ -0,0 +1,95 @@
+// Link G4X Monitor - Raw frame capture ring (LOG_FULL)
+#include "can_capture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#endif
+
+const char* canCapturePolicyName(CANCapturePolicy policy) {
+  return policy == CAPTURE_KEEP_OLDEST ? "KEEP OLDEST" : "KEEP NEWEST";
+}
+
+bool CANCaptureRing::allocate(uint32_t capacity) {
+  release();
+  if (capacity == 0) return false;
+
+#ifdef ARDUINO
+  records_ = (CANLogRecord*)heap_caps_malloc(capacity * sizeof(CANLogRecord), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+  if (!records_) records_ = (CANLogRecord*)malloc(capacity * sizeof(CANLogRecord));
+  if (!records_) return false;
+
+  capacity_ = capacity;
+  wrap_ = UINT32_MAX - UINT32_MAX % capacity;
+  head_.store(0, std::memory_order_relaxed);
+  tail_.store(0, std::memory_order_relaxed);
+  resetCounters();
+  return true;
+}
+
+void CANCaptureRing::release() {
+  free(records_);
+  records_ = nullptr;
+  capacity_ = 0;
+}
+
+bool CANCaptureRing::push(const RxFrame& frame) {
+  uint32_t head = head_.load(std::memory_order_relaxed);
+  uint32_t tail = tail_.load(std::memory_order_acquire);
+
+  while (distance(head, tail) >= capacity_) {
+    if (policy() == CAPTURE_KEEP_OLDEST) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    // Discard the oldest record; a failed exchange means the consumer
+    // took it first, and tail now holds its new position
+    if (tail_.compare_exchange_weak(tail, advance(tail, 1), std::memory_order_acq_rel, std::memory_order_acquire)) {
+      overwritten_.fetch_add(1, std::memory_order_relaxed);
+      tail = advance(tail, 1);
+    }
+  }
+
+  // Sizes come from the LOGGING tab and are not powers of two
+  packLogRecord(frame, records_[head % capacity_]);
+  head = advance(head, 1);
+  head_.store(head, std::memory_order_release);
+  captured_.fetch_add(1, std::memory_order_relaxed);
+
+  uint32_t depth = distance(head, tail);
+  if (depth > peak_depth_.load(std::memory_order_relaxed)) {
+    peak_depth_.store(depth, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+uint32_t CANCaptureRing::pop(CANLogRecord* out, uint32_t max) {
+  uint32_t tail = tail_.load(std::memory_order_acquire);
+  for (;;) {
+    uint32_t head = head_.load(std::memory_order_acquire);
+    uint32_t count = distance(head, tail);
+    if (count > max) count = max;
+    if (count == 0) return 0;
+
+    uint32_t slot = tail % capacity_;
+    uint32_t first = count < capacity_ - slot ? count : capacity_ - slot;
+    memcpy(out, &records_[slot], first * sizeof(CANLogRecord));
+    memcpy(out + first, records_, (count - first) * sizeof(CANLogRecord));
+
+    // The producer only overwrites a record after moving the tail past
+    // it, so a successful exchange means every copied record was intact
+    if (tail_.compare_exchange_strong(tail, advance(tail, count), std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return count;
+    }
+  }
+}
+
+void CANCaptureRing::resetCounters() {
+  peak_depth_.store(0, std::memory_order_relaxed);
+  captured_.store(0, std::memory_order_relaxed);
+  dropped_.store(0, std::memory_order_relaxed);
+  overwritten_.store(0, std::memory_order_relaxed);
+}
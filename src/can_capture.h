@@ -0,0 +1,116 @@
+// Link G4X Monitor - Raw frame capture ring (LOG_FULL)
+//
+// In LOG_FULL mode the CAN receive task copies every frame it takes from
+// the driver into this ring as one fixed 16-byte record: no allocation,
+// no formatting, one plain copy and one counter store per frame. Whatever
+// turns records into files or text (the serial "capture dump" command)
+// drains the ring from another task. The records are allocated once, in
+// PSRAM on the Tab5, sized by the LOGGING tab's buffer size, and only
+// resized while the receive task is stopped.
+//
+// When the ring is full the overflow policy decides what is lost:
+//   CAPTURE_KEEP_NEWEST  the oldest record is discarded (flight recorder:
+//                        the ring always holds the last N frames)
+//   CAPTURE_KEEP_OLDEST  the new frame is dropped, so a consumer that is
+//                        writing a file sees a gap-free stream up to the
+//                        point it fell behind
+// Both are counted separately so the LOGGING tab can show which happened.
+//
+// One producer and one consumer. Positions are free-running counters;
+// KEEP_NEWEST lets the producer advance the tail, so the consumer claims
+// what it copied with a compare-exchange and retries if the producer
+// overwrote it meanwhile.
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "can_ring.h"
+
+#define CAN_LOG_EXTENDED 0x80000000u   // id_flags: 29-bit identifier
+#define CAN_LOG_ID_MASK 0x1FFFFFFFu
+#define CAN_LOG_DLC_MASK 0xFu          // time_dlc: DLC in the low 4 bits
+
+// One captured frame. micros() keeps its full 71-minute range at 16us
+// resolution, finer than the shortest frame on a 1Mbps bus (~47us).
+struct CANLogRecord {
+  uint32_t time_dlc;   // Bits 4-31: arrival time (micros()), bits 0-3: DLC
+  uint32_t id_flags;   // Bits 0-28: identifier, bit 31: CAN_LOG_EXTENDED
+  uint8_t data[8];
+
+  uint32_t timestampUs() const { return time_dlc & ~CAN_LOG_DLC_MASK; }
+  uint8_t length() const { return time_dlc & CAN_LOG_DLC_MASK; }
+  uint32_t identifier() const { return id_flags & CAN_LOG_ID_MASK; }
+  bool extended() const { return (id_flags & CAN_LOG_EXTENDED) != 0; }
+};
+static_assert(sizeof(CANLogRecord) == 16, "CANLogRecord must stay 16 bytes");
+
+inline void packLogRecord(const RxFrame& frame, CANLogRecord& record) {
+  record.time_dlc = (frame.timestamp_us & ~CAN_LOG_DLC_MASK) | (frame.data_length & CAN_LOG_DLC_MASK);
+  record.id_flags = (frame.identifier & CAN_LOG_ID_MASK) | (frame.extended ? CAN_LOG_EXTENDED : 0);
+  memcpy(record.data, frame.data, 8);
+}
+
+enum CANCapturePolicy : uint8_t {
+  CAPTURE_KEEP_NEWEST = 0,
+  CAPTURE_KEEP_OLDEST = 1
+};
+
+const char* canCapturePolicyName(CANCapturePolicy policy);
+
+class CANCaptureRing {
+public:
+  ~CANCaptureRing() { release(); }
+
+  // Allocate room for capacity records and empty the ring. Neither may
+  // run while push() or pop() can be called.
+  bool allocate(uint32_t capacity);
+  void release();
+
+  bool allocated() const { return records_ != nullptr; }
+  uint32_t capacity() const { return capacity_; }
+
+  void setPolicy(CANCapturePolicy policy) { policy_.store(policy, std::memory_order_relaxed); }
+  CANCapturePolicy policy() const { return (CANCapturePolicy)policy_.load(std::memory_order_relaxed); }
+
+  // Producer side (the receive task). Returns false if the frame was
+  // dropped; under KEEP_NEWEST it is always stored.
+  bool push(const RxFrame& frame);
+
+  // Consumer side: copy up to max records, oldest first, and remove them.
+  // Returns the number copied.
+  uint32_t pop(CANLogRecord* out, uint32_t max);
+
+  uint32_t depth() const {
+    return distance(head_.load(std::memory_order_acquire), tail_.load(std::memory_order_acquire));
+  }
+  uint32_t peakDepth() const { return peak_depth_.load(std::memory_order_relaxed); }
+  uint32_t capturedFrames() const { return captured_.load(std::memory_order_relaxed); }
+  uint32_t droppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+  uint32_t overwrittenFrames() const { return overwritten_.load(std::memory_order_relaxed); }
+
+  // Counters only - queued records are left alone
+  void resetCounters();
+
+private:
+  // Positions wrap at wrap_, the largest multiple of the capacity a
+  // uint32_t holds, rather than at 2^32: sizes are not powers of two, so
+  // wrapping there would move the slot of every queued record. Wrapping
+  // this late keeps a stale tail from ever matching again in a pop().
+  uint32_t advance(uint32_t position, uint32_t count) const {
+    return count < wrap_ - position ? position + count : count - (wrap_ - position);
+  }
+  uint32_t distance(uint32_t head, uint32_t tail) const {
+    return head >= tail ? head - tail : head + (wrap_ - tail);
+  }
+
+  CANLogRecord* records_ = nullptr;
+  uint32_t capacity_ = 0;
+  uint32_t wrap_ = 0;
+  std::atomic<uint8_t> policy_{CAPTURE_KEEP_NEWEST};
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> peak_depth_{0};
+  std::atomic<uint32_t> captured_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> overwritten_{0};
+};
@@ -0,0 +1,113 @@
+// Link G4X Monitor - Crash-consistent binary log blocks
+#include "can_log_format.h"
+
+#include <string.h>
+
+// ========== CRC-32 ==========
+struct CRC32Table {
+  uint32_t entries[256];
+
+  constexpr CRC32Table() : entries() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+      entries[i] = crc;
+    }
+  }
+};
+
+static constexpr CRC32Table CRC32_TABLE;
+
+uint32_t canLogCrc32(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) crc = CRC32_TABLE.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+// ========== BLOCKS ==========
+void sealLogBlock(uint8_t* block, CANLogContent content, uint32_t session, uint32_t sequence, uint32_t file_index,
+                  uint32_t record_count) {
+  CANLogBlockHeader header = {};
+  header.magic = CAN_LOG_MAGIC;
+  header.version = CAN_LOG_VERSION;
+  header.record_bytes = canLogRecordBytes(content);
+  header.session = session;
+  header.sequence = sequence;
+  header.file_index = file_index;
+  header.record_count = record_count;
+  header.content = content;
+  memcpy(block, &header, sizeof(header));
+
+  // Padding is zeroed so a block's CRC never depends on stale buffer data
+  uint32_t used = record_count * header.record_bytes;
+  memset(logBlockPayload(block) + used, 0, CAN_LOG_BLOCK_PAYLOAD - used);
+
+  header.crc = canLogCrc32(0, block, CAN_LOG_BLOCK_BYTES);
+  memcpy(block + offsetof(CANLogBlockHeader, crc), &header.crc, sizeof(header.crc));
+}
+
+const char* canLogBlockStatusName(CANLogBlockStatus status) {
+  switch (status) {
+    case LOG_BLOCK_OK: return "ok";
+    case LOG_BLOCK_END: return "end of file";
+    case LOG_BLOCK_TORN: return "torn block";
+    case LOG_BLOCK_UNWRITTEN: return "unwritten space";
+    case LOG_BLOCK_STALE: return "stale block";
+    default: return "unknown";
+  }
+}
+
+void CANLogBlockReader::begin(CANReplayReadFn read, void* context) {
+  read_ = read;
+  context_ = context;
+  first_ = {};
+  blocks_ = 0;
+  records_ = 0;
+  stopped_ = false;
+}
+
+CANLogBlockStatus CANLogBlockReader::next(uint8_t* block) {
+  if (stopped_) return LOG_BLOCK_END;
+
+  size_t length = 0;
+  while (length < CAN_LOG_BLOCK_BYTES) {
+    size_t got = read_(context_, (char*)block + length, CAN_LOG_BLOCK_BYTES - length);
+    if (got == 0) break;
+    length += got;
+  }
+
+  CANLogBlockStatus status = LOG_BLOCK_OK;
+  CANLogBlockHeader header;
+  memcpy(&header, block, sizeof(header));
+  if (length == 0) {
+    status = LOG_BLOCK_END;
+  } else if (length < CAN_LOG_BLOCK_BYTES) {
+    status = LOG_BLOCK_TORN;
+  } else if (header.magic != CAN_LOG_MAGIC || header.version != CAN_LOG_VERSION ||
+             header.content > CAN_LOG_CONTENT_SESSION ||
+             header.record_bytes != canLogRecordBytes((CANLogContent)header.content)) {
+    status = LOG_BLOCK_UNWRITTEN;
+  } else {
+    uint32_t crc = header.crc;
+    memset(block + offsetof(CANLogBlockHeader, crc), 0, sizeof(header.crc));
+    bool intact = canLogCrc32(0, block, CAN_LOG_BLOCK_BYTES) == crc &&
+                  header.record_count <= CAN_LOG_BLOCK_PAYLOAD / header.record_bytes;
+    memcpy(block + offsetof(CANLogBlockHeader, crc), &crc, sizeof(crc));
+
+    if (!intact) {
+      status = LOG_BLOCK_TORN;
+    } else if (blocks_ && (header.session != first_.session || header.file_index != first_.file_index ||
+                           header.content != first_.content || header.sequence != first_.sequence + blocks_)) {
+      status = LOG_BLOCK_STALE;
+    }
+  }
+
+  if (status != LOG_BLOCK_OK) {
+    stopped_ = true;
+    return status;
+  }
+  if (blocks_ == 0) first_ = header;
+  blocks_++;
+  records_ += header.record_count;
+  return LOG_BLOCK_OK;
+}
@@ -0,0 +1,116 @@
+// Link G4X Monitor - Crash-consistent binary log blocks
+//
+// A log file is a run of fixed-size blocks, each a header followed by a
+// payload and zero padding. The payload is either up to
+// CAN_LOG_BLOCK_RECORDS CANLogRecords (LOG_FULL) or a byte stream:
+// encoded signal changes (LOG_CHANGES, signal_changes.h) or session
+// chunks and index (LOG_SESSION, session_log.h). The header names what
+// the payload holds, the session (a random number per writer start), the
+// block's sequence number within it (continuing across files), the file
+// it was written to and how many records or bytes it holds, and ends with
+// a CRC-32 over the whole block.
+//
+// Files are preallocated to their full size when they are opened, so a
+// block write never changes FAT metadata and nothing needs syncing per
+// write: a power cut at key-off loses at most the block being written.
+// A reader walks the blocks from the start of the file and keeps every
+// one up to the first that is torn (CRC), unwritten (magic), or left over
+// from an older file whose clusters the preallocation reused (session,
+// sequence or file number out of line).
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "can_capture.h"
+#include "can_replay.h"
+
+#define CAN_LOG_MAGIC 0x4C583447u     // "G4XL"
+#define CAN_LOG_VERSION 1
+#define CAN_LOG_BLOCK_BYTES 16384     // Whole block, header included
+#define CAN_LOG_BLOCK_PAYLOAD (CAN_LOG_BLOCK_BYTES - sizeof(CANLogBlockHeader))
+#define CAN_LOG_BLOCK_RECORDS (CAN_LOG_BLOCK_PAYLOAD / sizeof(CANLogRecord))
+
+// What a block's payload holds
+enum CANLogContent : uint32_t {
+  CAN_LOG_CONTENT_FRAMES = 0,    // CANLogRecords
+  CAN_LOG_CONTENT_CHANGES = 1,   // Signal change groups, one byte per record
+  CAN_LOG_CONTENT_SESSION = 2    // Session chunks and index, one byte per record
+};
+
+struct CANLogBlockHeader {
+  uint32_t magic;            // CAN_LOG_MAGIC
+  uint16_t version;          // CAN_LOG_VERSION
+  uint16_t record_bytes;     // canLogRecordBytes(content)
+  uint32_t session;
+  uint32_t sequence;         // 0 for the session's first block
+  uint32_t file_index;
+  uint32_t record_count;
+  uint32_t content;          // CANLogContent
+  uint32_t crc;              // CRC-32 of the block with this field zero
+};
+static_assert(sizeof(CANLogBlockHeader) == 32, "CANLogBlockHeader must stay 32 bytes");
+static_assert(CAN_LOG_BLOCK_BYTES % sizeof(CANLogRecord) == 0, "Blocks must hold whole records");
+
+// CRC-32 (IEEE 802.3, as zlib crc32()); crc is the running value, 0 to start
+uint32_t canLogCrc32(uint32_t crc, const uint8_t* data, size_t length);
+
+inline uint16_t canLogRecordBytes(CANLogContent content) {
+  return content == CAN_LOG_CONTENT_FRAMES ? sizeof(CANLogRecord) : 1;
+}
+
+// Fill in the header of a block whose payload is in place, zero the
+// unused payload space and set the CRC
+void sealLogBlock(uint8_t* block, CANLogContent content, uint32_t session, uint32_t sequence, uint32_t file_index,
+                  uint32_t record_count);
+
+inline uint8_t* logBlockPayload(uint8_t* block) {
+  return block + sizeof(CANLogBlockHeader);
+}
+
+inline const uint8_t* logBlockPayload(const uint8_t* block) {
+  return block + sizeof(CANLogBlockHeader);
+}
+
+inline CANLogRecord* logBlockRecords(uint8_t* block) {
+  return (CANLogRecord*)(block + sizeof(CANLogBlockHeader));
+}
+
+inline const CANLogRecord* logBlockRecords(const uint8_t* block) {
+  return (const CANLogRecord*)(block + sizeof(CANLogBlockHeader));
+}
+
+// Why a read stopped
+enum CANLogBlockStatus : uint8_t {
+  LOG_BLOCK_OK,
+  LOG_BLOCK_END,          // End of file
+  LOG_BLOCK_TORN,         // CRC mismatch or a short block: the write in flight at power loss
+  LOG_BLOCK_UNWRITTEN,    // No header: preallocated space never written
+  LOG_BLOCK_STALE         // Valid, but another session's or out of sequence
+};
+
+const char* canLogBlockStatusName(CANLogBlockStatus status);
+
+// Reads a log file block by block through the same read callback as
+// replay, into a block buffer the caller owns
+class CANLogBlockReader {
+public:
+  void begin(CANReplayReadFn read, void* context);
+
+  // Read and check the next block. Once it returns anything but
+  // LOG_BLOCK_OK the rest of the file is not part of the log.
+  CANLogBlockStatus next(uint8_t* block);
+
+  // The first block's header, valid after one LOG_BLOCK_OK. Every later
+  // block has the same content, session and file.
+  const CANLogBlockHeader& first() const { return first_; }
+  uint32_t blockCount() const { return blocks_; }
+  uint32_t recordCount() const { return records_; }
+
+private:
+  CANReplayReadFn read_ = nullptr;
+  void* context_ = nullptr;
+  CANLogBlockHeader first_ = {};
+  uint32_t blocks_ = 0;
+  uint32_t records_ = 0;
+  bool stopped_ = true;
+};
@@ -0,0 +1,184 @@
+// Link G4X Monitor - Background CAN log writer
+#include "can_log_writer.h"
+
+#include <stdlib.h>
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#endif
+
+bool CANLogWriter::allocate() {
+  if (allocated()) return true;
+
+  size_t bytes = 2 * CAN_LOG_BLOCK_BYTES;
+#ifdef ARDUINO
+  // The SD driver copies PSRAM buffers through a bounce buffer; prefer
+  // memory it can DMA from directly
+  blocks_ = (uint8_t*)heap_caps_aligned_alloc(CAN_LOG_BLOCK_ALIGN, bytes, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+  if (!blocks_) {
+    blocks_ = (uint8_t*)heap_caps_aligned_alloc(CAN_LOG_BLOCK_ALIGN, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  }
+#else
+  blocks_ = (uint8_t*)aligned_alloc(CAN_LOG_BLOCK_ALIGN, bytes);
+#endif
+  return blocks_ != nullptr;
+}
+
+void CANLogWriter::release() {
+  free(blocks_);
+  blocks_ = nullptr;
+}
+
+void CANLogWriter::begin(LogFileSink* sink, LogClockFn clock, CANLogContent content, uint32_t session,
+                         uint32_t first_index, uint32_t max_file_bytes, uint32_t max_files) {
+  for (uint8_t i = 0; i < 2; i++) state_[i].store(BLOCK_FREE, std::memory_order_relaxed);
+  content_ = content;
+  fill_index_ = write_index_ = 0;
+  fill_count_ = 0;
+  flush_ms_ = content == CAN_LOG_CONTENT_FRAMES ? CAN_LOG_FLUSH_MS : CAN_LOG_CHANGES_FLUSH_MS;
+  filled_blocks_ = 0;
+  fill_stalls_.store(0, std::memory_order_relaxed);
+  stalled_ = false;
+
+  sink_ = sink;
+  clock_ = clock;
+  session_ = session;
+  sequence_ = 0;
+  first_index_ = next_index_ = first_index;
+  file_bytes_limit_ = max_file_bytes - max_file_bytes % CAN_LOG_BLOCK_BYTES;
+  if (file_bytes_limit_ == 0) file_bytes_limit_ = CAN_LOG_BLOCK_BYTES;
+  max_files_ = max_files ? max_files : 1;
+  file_open_ = false;
+  stats_ = {};
+  stats_snapshot_.publish(stats_);
+}
+
+void CANLogWriter::fill(CANCaptureRing& ring, uint32_t now_ms, bool flush) {
+  for (;;) {
+    uint8_t i = fill_index_;
+    if (state_[i].load(std::memory_order_acquire) != BLOCK_FREE) {
+      // Both blocks queued behind a slow write; the capture ring holds on
+      if (ring.depth()) noteStall();
+      return;
+    }
+    stalled_ = false;
+
+    if (fill_count_ == 0) fill_started_ms_ = now_ms;
+    CANLogRecord* records = logBlockRecords(blocks_ + i * CAN_LOG_BLOCK_BYTES);
+    fill_count_ += ring.pop(records + fill_count_, CAN_LOG_BLOCK_RECORDS - fill_count_);
+
+    bool full = fill_count_ == CAN_LOG_BLOCK_RECORDS;
+    bool due = fill_count_ && (flush || now_ms - fill_started_ms_ >= flush_ms_);
+    if (!full && !due) return;
+
+    handOver();
+    if (!full) return;
+  }
+}
+
+uint8_t* CANLogWriter::reserve(size_t length, uint32_t now_ms, bool& fresh) {
+  if (fill_count_ && (fill_count_ + length > CAN_LOG_BLOCK_PAYLOAD || now_ms - fill_started_ms_ >= flush_ms_)) {
+    handOver();
+  }
+
+  uint8_t i = fill_index_;
+  if (state_[i].load(std::memory_order_acquire) != BLOCK_FREE) {
+    noteStall();
+    return nullptr;
+  }
+  stalled_ = false;
+
+  fresh = fill_count_ == 0;
+  if (fresh) fill_started_ms_ = now_ms;
+  return logBlockPayload(blocks_ + i * CAN_LOG_BLOCK_BYTES) + fill_count_;
+}
+
+// Once per stall, however many polls it lasts
+void CANLogWriter::noteStall() {
+  if (stalled_) return;
+  stalled_ = true;
+  fill_stalls_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CANLogWriter::flush() {
+  if (fill_count_) handOver();
+}
+
+// Only a free block is ever filled; it goes to the writer as is
+void CANLogWriter::handOver() {
+  uint8_t i = fill_index_;
+  block_records_[i] = fill_count_;
+  state_[i].store(BLOCK_READY, std::memory_order_release);
+  fill_index_ ^= 1;
+  fill_count_ = 0;
+  filled_blocks_++;
+}
+
+void CANLogWriter::openNext() {
+  if (next_index_ >= max_files_) {
+    uint32_t oldest = next_index_ - max_files_;
+    if (content_ != CAN_LOG_CONTENT_SESSION || oldest < first_index_) sink_->remove(oldest);
+  }
+
+  uint32_t start_us = clock_();
+  file_open_ = sink_->open(next_index_, file_bytes_limit_);
+  uint32_t elapsed_us = clock_() - start_us;
+  if (elapsed_us > stats_.worst_open_us) stats_.worst_open_us = elapsed_us;
+
+  if (file_open_) {
+    stats_.files_opened++;
+    stats_.file_index = next_index_;
+    stats_.file_bytes = 0;
+  }
+  next_index_++;
+}
+
+bool CANLogWriter::writeReady() {
+  uint8_t i = write_index_;
+  if (state_[i].load(std::memory_order_acquire) != BLOCK_READY) return false;
+
+  // Blocks are written whole, so a full file holds exactly the limit
+  if (file_open_ && stats_.file_bytes + CAN_LOG_BLOCK_BYTES > file_bytes_limit_) {
+    sink_->close(stats_.file_bytes);
+    file_open_ = false;
+  }
+  if (!file_open_) openNext();
+
+  uint8_t* block = blocks_ + i * CAN_LOG_BLOCK_BYTES;
+  sealLogBlock(block, content_, session_, sequence_, stats_.file_index, block_records_[i]);
+
+  uint32_t start_us = clock_();
+  bool written = file_open_ && sink_->write(block, CAN_LOG_BLOCK_BYTES);
+  uint32_t elapsed_us = clock_() - start_us;
+
+  if (written) {
+    sequence_++;
+    stats_.bytes_written += CAN_LOG_BLOCK_BYTES;
+    stats_.write_us += elapsed_us;
+    stats_.file_bytes += CAN_LOG_BLOCK_BYTES;
+    stats_.blocks_written++;
+    if (elapsed_us > stats_.worst_write_us) stats_.worst_write_us = elapsed_us;
+  } else {
+    // Start a fresh file with the next block rather than write past a
+    // block a reader would stop at
+    stats_.write_errors++;
+    stats_.records_lost += block_records_[i];
+    if (file_open_) sink_->close(stats_.file_bytes);
+    file_open_ = false;
+  }
+  stats_snapshot_.publish(stats_);
+
+  state_[i].store(BLOCK_FREE, std::memory_order_release);
+  write_index_ ^= 1;
+  return true;
+}
+
+void CANLogWriter::end() {
+  if (file_open_) sink_->close(stats_.file_bytes);
+  file_open_ = false;
+}
+
+bool CANLogWriter::idle() const {
+  return state_[0].load(std::memory_order_acquire) == BLOCK_FREE &&
+         state_[1].load(std::memory_order_acquire) == BLOCK_FREE;
+}
@@ -0,0 +1,164 @@
+// Link G4X Monitor - Background CAN log writer
+//
+// Moves LOG_FULL capture records (can_capture.h), LOG_CHANGES signal
+// change groups (signal_changes.h) or LOG_SESSION chunks (session_log.h)
+// to storage in large blocks. Two sector-aligned block buffers alternate:
+// the filler (loop() on the Tab5) copies records out of the capture ring,
+// or encodes signals, into one block while the writer task is inside a
+// possibly slow flash write with the other, so a card stall is absorbed
+// by the second block and the capture ring rather than by the receive
+// task. A partly filled block is handed over once it is CAN_LOG_FLUSH_MS
+// old so a quiet bus still reaches the card; encoded signals are small
+// enough that their blocks wait CAN_LOG_CHANGES_FLUSH_MS rather than go
+// out mostly padding.
+//
+// Every block is sealed (can_log_format.h) and written whole, partial or
+// not, into a file preallocated to the size limit, so a file is a run of
+// self-checking fixed-size blocks that survives a power cut up to the
+// last complete one. A file closed early is cut back to its last block.
+// The writer moves on to a new file when the current one is full, and
+// removes the file max_files back each time it opens one - unless, for
+// LOG_SESSION, that file is part of the running session, whose index
+// points back to its first file. Files are
+// numbered; LogFileSink maps a number to a file on the SD card (or
+// anywhere else) and does the I/O.
+//
+// Statistics - card throughput while writing, the longest single write,
+// how often the filler found both blocks busy - are published through a
+// SeqLock for the LOGGING tab.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "can_capture.h"
+#include "can_log_format.h"
+#include "seqlock.h"
+
+#define CAN_LOG_BLOCK_ALIGN 512     // SD sector
+#define CAN_LOG_FLUSH_MS 1000       // Oldest record a partial block may hold
+#define CAN_LOG_CHANGES_FLUSH_MS 30000   // The same for changes and session chunks
+
+// File I/O for the writer, used only from the writer task
+class LogFileSink {
+public:
+  virtual ~LogFileSink() {}
+
+  // Create (or truncate) log file number index, allocate its full size
+  // up front and make it current; writes then fill it from the start
+  virtual bool open(uint32_t index, uint32_t preallocate_bytes) = 0;
+  virtual bool write(const uint8_t* data, size_t length) = 0;
+  // Close the current file, of which written_bytes were written: the
+  // preallocated space after them can be given back
+  virtual void close(uint32_t written_bytes) = 0;
+  // Delete log file number index if it exists
+  virtual void remove(uint32_t index) = 0;
+};
+
+// Microsecond clock for write timing
+typedef uint32_t (*LogClockFn)();
+
+struct CANLogWriterStats {
+  uint64_t bytes_written;
+  uint64_t write_us;          // Time spent inside LogFileSink::write()
+  uint32_t blocks_written;
+  uint32_t worst_write_us;    // Longest single block write
+  uint32_t worst_open_us;     // Longest file open, preallocation included
+  uint32_t files_opened;
+  uint32_t file_index;        // Current file number
+  uint32_t file_bytes;        // Size of the current file
+  uint32_t write_errors;
+  uint32_t records_lost;      // In blocks that failed to write (bytes for changes)
+
+  // Card throughput while writing, MB/s
+  float writeRate() const { return write_us ? (float)bytes_written / write_us : 0.0f; }
+};
+
+class CANLogWriter {
+public:
+  ~CANLogWriter() { release(); }
+
+  // The two block buffers; internal DMA-capable RAM on the Tab5
+  bool allocate();
+  void release();
+  bool allocated() const { return blocks_ != nullptr; }
+
+  // Start a session of content blocks writing to file first_index
+  // onwards; files hold as many whole blocks as fit in max_file_bytes.
+  // session tells this run's blocks from any an earlier one left in
+  // reused clusters. Neither side may be running.
+  void begin(LogFileSink* sink, LogClockFn clock, CANLogContent content, uint32_t session, uint32_t first_index,
+             uint32_t max_file_bytes, uint32_t max_files);
+
+  // Filler side (one task), CAN_LOG_CONTENT_FRAMES: copy records from
+  // ring into the block being filled and hand full blocks - and partial
+  // ones once they are CAN_LOG_FLUSH_MS old, or at once with flush - to
+  // the writer.
+  void fill(CANCaptureRing& ring, uint32_t now_ms, bool flush = false);
+
+  // Filler side, byte stream contents: room for length more payload
+  // bytes, handing the current block over first if they would not fit or
+  // it is due. nullptr while both blocks wait for the writer. fresh is set
+  // when the bytes start a block, which must then decode on its own.
+  // commit() the bytes actually used, up to length.
+  uint8_t* reserve(size_t length, uint32_t now_ms, bool& fresh);
+  void commit(size_t length) { fill_count_ += length; }
+  // Hand over a partial block now (any content)
+  void flush();
+  // Where the next reserved bytes land: the block's sequence number and
+  // payload offset. The block lands in file first_index + sequence /
+  // blocksPerFile() only while every write succeeds (write_errors == 0):
+  // a failed block is not numbered, and the next one starts a new file.
+  uint32_t fillSequence() const { return filled_blocks_; }
+  uint32_t fillOffset() const { return fill_count_; }
+  uint32_t blocksPerFile() const { return file_bytes_limit_ / CAN_LOG_BLOCK_BYTES; }
+
+  // Writer side (one task): write the next handed-over block, rotating
+  // files as needed. Returns false if there was nothing to write.
+  bool writeReady();
+  // Close the current file; after the last writeReady()
+  void end();
+
+  // Both blocks written: a flush now hands over everything popped
+  bool idle() const;
+
+  // Times the filler ran into both blocks still waiting for the writer,
+  // each counted once however long it lasted
+  uint32_t fillStalls() const { return fill_stalls_.load(std::memory_order_relaxed); }
+  void readStats(CANLogWriterStats& stats) const { stats_snapshot_.read(stats); }
+
+private:
+  enum BlockState : uint8_t { BLOCK_FREE, BLOCK_READY };
+
+  void handOver();
+  void noteStall();
+  void openNext();
+
+  uint8_t* blocks_ = nullptr;                // [2][CAN_LOG_BLOCK_BYTES]
+  std::atomic<uint8_t> state_[2] = {{BLOCK_FREE}, {BLOCK_FREE}};
+  uint32_t block_records_[2] = {0, 0};       // Set before BLOCK_READY
+  CANLogContent content_ = CAN_LOG_CONTENT_FRAMES;
+
+  // Filler side
+  uint8_t fill_index_ = 0;
+  uint32_t fill_count_ = 0;                  // Records, or bytes of changes
+  uint32_t flush_ms_ = CAN_LOG_FLUSH_MS;
+  uint32_t filled_blocks_ = 0;
+  uint32_t fill_started_ms_ = 0;
+  std::atomic<uint32_t> fill_stalls_{0};
+  bool stalled_ = false;
+
+  // Writer side
+  uint8_t write_index_ = 0;
+  LogFileSink* sink_ = nullptr;
+  LogClockFn clock_ = nullptr;
+  uint32_t session_ = 0;
+  uint32_t sequence_ = 0;
+  uint32_t first_index_ = 0;
+  uint32_t next_index_ = 0;
+  uint32_t file_bytes_limit_ = 0;            // Whole blocks
+  uint32_t max_files_ = 0;
+  bool file_open_ = false;
+  CANLogWriterStats stats_ = {};
+  SeqLock<CANLogWriterStats> stats_snapshot_;
+};
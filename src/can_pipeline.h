@@ -0,0 +1,108 @@
+// Link G4X Monitor - CAN receive pipeline
+//
+// The per-frame work behind readCANData(): per-ID statistics, bus load
+// and signal decoding, applied to one set of components. The firmware
+// and the native host build both feed frames through here, so what is
+// measured on a workstation is the code that runs on the Tab5.
+// Everything specific to the dashboard (acceptance filter counters, the
+// 0x502 command echo, speed estimation) stays with the caller.
+//
+// Frames are either processed in arrival order (process()) or, when the
+// caller is behind, deferred into a CANBacklog and decoded newest-only in
+// priority order at flushDeferred(). Decoded and superseded frames are
+// counted per priority class either way, and every frame that fits its
+// layout counts towards the layout's period, decoded or superseded, so a
+// backlog does not stretch the staleness timeouts.
+#pragma once
+
+#include <stdint.h>
+#include "bus_load.h"
+#include "can_backlog.h"
+#include "can_ring.h"
+#include "can_stats.h"
+#include "ecu_data.h"
+#include "signal_decoder.h"
+
+struct CANDecodeCounters {
+  uint32_t processed[PRIORITY_CLASSES];    // Frames decoded (not those too short for their layout)
+  uint32_t superseded[PRIORITY_CLASSES];   // Frames replaced in the backlog by a newer one
+  uint32_t backlog_batches;                // Batches decoded in priority order
+};
+
+class CANPipeline {
+public:
+  CANPipeline(CANStatsTable& stats, BusLoadMeter& bus_load, SignalDecoder& decoder, ECUData& data)
+    : stats_(stats), bus_load_(bus_load), decoder_(decoder), data_(data) {
+    resetCounters();
+  }
+
+  // One frame. now_ms/now_us are taken once per batch.
+  void process(const RxFrame& frame, uint32_t now_ms, uint32_t now_us) {
+    account(frame, now_ms);
+    uint8_t slot = slotFor(frame);
+    if (slot == SignalDecoder::NO_FRAME) return;
+
+    if (decoder_.decodeSlot(slot, frame.data, frame.data_length, data_, arrivalMs(frame, now_ms, now_us))) {
+      counters_.processed[decoder_.slotPriority(slot)]++;
+    }
+  }
+
+  // Under backlog: count the frame now and queue its decode for
+  // flushDeferred(), where only the newest frame per layout is decoded
+  void defer(const RxFrame& frame, uint32_t now_ms, uint32_t now_us) {
+    account(frame, now_ms);
+    uint8_t slot = slotFor(frame);
+    if (slot == SignalDecoder::NO_FRAME || !decoder_.fitsSlot(slot, frame.data_length)) return;
+
+    decoder_.trackPeriod(slot, arrivalMs(frame, now_ms, now_us));
+    FramePriority priority = decoder_.slotPriority(slot);
+    if (backlog_.add(slot, priority, frame)) counters_.superseded[priority]++;
+  }
+
+  // Decode the deferred frames, critical class first, calling
+  // decoded(frame) after each
+  template <typename Fn>
+  void flushDeferred(uint32_t now_ms, uint32_t now_us, Fn&& decoded) {
+    if (backlog_.drain([&](uint8_t slot, FramePriority priority, const RxFrame& frame) {
+          decoder_.decodeSlotSignals(slot, frame.data, frame.data_length, data_, arrivalMs(frame, now_ms, now_us));
+          counters_.processed[priority]++;
+          decoded(frame);
+        })) {
+      counters_.backlog_batches++;
+    }
+  }
+
+  // After each batch, even an empty one: close bus load slots and expire
+  // signals whose frames stopped
+  void finishBatch(uint32_t now_ms, uint32_t now_us) {
+    bus_load_.advance(now_us);
+    decoder_.refreshValidity(data_, now_ms);
+  }
+
+  const CANDecodeCounters& counters() const { return counters_; }
+  void resetCounters() { counters_ = {}; }
+
+private:
+  void account(const RxFrame& frame, uint32_t now_ms) {
+    stats_.update(frame, now_ms);
+    bus_load_.addFrame(frame.extended, frame.data_length, frame.timestamp_us);
+  }
+
+  uint8_t slotFor(const RxFrame& frame) const {
+    if (frame.extended) return SignalDecoder::NO_FRAME;
+    return decoder_.slotFor(frame.identifier, frame.data, frame.data_length);
+  }
+
+  // Signals are stamped with the frame's arrival, not when the batch got
+  // to it
+  static uint32_t arrivalMs(const RxFrame& frame, uint32_t now_ms, uint32_t now_us) {
+    return now_ms - (now_us - frame.timestamp_us) / 1000;
+  }
+
+  CANStatsTable& stats_;
+  BusLoadMeter& bus_load_;
+  SignalDecoder& decoder_;
+  ECUData& data_;
+  CANBacklog backlog_;
+  CANDecodeCounters counters_;
+};
@@ -0,0 +1,245 @@
+// Link G4X Monitor - CAN log replay
+#include "can_replay.h"
+
+#include <string.h>
+
+static char* skipSpaces(char* p) {
+  while (*p == ' ' || *p == '\t') p++;
+  return p;
+}
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Hex number; digits = number of digits consumed (0 if none)
+static uint32_t parseHex(char*& p, int& digits) {
+  uint32_t value = 0;
+  digits = 0;
+  for (int d; (d = hexDigit(*p)) >= 0; p++) {
+    value = (value << 4) | d;
+    digits++;
+  }
+  return value;
+}
+
+static uint32_t parseDecimal(char*& p, int& digits) {
+  uint32_t value = 0;
+  digits = 0;
+  for (; *p >= '0' && *p <= '9'; p++) {
+    value = value * 10 + (*p - '0');
+    digits++;
+  }
+  return value;
+}
+
+// "seconds.fraction" to microseconds without floating point
+static bool parseSeconds(char*& p, uint64_t& us) {
+  int digits;
+  uint64_t seconds = 0;
+  for (digits = 0; *p >= '0' && *p <= '9'; p++, digits++) seconds = seconds * 10 + (*p - '0');
+  if (digits == 0) return false;
+
+  uint32_t fraction = 0, scale = 1000000;
+  if (*p == '.') {
+    for (p++; *p >= '0' && *p <= '9'; p++) {
+      if (scale > 1) {
+        scale /= 10;
+        fraction += (*p - '0') * scale;
+      }
+    }
+  }
+  us = seconds * 1000000 + fraction;
+  return true;
+}
+
+// Up to 8 data bytes, either packed ("1122AB") or spaced ("11 22 AB")
+static bool parseData(char*& p, RxFrame& frame, bool spaced, uint8_t count) {
+  uint8_t n = 0;
+  memset(frame.data, 0, sizeof(frame.data));
+  while (n < count) {
+    if (spaced) p = skipSpaces(p);
+    int hi = hexDigit(p[0]);
+    int lo = hi >= 0 ? hexDigit(p[1]) : -1;
+    if (lo < 0) break;
+    if (n < 8) frame.data[n] = (uint8_t)((hi << 4) | lo);
+    n++;
+    p += 2;
+  }
+  if (n > 8) return false;   // CAN FD payload
+  frame.data_length = n;
+  return spaced ? n == count : true;
+}
+
+void CANLogReader::begin(CANReplayReadFn read, void* context) {
+  read_ = read;
+  context_ = context;
+  start_ = end_ = 0;
+  eof_ = false;
+  asc_hex_ = true;
+  format_ = CAN_LOG_UNKNOWN;
+  lines_ = skipped_ = 0;
+}
+
+bool CANLogReader::nextLine(char*& line) {
+  for (;;) {
+    char* newline = (char*)memchr(buffer_ + start_, '\n', end_ - start_);
+    if (newline) {
+      *newline = '\0';
+      line = buffer_ + start_;
+      start_ = newline + 1 - buffer_;
+      return true;
+    }
+
+    if (eof_) {
+      if (start_ == end_) return false;
+      // Last line without a newline
+      buffer_[end_] = '\0';
+      line = buffer_ + start_;
+      start_ = end_;
+      return true;
+    }
+
+    // Keep the partial line and refill behind it
+    if (start_ > 0) {
+      memmove(buffer_, buffer_ + start_, end_ - start_);
+      end_ -= start_;
+      start_ = 0;
+    }
+    if (end_ == CAN_REPLAY_BUFFER_SIZE) {
+      // Line longer than the buffer - drop it
+      skipped_++;
+      end_ = 0;
+    }
+    size_t n = read_(context_, buffer_ + end_, CAN_REPLAY_BUFFER_SIZE - end_);
+    if (n == 0) eof_ = true;
+    end_ += n;
+  }
+}
+
+bool CANLogReader::parseCandump(char* p, RxFrame& frame, uint64_t& log_us) {
+  p = skipSpaces(p + 1);   // Past '('
+  if (!parseSeconds(p, log_us) || *p != ')') return false;
+
+  // Interface name
+  p = skipSpaces(p + 1);
+  while (*p && *p != ' ' && *p != '\t') p++;
+  p = skipSpaces(p);
+
+  int digits;
+  uint32_t identifier = parseHex(p, digits);
+  if (digits == 0) return false;
+  frame.extended = digits > 3;
+  if (identifier & 0x20000000) return false;   // Error frame (CAN_ERR_FLAG)
+  frame.identifier = identifier & (frame.extended ? 0x1FFFFFFF : 0x7FF);
+
+  if (*p == '#') {
+    // -l: 123#11223344, 123#R (remote), 123##1... (CAN FD)
+    p++;
+    if (*p == '#' || *p == 'R' || *p == 'r') return false;
+    return parseData(p, frame, false, 64);
+  }
+
+  // -ta: 123   [4]  11 22 33 44
+  p = skipSpaces(p);
+  if (*p != '[') return false;
+  p++;
+  uint32_t length = parseDecimal(p, digits);
+  if (digits == 0 || *p != ']' || length > 8) return false;
+  p++;
+  if (strstr(p, "remote request")) return false;
+  return parseData(p, frame, true, (uint8_t)length);
+}
+
+bool CANLogReader::parseASC(char* p, RxFrame& frame, uint64_t& log_us) {
+  if (!parseSeconds(p, log_us) || (*p != ' ' && *p != '\t')) return false;
+
+  // Channel number, then the ID - anything else (CANFD, ErrorFrame,
+  // Statistic) is not a classic data frame
+  int digits;
+  p = skipSpaces(p);
+  parseDecimal(p, digits);
+  if (digits == 0) return false;
+  p = skipSpaces(p);
+
+  uint32_t identifier = asc_hex_ ? parseHex(p, digits) : parseDecimal(p, digits);
+  if (digits == 0) return false;
+  frame.extended = (*p == 'x' || *p == 'X');
+  if (frame.extended) p++;
+  frame.identifier = identifier & (frame.extended ? 0x1FFFFFFF : 0x7FF);
+
+  p = skipSpaces(p);
+  if (strncmp(p, "Rx", 2) != 0 && strncmp(p, "Tx", 2) != 0) return false;
+  p = skipSpaces(p + 2);
+  if (*p != 'd') return false;   // 'r' = remote frame
+  p = skipSpaces(p + 1);
+
+  uint32_t length = parseDecimal(p, digits);
+  if (digits == 0 || length > 8) return false;
+  return parseData(p, frame, true, (uint8_t)length);
+}
+
+bool CANLogReader::next(RxFrame& frame, uint64_t& log_us) {
+  char* line;
+  while (nextLine(line)) {
+    lines_++;
+    char* p = skipSpaces(line);
+    size_t length = strlen(p);
+    if (length && p[length - 1] == '\r') p[--length] = '\0';
+    if (length == 0) continue;
+
+    bool parsed = false;
+    if (*p == '(' && format_ != CAN_LOG_ASC) {
+      parsed = parseCandump(p, frame, log_us);
+      if (parsed) format_ = CAN_LOG_CANDUMP;
+    } else if (*p >= '0' && *p <= '9' && format_ != CAN_LOG_CANDUMP) {
+      parsed = parseASC(p, frame, log_us);
+      if (parsed) format_ = CAN_LOG_ASC;
+    } else if (strncmp(p, "base ", 5) == 0) {
+      asc_hex_ = strncmp(p + 5, "dec", 3) != 0;
+      format_ = CAN_LOG_ASC;
+      continue;
+    }
+
+    if (parsed) return true;
+    skipped_++;
+  }
+  return false;
+}
+
+void CANReplay::begin(CANReplayReadFn read, void* context, uint32_t speed_percent, uint32_t now_us) {
+  reader_.begin(read, context);
+  speed_percent_ = speed_percent;
+  start_us_ = now_us;
+  have_first_ = false;
+  pending_ = false;
+  finished_ = false;
+  frames_ = 0;
+}
+
+bool CANReplay::loadNext() {
+  if (finished_) return false;
+  if (!reader_.next(pending_frame_, pending_log_us_)) {
+    finished_ = true;
+    return false;
+  }
+
+  if (!have_first_) {
+    first_log_us_ = pending_log_us_;
+    have_first_ = true;
+  } else if (pending_log_us_ < first_log_us_) {
+    pending_log_us_ = first_log_us_;   // Out-of-order stamp: send at once
+  }
+  pending_ = true;
+  return true;
+}
+
+bool CANReplay::nextDue(uint32_t& due_us) {
+  if (speed_percent_ == CAN_REPLAY_SPEED_MAX) return false;
+  if (!pending_ && !loadNext()) return false;
+  due_us = dueTime(pending_log_us_);
+  return true;
+}
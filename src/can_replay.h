@@ -0,0 +1,120 @@
+// Link G4X Monitor - CAN log replay
+//
+// Streams a candump or Vector ASC log back as RxFrames, at the original
+// pace, N times faster, or as fast as the consumer takes them. Input is
+// pulled through a read callback into one fixed buffer and parsed in
+// place, so a replay never allocates, whatever the log size - a file on
+// the SD card and a FILE* on the host are both just a read function.
+//
+// Accepted lines (anything else is counted and skipped):
+//   candump -l      (1436509052.249713) can0 123#11223344
+//   candump -ta     (1436509052.249713)  can0  123   [4]  11 22 33 44
+//   ASC             1.234567 1  123x  Rx   d 4 11 22 33 44
+// Remote, error and CAN FD frames are skipped. IDs of more than three hex
+// digits (candump) or with an 'x' suffix (ASC) are 29-bit.
+//
+// Frames are stamped with the time they were due on the caller's
+// microsecond clock (or the delivery time at max speed), so statistics,
+// bus load and staleness see the log's timing scaled by the speed.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "can_ring.h"
+
+#define CAN_REPLAY_BUFFER_SIZE 4096   // Longest line that can be parsed, and read size
+#define CAN_REPLAY_SPEED_MAX 0        // speed_percent: no pacing
+#define CAN_REPLAY_SPEED_1X 100
+
+enum CANLogFormat : uint8_t {
+  CAN_LOG_UNKNOWN,
+  CAN_LOG_CANDUMP,
+  CAN_LOG_ASC
+};
+
+// Fill buffer with up to length bytes; 0 at end of input
+typedef size_t (*CANReplayReadFn)(void* context, char* buffer, size_t length);
+
+class CANLogReader {
+public:
+  void begin(CANReplayReadFn read, void* context);
+
+  // Next data frame and its log timestamp; false at end of input
+  bool next(RxFrame& frame, uint64_t& log_us);
+
+  CANLogFormat format() const { return format_; }
+  uint32_t lineCount() const { return lines_; }
+  uint32_t skippedLines() const { return skipped_; }
+
+private:
+  bool nextLine(char*& line);
+  bool parseCandump(char* line, RxFrame& frame, uint64_t& log_us);
+  bool parseASC(char* line, RxFrame& frame, uint64_t& log_us);
+
+  CANReplayReadFn read_ = nullptr;
+  void* context_ = nullptr;
+  char buffer_[CAN_REPLAY_BUFFER_SIZE + 1];
+  size_t start_ = 0;        // First unparsed byte
+  size_t end_ = 0;          // One past the last buffered byte
+  bool eof_ = true;
+  bool asc_hex_ = true;     // ASC "base hex" (default) or "base dec"
+  CANLogFormat format_ = CAN_LOG_UNKNOWN;
+  uint32_t lines_ = 0;
+  uint32_t skipped_ = 0;
+};
+
+class CANReplay {
+public:
+  // speed_percent: 100 = 1x, 1000 = 10x, CAN_REPLAY_SPEED_MAX = unpaced
+  void begin(CANReplayReadFn read, void* context, uint32_t speed_percent, uint32_t now_us);
+
+  // Hand every frame that is due by now_us to sink(const RxFrame&), at
+  // most max_frames. A sink returning false (consumer full) keeps that
+  // frame for the next call. Returns the number of frames delivered.
+  template <typename Sink>
+  uint32_t service(uint32_t now_us, uint32_t max_frames, Sink&& sink) {
+    uint32_t delivered = 0;
+    while (delivered < max_frames) {
+      if (!pending_ && !loadNext()) break;
+
+      if (speed_percent_ == CAN_REPLAY_SPEED_MAX) {
+        pending_frame_.timestamp_us = now_us;
+      } else {
+        uint32_t due = dueTime(pending_log_us_);
+        if ((int32_t)(now_us - due) < 0) break;
+        pending_frame_.timestamp_us = due;
+      }
+      if (!sink(pending_frame_)) break;
+
+      pending_ = false;
+      delivered++;
+    }
+    frames_ += delivered;
+    return delivered;
+  }
+
+  // When the next frame is due; false at end of log or when unpaced
+  bool nextDue(uint32_t& due_us);
+
+  bool finished() const { return finished_; }
+  uint32_t speedPercent() const { return speed_percent_; }
+  uint32_t frameCount() const { return frames_; }
+  const CANLogReader& reader() const { return reader_; }
+
+private:
+  bool loadNext();
+  uint32_t dueTime(uint64_t log_us) const {
+    return start_us_ + (uint32_t)((log_us - first_log_us_) * 100 / speed_percent_);
+  }
+
+  CANLogReader reader_;
+  uint32_t speed_percent_ = CAN_REPLAY_SPEED_1X;
+  uint32_t start_us_ = 0;
+  uint64_t first_log_us_ = 0;
+  bool have_first_ = false;
+  bool pending_ = false;
+  bool finished_ = true;
+  RxFrame pending_frame_ = {};
+  uint64_t pending_log_us_ = 0;
+  uint32_t frames_ = 0;
+};
@@ -0,0 +1,79 @@
+// Link G4X Monitor - Lock-free CAN frame ring
+//
+// Single-producer/single-consumer ring between the CAN receive task
+// (producer) and loop() (consumer). Indices are free-running 32-bit
+// counters, so depth is always head - tail even across wrap-around.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#define CAN_STD_ID_COUNT 2048   // 11-bit identifier space
+
+// One received CAN frame as stored in the ring
+struct RxFrame {
+  uint32_t timestamp_us;   // Arrival time (micros())
+  uint32_t identifier;     // 11-bit or 29-bit CAN ID
+  uint8_t extended;        // 1 = 29-bit identifier
+  uint8_t data_length;     // DLC (0-8)
+  uint8_t data[8];
+};
+
+template <uint32_t SIZE>
+class CANRing {
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "CANRing size must be a power of two");
+
+public:
+  // Producer side - never blocks, drops the new frame when full
+  bool push(const RxFrame& frame) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t tail = tail_.load(std::memory_order_acquire);
+    uint32_t depth = head - tail;
+
+    if (depth >= SIZE) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    frames_[head & (SIZE - 1)] = frame;
+    head_.store(head + 1, std::memory_order_release);
+
+    if (depth + 1 > peak_depth_.load(std::memory_order_relaxed)) {
+      peak_depth_.store(depth + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Consumer side
+  bool pop(RxFrame& frame) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    uint32_t head = head_.load(std::memory_order_acquire);
+    if (head == tail) return false;
+
+    frame = frames_[tail & (SIZE - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t depth() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  uint32_t capacity() const { return SIZE; }
+  uint32_t peakDepth() const { return peak_depth_.load(std::memory_order_relaxed); }
+  uint32_t droppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // Counters only - queued frames are left alone
+  void resetCounters() {
+    peak_depth_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  RxFrame frames_[SIZE];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> peak_depth_{0};
+  std::atomic<uint32_t> dropped_{0};
+};
@@ -0,0 +1,225 @@
+// Link G4X Monitor - Per-ID CAN statistics
+#include "can_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#endif
+
+static const uint16_t SEEN_CAPACITY = CAN_STD_ID_COUNT + CAN_EXT_STATS_SLOTS;
+
+static void* allocateTable(size_t count, size_t size) {
+#ifdef ARDUINO
+  void* table = heap_caps_calloc(count, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (table) return table;
+#endif
+  return calloc(count, size);
+}
+
+bool CANStatsTable::allocate() {
+  if (allocated()) return true;
+
+  std_ = (CANFrameStats*)allocateTable(CAN_STD_ID_COUNT, sizeof(CANFrameStats));
+  ext_ = (CANFrameStats*)allocateTable(CAN_EXT_STATS_SLOTS, sizeof(CANFrameStats));
+  seen_ = (uint16_t*)allocateTable(SEEN_CAPACITY, sizeof(uint16_t));
+  if (!std_ || !ext_ || !seen_) {
+    free(std_);
+    free(ext_);
+    free(seen_);
+    std_ = ext_ = nullptr;
+    seen_ = nullptr;
+    return false;
+  }
+  // The bit tracker is the largest table and the least essential: run
+  // without it rather than without statistics
+  bits_ = (CANBitActivity*)allocateTable(SEEN_CAPACITY, sizeof(CANBitActivity));
+  clear();
+  return true;
+}
+
+void CANStatsTable::clear() {
+  if (!allocated()) return;
+  memset(std_, 0, CAN_STD_ID_COUNT * sizeof(CANFrameStats));
+  memset(ext_, 0, CAN_EXT_STATS_SLOTS * sizeof(CANFrameStats));
+  if (bits_) memset(bits_, 0, SEEN_CAPACITY * sizeof(CANBitActivity));
+  seen_count_ = 0;
+  untracked_ = 0;
+}
+
+// Fibonacci hash, then linear probing over a fixed number of slots
+CANFrameStats* CANStatsTable::findExtended(uint32_t can_id, uint16_t& index) {
+  static_assert((CAN_EXT_STATS_SLOTS & (CAN_EXT_STATS_SLOTS - 1)) == 0, "CAN_EXT_STATS_SLOTS must be a power of two");
+  uint32_t hash = (can_id * 2654435761u) >> 16;
+
+  for (uint16_t probe = 0; probe < CAN_EXT_STATS_PROBES; probe++) {
+    uint16_t slot = (hash + probe) & (CAN_EXT_STATS_SLOTS - 1);
+    CANFrameStats& entry = ext_[slot];
+    if (!entry.active || entry.can_id == can_id) {
+      index = CAN_STD_ID_COUNT + slot;
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+// Octave of the top bit, then the next CAN_INTERVAL_SUB_BITS bits
+static uint8_t intervalBucket(uint32_t interval_us) {
+  if (interval_us < (1UL << CAN_INTERVAL_MIN_OCTAVE)) return 0;
+  uint8_t octave = 31 - __builtin_clz(interval_us);
+  if (octave > CAN_INTERVAL_MAX_OCTAVE) return CAN_INTERVAL_BUCKETS - 1;
+  uint8_t sub = (interval_us >> (octave - CAN_INTERVAL_SUB_BITS)) & ((1 << CAN_INTERVAL_SUB_BITS) - 1);
+  return ((octave - CAN_INTERVAL_MIN_OCTAVE) << CAN_INTERVAL_SUB_BITS) + sub;
+}
+
+static uint32_t bucketLowerEdge(uint8_t bucket) {
+  uint32_t base = 1UL << (CAN_INTERVAL_MIN_OCTAVE + (bucket >> CAN_INTERVAL_SUB_BITS));
+  uint32_t sub = bucket & ((1 << CAN_INTERVAL_SUB_BITS) - 1);
+  return base + sub * (base >> CAN_INTERVAL_SUB_BITS);
+}
+
+static void recordInterval(CANFrameStats& entry, uint32_t interval_us) {
+  if (entry.packet_count == 2) {
+    entry.ewma_interval_us = interval_us;
+    entry.min_interval_us = interval_us;
+    entry.max_interval_us = interval_us;
+  } else {
+    entry.ewma_interval_us += ((float)interval_us - entry.ewma_interval_us) / (1 << CAN_INTERVAL_EWMA_SHIFT);
+    if (interval_us < entry.min_interval_us) entry.min_interval_us = interval_us;
+    if (interval_us > entry.max_interval_us) entry.max_interval_us = interval_us;
+  }
+
+  uint16_t& count = entry.interval_hist[intervalBucket(interval_us)];
+  if (count == UINT16_MAX) {
+    // Halve everything rather than saturate, keeping the shape
+    for (uint8_t i = 0; i < CAN_INTERVAL_BUCKETS; i++) {
+      entry.interval_hist[i] >>= 1;
+    }
+  }
+  count++;
+}
+
+float canFrameRate(const CANFrameStats& stats, uint32_t now_us) {
+  if (stats.packet_count < 2 || stats.ewma_interval_us <= 0) return 0;
+  float interval = stats.ewma_interval_us;
+  float silent = (float)(now_us - stats.last_us);
+  if (silent > interval) interval = silent;
+  return 1000000.0f / interval;
+}
+
+uint32_t canIntervalPercentile(const CANFrameStats& stats, uint8_t percent) {
+  if (stats.packet_count < 2) return 0;
+
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < CAN_INTERVAL_BUCKETS; i++) {
+    total += stats.interval_hist[i];
+  }
+
+  // Rank of the requested sample, 1-based and rounded up
+  uint32_t rank = (total * percent + 99) / 100;
+  if (rank == 0) rank = 1;
+
+  uint32_t seen = 0;
+  uint32_t value = stats.max_interval_us;
+  for (uint8_t i = 0; i < CAN_INTERVAL_BUCKETS; i++) {
+    uint16_t count = stats.interval_hist[i];
+    if (seen + count >= rank) {
+      uint32_t lower = bucketLowerEdge(i);
+      uint32_t width = bucketLowerEdge(i + 1) - lower;
+      value = lower + (uint32_t)((uint64_t)width * (rank - seen) / count);
+      break;
+    }
+    seen += count;
+  }
+
+  if (value < stats.min_interval_us) value = stats.min_interval_us;
+  if (value > stats.max_interval_us) value = stats.max_interval_us;
+  return value;
+}
+
+// Compare against the previous payload over the bytes both frames carry.
+// Payloads load as little-endian words, so bit n is byte n / 8, bit n % 8.
+static void trackBitChanges(CANBitActivity& bits, const CANFrameStats& entry, const RxFrame& frame,
+                            uint32_t now_ms) {
+  uint8_t length = frame.data_length < entry.data_length ? frame.data_length : entry.data_length;
+  if (length > 8) length = 8;
+  if (length == 0) return;
+
+  uint64_t before, after;
+  memcpy(&before, entry.last_data, 8);
+  memcpy(&after, frame.data, 8);
+  uint64_t changed = before ^ after;
+  if (length < 8) changed &= (1ULL << (length * 8)) - 1;
+  if (changed == 0) return;
+
+  bits.toggled |= changed;
+
+  // Add 1 to the counter of every changed bit, carrying plane by plane
+  uint64_t carry = changed;
+  for (uint8_t p = 0; p < CAN_BIT_COUNT_PLANES && carry; p++) {
+    uint64_t next = bits.count_planes[p] & carry;
+    bits.count_planes[p] ^= carry;
+    carry = next;
+  }
+  if (carry) {
+    // Wrapped to zero - saturate instead
+    for (uint8_t p = 0; p < CAN_BIT_COUNT_PLANES; p++) bits.count_planes[p] |= carry;
+  }
+
+  // Close the window: its bits all take its latest change time
+  if (now_ms - bits.window_start_ms >= CAN_BIT_WINDOW_MS) {
+    for (uint64_t m = bits.window_changed; m; m &= m - 1) {
+      bits.last_change_ms[__builtin_ctzll(m)] = bits.window_last_ms;
+    }
+    bits.window_changed = 0;
+    bits.window_start_ms = now_ms;
+  }
+  bits.window_changed |= changed;
+  bits.window_last_ms = now_ms;
+}
+
+uint16_t canBitToggleCount(const CANBitActivity& bits, uint8_t bit) {
+  uint16_t count = 0;
+  for (uint8_t p = 0; p < CAN_BIT_COUNT_PLANES; p++) {
+    count |= (uint16_t)((bits.count_planes[p] >> bit) & 1) << p;
+  }
+  return count;
+}
+
+uint32_t canBitLastChange(const CANBitActivity& bits, uint8_t bit) {
+  return (bits.window_changed >> bit) & 1 ? bits.window_last_ms : bits.last_change_ms[bit];
+}
+
+void CANStatsTable::update(const RxFrame& frame, uint32_t now_ms) {
+  if (!allocated()) return;
+
+  CANFrameStats* entry;
+  uint16_t index;
+  if (frame.extended) {
+    entry = findExtended(frame.identifier, index);
+    if (!entry) {
+      untracked_++;
+      return;
+    }
+  } else {
+    index = frame.identifier & (CAN_STD_ID_COUNT - 1);
+    entry = &std_[index];
+  }
+
+  if (!entry->active) {
+    entry->active = true;
+    entry->can_id = frame.identifier;
+    entry->extended = frame.extended;
+    seen_[seen_count_++] = index;
+  }
+
+  entry->packet_count++;
+  if (entry->packet_count >= 2) {
+    recordInterval(*entry, frame.timestamp_us - entry->last_us);
+    if (bits_) trackBitChanges(bits_[index], *entry, frame, now_ms);
+  }
+  entry->last_us = frame.timestamp_us;
+  entry->last_seen = now_ms;
+  entry->data_length = frame.data_length;
+  memcpy(entry->last_data, frame.data, (frame.data_length < 8) ? frame.data_length : 8);
+}
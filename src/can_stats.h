@@ -0,0 +1,111 @@
+// Link G4X Monitor - Per-ID CAN statistics
+//
+// Standard IDs index a flat 2048-entry table directly; 29-bit IDs go
+// into a small open-addressed hash with a bounded probe, so every update
+// is constant time. IDs are also appended to a first-seen list the CAN
+// MON tab pages through. The tables live in PSRAM on the Tab5.
+//
+// Each ID also keeps its inter-arrival timing: an EWMA of the interval
+// (for a rate that follows dropouts and bursts) and a histogram with four
+// buckets per octave from 64us to 4s, from which min/p50/p99/max are read.
+//
+// For reverse-engineering unknown IDs, a parallel table records which
+// payload bits have ever changed between consecutive frames of an ID,
+// with a toggle count and last-change time per bit, cheap enough to stay
+// on at full bus load: an unchanged payload costs one 64-bit XOR, and a
+// changed one a few word operations whatever the number of bits. Counts
+// are bit-sliced (plane p holds bit p of all 64 counters, so one ripple
+// carry adds 1 to every changed bit at once), and last-change times are
+// folded in once per CAN_BIT_WINDOW_MS rather than bit by bit.
+#pragma once
+
+#include <stdint.h>
+#include "can_ring.h"
+
+#define CAN_EXT_STATS_SLOTS 256   // 29-bit IDs tracked (power of two)
+#define CAN_EXT_STATS_PROBES 8    // Hash slots tried before giving up
+
+#define CAN_INTERVAL_MIN_OCTAVE 6    // First bucket: < 2^6 us
+#define CAN_INTERVAL_MAX_OCTAVE 21   // Last bucket: >= 2^22 us (~4.2s)
+#define CAN_INTERVAL_SUB_BITS 2      // 4 buckets per octave (~19% wide)
+#define CAN_INTERVAL_BUCKETS ((CAN_INTERVAL_MAX_OCTAVE - CAN_INTERVAL_MIN_OCTAVE + 1) << CAN_INTERVAL_SUB_BITS)
+#define CAN_INTERVAL_EWMA_SHIFT 3    // EWMA weight 1/8 per frame
+
+#define CAN_BIT_COUNT_PLANES 16      // Per-bit toggle counts up to 65535 (saturating)
+#define CAN_BIT_WINDOW_MS 100        // Resolution of per-bit last-change times
+
+struct CANFrameStats {
+  uint32_t can_id;
+  uint32_t packet_count;
+  uint32_t last_seen;      // millis() of the latest frame
+  uint8_t data_length;
+  uint8_t extended;        // 1 = 29-bit identifier
+  uint8_t last_data[8];
+  bool active;
+
+  // Inter-arrival timing (RxFrame::timestamp_us)
+  uint32_t last_us;
+  float ewma_interval_us;
+  uint32_t min_interval_us;
+  uint32_t max_interval_us;
+  uint16_t interval_hist[CAN_INTERVAL_BUCKETS];
+};
+
+// Bit n is bit (n % 8) of data byte n / 8, least significant first.
+// Read through canBitToggleCount() and canBitLastChange().
+struct CANBitActivity {
+  uint64_t toggled;                               // OR of the XOR of consecutive payloads
+  uint64_t count_planes[CAN_BIT_COUNT_PLANES];    // Bit-sliced toggle counters
+  uint64_t window_changed;                        // Changed in the open window
+  uint32_t window_start_ms;
+  uint32_t window_last_ms;                        // Latest change in the open window
+  uint32_t last_change_ms[64];                    // Up to the open window
+};
+
+uint16_t canBitToggleCount(const CANBitActivity& bits, uint8_t bit);
+uint32_t canBitLastChange(const CANBitActivity& bits, uint8_t bit);
+
+// Frames/s from the EWMA interval. Time since the last frame counts as a
+// lower bound on the interval, so a silent ID decays towards 0 Hz.
+float canFrameRate(const CANFrameStats& stats, uint32_t now_us);
+
+// Inter-arrival percentile (0-100) in us, interpolated linearly inside
+// the histogram bucket it falls in and clamped to the observed min/max.
+// Returns 0 until the ID has at least two frames.
+uint32_t canIntervalPercentile(const CANFrameStats& stats, uint8_t percent);
+
+class CANStatsTable {
+public:
+  // Allocate the tables (PSRAM when available). Returns false on failure,
+  // after which update() ignores frames.
+  bool allocate();
+  bool allocated() const { return std_ != nullptr; }
+
+  // Forget every ID seen so far
+  void clear();
+
+  void update(const RxFrame& frame, uint32_t now_ms);
+
+  // Distinct IDs seen, and the n-th of them in first-seen order
+  uint16_t idCount() const { return seen_count_; }
+  const CANFrameStats& seen(uint16_t n) const {
+    uint16_t index = seen_[n];
+    return index < CAN_STD_ID_COUNT ? std_[index] : ext_[index - CAN_STD_ID_COUNT];
+  }
+
+  // Bit activity of the n-th ID; nullptr if its table could not be allocated
+  const CANBitActivity* bits(uint16_t n) const { return bits_ ? &bits_[seen_[n]] : nullptr; }
+
+  // Frames from 29-bit IDs that found no free hash slot
+  uint32_t untrackedFrames() const { return untracked_; }
+
+private:
+  CANFrameStats* findExtended(uint32_t can_id, uint16_t& index);
+
+  CANFrameStats* std_ = nullptr;   // [CAN_STD_ID_COUNT]
+  CANFrameStats* ext_ = nullptr;   // [CAN_EXT_STATS_SLOTS]
+  uint16_t* seen_ = nullptr;       // Table index, ext_ entries offset by CAN_STD_ID_COUNT
+  CANBitActivity* bits_ = nullptr; // By table index, as seen_; optional
+  uint16_t seen_count_ = 0;
+  uint32_t untracked_ = 0;
+};
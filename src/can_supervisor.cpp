@@ -0,0 +1,113 @@
+// Link G4X Monitor - CAN bus error supervisor
+#include "can_supervisor.h"
+
+void CANSupervisor::driverStarted(uint32_t now_ms) {
+  last_raw_ = {};
+  stats_.state = CAN_BUS_RUNNING;
+  stats_.tx_error_counter = 0;
+  stats_.rx_error_counter = 0;
+
+  // A restart ends any recovery in progress
+  if (recovering_) {
+    uint32_t downtime = now_ms - down_since_ms_;
+    stats_.last_downtime_ms = downtime;
+    if (downtime > stats_.max_downtime_ms) stats_.max_downtime_ms = downtime;
+    last_recovered_ms_ = now_ms;
+  }
+  recovering_ = false;
+  recovery_initiated_ = false;
+}
+
+void CANSupervisor::clearStats() {
+  CANBusState state = stats_.state;
+  uint32_t tec = stats_.tx_error_counter;
+  uint32_t rec = stats_.rx_error_counter;
+  stats_ = {};
+  stats_.state = state;
+  stats_.tx_error_counter = tec;
+  stats_.rx_error_counter = rec;
+}
+
+void CANSupervisor::accumulate(uint32_t& total, uint32_t& last_raw, uint32_t raw) {
+  // Raw counters only go backwards when the driver was reinstalled
+  total += raw >= last_raw ? raw - last_raw : raw;
+  last_raw = raw;
+}
+
+CANSupervisorAction CANSupervisor::update(const CANDriverStatus& status, uint8_t events, uint32_t now_ms) {
+  accumulate(stats_.bus_errors, last_raw_.bus_errors, status.bus_errors);
+  accumulate(stats_.tx_failed, last_raw_.tx_failed, status.tx_failed);
+  accumulate(stats_.rx_missed, last_raw_.rx_missed, status.rx_missed);
+  accumulate(stats_.rx_overrun, last_raw_.rx_overrun, status.rx_overrun);
+  accumulate(stats_.arb_lost, last_raw_.arb_lost, status.arb_lost);
+  stats_.tx_error_counter = status.tx_error_counter;
+  stats_.rx_error_counter = status.rx_error_counter;
+  stats_.state = status.state;
+
+  if (events & CAN_EVENT_ERROR_WARNING) stats_.error_warnings++;
+  if (events & CAN_EVENT_ERROR_PASSIVE) stats_.error_passive++;
+
+  switch (status.state) {
+    case CAN_BUS_OFF:
+      if (!recovering_) {
+        // New bus-off: retry at once unless the last one was recent
+        recovering_ = true;
+        recovery_initiated_ = false;
+        down_since_ms_ = now_ms;
+        stats_.bus_off++;
+
+        bool repeat = stats_.recoveries > 0 && now_ms - last_recovered_ms_ < CAN_RECOVERY_STABLE_MS;
+        if (!repeat) {
+          backoff_ms_ = 0;
+        } else if (backoff_ms_ == 0) {
+          backoff_ms_ = CAN_RECOVERY_BACKOFF_MIN_MS;
+        } else if (backoff_ms_ < CAN_RECOVERY_BACKOFF_MAX_MS) {
+          backoff_ms_ *= 2;
+          if (backoff_ms_ > CAN_RECOVERY_BACKOFF_MAX_MS) backoff_ms_ = CAN_RECOVERY_BACKOFF_MAX_MS;
+        }
+        next_attempt_ms_ = now_ms + backoff_ms_;
+      }
+      if (!recovery_initiated_ && (int32_t)(now_ms - next_attempt_ms_) >= 0) {
+        recovery_initiated_ = true;
+        recovery_started_ms_ = now_ms;
+        return CAN_ACTION_INITIATE_RECOVERY;
+      }
+      break;
+
+    case CAN_BUS_RECOVERING:
+      // 128 x 11 recessive bits normally takes a millisecond or two;
+      // a bus that never idles needs the driver reinstalled
+      if (recovering_ && recovery_initiated_ && now_ms - recovery_started_ms_ > recovery_timeout_ms_) {
+        stats_.driver_restarts++;
+        if (recovery_timeout_ms_ < CAN_RECOVERY_BACKOFF_MAX_MS * 4) recovery_timeout_ms_ *= 2;
+        recovery_initiated_ = false;
+        next_attempt_ms_ = now_ms;
+        return CAN_ACTION_RESTART_DRIVER;
+      }
+      break;
+
+    case CAN_BUS_STOPPED:
+      // Recovery complete - the controller waits in STOPPED for a start
+      if (recovering_ && recovery_initiated_) {
+        return CAN_ACTION_START;
+      }
+      break;
+
+    case CAN_BUS_RUNNING:
+      if (!recovering_ && now_ms - last_recovered_ms_ > CAN_RECOVERY_STABLE_MS) {
+        recovery_timeout_ms_ = CAN_RECOVERY_TIMEOUT_MS;
+      }
+      if (recovering_) {
+        uint32_t downtime = now_ms - down_since_ms_;
+        stats_.recoveries++;
+        stats_.last_downtime_ms = downtime;
+        if (downtime > stats_.max_downtime_ms) stats_.max_downtime_ms = downtime;
+        last_recovered_ms_ = now_ms;
+        recovering_ = false;
+        recovery_initiated_ = false;
+      }
+      break;
+  }
+
+  return CAN_ACTION_NONE;
+}
@@ -0,0 +1,106 @@
+// Link G4X Monitor - CAN bus error supervisor
+//
+// Polled from the CAN receive task with the controller's status and any
+// alerts raised since the last poll. It accumulates the driver's error
+// counters (which restart at zero with every driver install) into totals
+// that survive restarts, and drives recovery: bus-off -> initiate
+// recovery -> restart the controller once recovery completes. A bus-off
+// that follows soon after the last recovery backs off before the next
+// attempt, and a recovery that never completes asks for a full driver
+// restart, so a flapping or disconnected bus cannot spin the controller.
+#pragma once
+
+#include <stdint.h>
+
+// Mirrors twai_state_t
+enum CANBusState : uint8_t {
+  CAN_BUS_STOPPED,
+  CAN_BUS_RUNNING,
+  CAN_BUS_OFF,
+  CAN_BUS_RECOVERING
+};
+
+// Alerts worth counting, mapped from the driver's alert bits
+enum CANBusEvent : uint8_t {
+  CAN_EVENT_ERROR_WARNING = 0x01,   // TEC or REC crossed 96
+  CAN_EVENT_ERROR_PASSIVE = 0x02    // TEC or REC crossed 128
+};
+
+enum CANSupervisorAction : uint8_t {
+  CAN_ACTION_NONE,
+  CAN_ACTION_INITIATE_RECOVERY,     // twai_initiate_recovery()
+  CAN_ACTION_START,                 // twai_start() after recovery
+  CAN_ACTION_RESTART_DRIVER         // Uninstall and reinstall the driver
+};
+
+// What the driver reports; counters are cumulative since driver install
+struct CANDriverStatus {
+  CANBusState state;
+  uint32_t tx_error_counter;
+  uint32_t rx_error_counter;
+  uint32_t tx_failed;
+  uint32_t rx_missed;       // Driver RX queue full
+  uint32_t rx_overrun;      // Controller RX FIFO overrun
+  uint32_t arb_lost;
+  uint32_t bus_errors;
+};
+
+#define CAN_SUPERVISE_MS 10               // Poll period while the bus is healthy
+#define CAN_SUPERVISE_RECOVERY_MS 1       // Poll period while recovering
+#define CAN_RECOVERY_BACKOFF_MIN_MS 10    // Delay after a repeat bus-off
+#define CAN_RECOVERY_BACKOFF_MAX_MS 2000
+#define CAN_RECOVERY_STABLE_MS 1000       // Bus-off later than this is not a repeat
+#define CAN_RECOVERY_TIMEOUT_MS 500       // Recovery not done by then -> restart driver
+
+// Totals since the last clearStats(), across driver restarts
+struct CANErrorStats {
+  CANBusState state;
+  uint8_t reserved[3];
+  uint32_t tx_error_counter;   // Current TEC
+  uint32_t rx_error_counter;   // Current REC
+  uint32_t bus_errors;
+  uint32_t tx_failed;
+  uint32_t rx_missed;
+  uint32_t rx_overrun;
+  uint32_t arb_lost;
+  uint32_t error_warnings;
+  uint32_t error_passive;
+  uint32_t bus_off;
+  uint32_t recoveries;
+  uint32_t driver_restarts;
+  uint32_t last_downtime_ms;   // Bus-off to controller running again
+  uint32_t max_downtime_ms;
+};
+
+class CANSupervisor {
+public:
+  // Call whenever the driver is (re)installed: its counters restart at
+  // zero. Totals and backoff carry over.
+  void driverStarted(uint32_t now_ms);
+
+  void clearStats();
+
+  CANSupervisorAction update(const CANDriverStatus& status, uint8_t events, uint32_t now_ms);
+
+  // How long the receive task may block before the next update()
+  uint32_t pollIntervalMs() const {
+    return stats_.state == CAN_BUS_RUNNING && !recovering_ ? CAN_SUPERVISE_MS : CAN_SUPERVISE_RECOVERY_MS;
+  }
+
+  const CANErrorStats& stats() const { return stats_; }
+
+private:
+  static void accumulate(uint32_t& total, uint32_t& last_raw, uint32_t raw);
+
+  CANErrorStats stats_ = {};
+  CANDriverStatus last_raw_ = {};
+
+  bool recovering_ = false;          // Bus-off seen, controller not yet running
+  bool recovery_initiated_ = false;
+  uint32_t down_since_ms_ = 0;
+  uint32_t next_attempt_ms_ = 0;
+  uint32_t recovery_started_ms_ = 0;
+  uint32_t last_recovered_ms_ = 0;
+  uint32_t backoff_ms_ = 0;
+  uint32_t recovery_timeout_ms_ = CAN_RECOVERY_TIMEOUT_MS;
+};
@@ -0,0 +1,47 @@
+// Link G4X Monitor - CAN transport interface
+//
+// Everything above the driver - the receive task, the auto-detect scan,
+// the command queue and the bus supervisor - goes through this interface
+// instead of a particular CAN driver. The firmware uses the TWAI
+// controller (can_transport_twai.*); the native Linux build uses a
+// SocketCAN interface such as vcan0 (can_transport_socketcan.*), so the
+// decode and statistics path can be driven and profiled on a workstation.
+#pragma once
+
+#include <stdint.h>
+#include "can_ring.h"
+#include "can_supervisor.h"
+
+// Single standard-ID acceptance filter: an ID passes when it matches
+// code on every bit not set in dont_care
+struct CANFilter {
+  uint16_t code;
+  uint16_t dont_care;
+};
+
+class CANTransport {
+public:
+  virtual ~CANTransport() {}
+
+  // Start receiving at bitrate. filter == nullptr accepts every frame.
+  // Listen-only never ACKs, sends error frames or transmits.
+  virtual bool begin(uint32_t bitrate, const CANFilter* filter, bool listen_only) = 0;
+  virtual void end() = 0;
+
+  // Wait up to timeout_ms for one frame (0 = poll). Fills timestamp_us
+  // from the same microsecond clock the caller uses.
+  virtual bool receive(RxFrame& frame, uint32_t timeout_ms) = 0;
+
+  // Queue one frame without waiting; false if the driver is full
+  virtual bool transmit(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length) = 0;
+
+  // Controller state and cumulative counters for CANSupervisor, plus the
+  // CANBusEvent bits raised since the last call
+  virtual bool status(CANDriverStatus& status, uint8_t& events) = 0;
+
+  // Carry out a supervisor recovery step (CAN_ACTION_RESTART_DRIVER is
+  // the caller's job: end() and begin() again)
+  virtual bool recover(CANSupervisorAction action) = 0;
+
+  virtual const char* name() const = 0;
+};
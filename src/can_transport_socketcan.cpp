@@ -0,0 +1,169 @@
+// Link G4X Monitor - SocketCAN transport
+#include "can_transport_socketcan.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+
+static uint32_t monotonicMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000);
+}
+
+bool SocketCANTransport::begin(uint32_t bitrate, const CANFilter* filter, bool listen_only) {
+  (void)bitrate;   // Set on the interface with `ip link set <if> type can bitrate N`
+  end();
+
+  socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (socket_ < 0) {
+    perror("SocketCAN socket");
+    return false;
+  }
+
+  struct ifreq ifr = {};
+  strncpy(ifr.ifr_name, interface_name_, IFNAMSIZ - 1);
+  if (ioctl(socket_, SIOCGIFINDEX, &ifr) < 0) {
+    fprintf(stderr, "SocketCAN: no interface %s\n", interface_name_);
+    end();
+    return false;
+  }
+
+  if (filter) {
+    // Standard data frames only, matching code outside dont_care
+    struct can_filter rule;
+    rule.can_id = filter->code & CAN_SFF_MASK;
+    rule.can_mask = (~filter->dont_care & CAN_SFF_MASK) | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FILTER, &rule, sizeof(rule));
+  }
+
+  can_err_mask_t error_mask = CAN_ERR_TX_TIMEOUT | CAN_ERR_LOSTARB | CAN_ERR_CRTL | CAN_ERR_PROT |
+                              CAN_ERR_BUSOFF | CAN_ERR_BUSERROR | CAN_ERR_RESTARTED | CAN_ERR_CNT;
+  setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &error_mask, sizeof(error_mask));
+
+  int enable = 1;
+  setsockopt(socket_, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+
+  struct sockaddr_can addr = {};
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(socket_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    perror("SocketCAN bind");
+    end();
+    return false;
+  }
+
+  listen_only_ = listen_only;
+  status_ = {};
+  status_.state = CAN_BUS_RUNNING;
+  events_ = 0;
+  return true;
+}
+
+void SocketCANTransport::end() {
+  if (socket_ >= 0) close(socket_);
+  socket_ = -1;
+}
+
+void SocketCANTransport::handleErrorFrame(uint32_t can_id, const uint8_t* data) {
+  if (can_id & CAN_ERR_TX_TIMEOUT) status_.tx_failed++;
+  if (can_id & CAN_ERR_LOSTARB) status_.arb_lost++;
+  if (can_id & (CAN_ERR_PROT | CAN_ERR_BUSERROR)) status_.bus_errors++;
+  if (can_id & CAN_ERR_CRTL) {
+    uint8_t ctrl = data[1];
+    if (ctrl & (CAN_ERR_CRTL_RX_WARNING | CAN_ERR_CRTL_TX_WARNING)) events_ |= CAN_EVENT_ERROR_WARNING;
+    if (ctrl & (CAN_ERR_CRTL_RX_PASSIVE | CAN_ERR_CRTL_TX_PASSIVE)) events_ |= CAN_EVENT_ERROR_PASSIVE;
+    if (ctrl & (CAN_ERR_CRTL_RX_OVERFLOW | CAN_ERR_CRTL_TX_OVERFLOW)) status_.rx_overrun++;
+  }
+  if (can_id & CAN_ERR_CNT) {
+    status_.tx_error_counter = data[6];
+    status_.rx_error_counter = data[7];
+  }
+  // The kernel restarts a bus-off controller itself (restart-ms)
+  if (can_id & CAN_ERR_BUSOFF) status_.state = CAN_BUS_OFF;
+  if (can_id & CAN_ERR_RESTARTED) status_.state = CAN_BUS_RUNNING;
+}
+
+bool SocketCANTransport::receive(RxFrame& frame, uint32_t timeout_ms) {
+  if (socket_ < 0) return false;
+
+  struct can_frame raw;
+  struct iovec iov = {&raw, sizeof(raw)};
+  char control[CMSG_SPACE(sizeof(uint32_t))];
+  struct msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  bool waited = false;
+  for (;;) {
+    // Try first: a busy bus costs one syscall per frame, not two
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n = recvmsg(socket_, &msg, MSG_DONTWAIT);
+
+    if (n < 0) {
+      if ((errno != EAGAIN && errno != EWOULDBLOCK) || timeout_ms == 0 || waited) return false;
+      struct pollfd pfd = {socket_, POLLIN, 0};
+      if (poll(&pfd, 1, (int)timeout_ms) <= 0) return false;
+      waited = true;
+      continue;
+    }
+    if (n < (ssize_t)sizeof(raw)) continue;
+
+    for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+      if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+        memcpy(&status_.rx_missed, CMSG_DATA(c), sizeof(uint32_t));
+      }
+    }
+
+    if (raw.can_id & CAN_ERR_FLAG) {
+      handleErrorFrame(raw.can_id & CAN_ERR_MASK, raw.data);
+      continue;
+    }
+    if (raw.can_id & CAN_RTR_FLAG) continue;
+
+    frame.timestamp_us = monotonicMicros();
+    frame.extended = (raw.can_id & CAN_EFF_FLAG) ? 1 : 0;
+    frame.identifier = raw.can_id & (frame.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+    frame.data_length = raw.can_dlc > 8 ? 8 : raw.can_dlc;
+    memcpy(frame.data, raw.data, 8);
+    return true;
+  }
+}
+
+bool SocketCANTransport::transmit(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length) {
+  if (socket_ < 0 || listen_only_) return false;
+
+  struct can_frame raw = {};
+  raw.can_id = extended ? (identifier & CAN_EFF_MASK) | CAN_EFF_FLAG : identifier & CAN_SFF_MASK;
+  raw.can_dlc = length > 8 ? 8 : length;
+  memcpy(raw.data, data, raw.can_dlc);
+  return send(socket_, &raw, sizeof(raw), MSG_DONTWAIT) == (ssize_t)sizeof(raw);
+}
+
+bool SocketCANTransport::status(CANDriverStatus& status, uint8_t& events) {
+  if (socket_ < 0) return false;
+  status = status_;
+  events = events_;
+  events_ = 0;
+  return true;
+}
+
+bool SocketCANTransport::recover(CANSupervisorAction action) {
+  // Bus-off recovery belongs to the kernel; nothing to do from a socket
+  (void)action;
+  return false;
+}
+
+#endif
@@ -0,0 +1,40 @@
+// Link G4X Monitor - SocketCAN transport
+//
+// A raw CAN socket on a Linux interface (can0, or vcan0 fed by cangen /
+// canplayer). Bitrate and listen-only are properties of the interface
+// and are set with `ip link`; begin() only binds the socket and installs
+// the acceptance filter in the kernel. Error frames are consumed here and
+// turned into the CANDriverStatus counters the supervisor expects, and
+// frames the socket dropped (SO_RXQ_OVFL) count as rx_missed.
+// Timestamps come from CLOCK_MONOTONIC.
+#pragma once
+
+#ifdef __linux__
+
+#include "can_transport.h"
+
+class SocketCANTransport : public CANTransport {
+public:
+  explicit SocketCANTransport(const char* interface_name) : interface_name_(interface_name) {}
+  ~SocketCANTransport() override { end(); }
+
+  bool begin(uint32_t bitrate, const CANFilter* filter, bool listen_only) override;
+  void end() override;
+  bool receive(RxFrame& frame, uint32_t timeout_ms) override;
+  bool transmit(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length) override;
+  bool status(CANDriverStatus& status, uint8_t& events) override;
+  bool recover(CANSupervisorAction action) override;
+  const char* name() const override { return interface_name_; }
+
+private:
+  // Error frame -> counters; the frame itself is never returned
+  void handleErrorFrame(uint32_t can_id, const uint8_t* data);
+
+  const char* interface_name_;
+  int socket_ = -1;
+  bool listen_only_ = false;
+  CANDriverStatus status_ = {};
+  uint8_t events_ = 0;
+};
+
+#endif
@@ -0,0 +1,103 @@
+// Link G4X Monitor - TWAI CAN transport
+#include "can_transport_twai.h"
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <ESP32-TWAI-CAN.hpp>
+#include <string.h>
+
+#define TWAI_SUPERVISED_ALERTS (TWAI_ALERT_ABOVE_ERR_WARN | TWAI_ALERT_ERR_PASS | TWAI_ALERT_BUS_OFF | \
+                                TWAI_ALERT_BUS_RECOVERED | TWAI_ALERT_BUS_ERROR | TWAI_ALERT_ARB_LOST | \
+                                TWAI_ALERT_TX_FAILED | TWAI_ALERT_RX_QUEUE_FULL | TWAI_ALERT_RX_FIFO_OVERRUN)
+
+static TwaiSpeed getTwaiSpeed(uint32_t bitrate) {
+  switch (bitrate) {
+    case 125000: return TWAI_SPEED_125KBPS;
+    case 250000: return TWAI_SPEED_250KBPS;
+    case 500000: return TWAI_SPEED_500KBPS;
+    case 1000000: return TWAI_SPEED_1000KBPS;
+    default: return TWAI_SPEED_500KBPS;
+  }
+}
+
+bool TWAITransport::begin(uint32_t bitrate, const CANFilter* filter, bool listen_only) {
+  TwaiSpeed speed = getTwaiSpeed(bitrate);
+
+  // Single filter: standard ID in code bits 31:21, RTR and data ignored
+  twai_filter_config_t twai_filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+  if (filter) {
+    twai_filter.acceptance_code = (uint32_t)filter->code << 21;
+    twai_filter.acceptance_mask = ((uint32_t)filter->dont_care << 21) | 0x1FFFFF;
+    twai_filter.single_filter = true;
+  }
+
+  bool started;
+  if (listen_only) {
+    twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t)tx_pin_, (gpio_num_t)rx_pin_,
+                                                                TWAI_MODE_LISTEN_ONLY);
+    general.rx_queue_len = rx_queue_;
+    started = ESP32Can.begin(speed, tx_pin_, rx_pin_, 0xFFFF, rx_queue_, &twai_filter, &general);
+  } else {
+    ESP32Can.setPins(tx_pin_, rx_pin_);
+    ESP32Can.setRxQueueSize(rx_queue_);
+    ESP32Can.setTxQueueSize(tx_queue_);
+    started = ESP32Can.begin(speed, -1, -1, 0xFFFF, 0xFFFF, &twai_filter);
+  }
+  if (!started) return false;
+
+  twai_reconfigure_alerts(TWAI_SUPERVISED_ALERTS, NULL);
+  return true;
+}
+
+void TWAITransport::end() {
+  ESP32Can.end();
+}
+
+bool TWAITransport::receive(RxFrame& frame, uint32_t timeout_ms) {
+  twai_message_t message;
+  if (!ESP32Can.readFrame(message, timeout_ms)) return false;
+
+  frame.timestamp_us = micros();
+  frame.identifier = message.identifier;
+  frame.extended = message.extd;
+  frame.data_length = message.data_length_code > 8 ? 8 : message.data_length_code;
+  memcpy(frame.data, message.data, 8);
+  return true;
+}
+
+bool TWAITransport::transmit(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length) {
+  CanFrame frame = {};
+  frame.identifier = identifier;
+  frame.extd = extended ? 1 : 0;
+  frame.data_length_code = length > 8 ? 8 : length;
+  memcpy(frame.data, data, frame.data_length_code);
+  return ESP32Can.writeFrame(frame, 0);   // Never wait on a full TX queue
+}
+
+bool TWAITransport::status(CANDriverStatus& status, uint8_t& events) {
+  twai_status_info_t info;
+  if (twai_get_status_info(&info) != ESP_OK) return false;
+
+  uint32_t alerts = 0;
+  twai_read_alerts(&alerts, 0);
+  events = 0;
+  if (alerts & TWAI_ALERT_ABOVE_ERR_WARN) events |= CAN_EVENT_ERROR_WARNING;
+  if (alerts & TWAI_ALERT_ERR_PASS) events |= CAN_EVENT_ERROR_PASSIVE;
+
+  status = {
+    (CANBusState)info.state, info.tx_error_counter, info.rx_error_counter, info.tx_failed_count,
+    info.rx_missed_count, info.rx_overrun_count, info.arb_lost_count, info.bus_error_count
+  };
+  return true;
+}
+
+bool TWAITransport::recover(CANSupervisorAction action) {
+  switch (action) {
+    case CAN_ACTION_INITIATE_RECOVERY: return twai_initiate_recovery() == ESP_OK;
+    case CAN_ACTION_START: return twai_start() == ESP_OK;
+    default: return false;
+  }
+}
+
+#endif
@@ -0,0 +1,31 @@
+// Link G4X Monitor - TWAI CAN transport
+//
+// The ESP32-P4 TWAI controller through ESP32-TWAI-CAN, with the status
+// and recovery calls going straight to the IDF driver. Firmware only.
+#pragma once
+
+#ifdef ARDUINO
+
+#include "can_transport.h"
+
+class TWAITransport : public CANTransport {
+public:
+  TWAITransport(int tx_pin, int rx_pin, uint16_t rx_queue, uint16_t tx_queue)
+    : tx_pin_(tx_pin), rx_pin_(rx_pin), rx_queue_(rx_queue), tx_queue_(tx_queue) {}
+
+  bool begin(uint32_t bitrate, const CANFilter* filter, bool listen_only) override;
+  void end() override;
+  bool receive(RxFrame& frame, uint32_t timeout_ms) override;
+  bool transmit(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length) override;
+  bool status(CANDriverStatus& status, uint8_t& events) override;
+  bool recover(CANSupervisorAction action) override;
+  const char* name() const override { return "TWAI"; }
+
+private:
+  int tx_pin_;
+  int rx_pin_;
+  uint16_t rx_queue_;
+  uint16_t tx_queue_;
+};
+
+#endif
@@ -0,0 +1,112 @@
+// Link G4X Monitor - Dashboard -> ECU command queue (frame 0x600)
+#include "ecu_commands.h"
+
+#include <string.h>
+
+static ECUCommandType slotType(uint8_t index) {
+  return (ECUCommandType)(index + CMD_BOOST_MAP);
+}
+
+static bool commandEchoed(ECUCommandType type) {
+  return type == CMD_BOOST_MAP || type == CMD_LAUNCH || type == CMD_ANTI_LAG;
+}
+
+static bool echoMatches(ECUCommandType type, uint8_t value, const ECUData& data) {
+  switch (type) {
+    case CMD_BOOST_MAP: return data.current_boost_map == value;
+    case CMD_LAUNCH: return data.launch_control_active == (value != 0);
+    case CMD_ANTI_LAG: return data.anti_lag_active == (value != 0);
+    default: return false;
+  }
+}
+
+void ECUCommandQueue::reset() {
+  memset(slots_, 0, sizeof(slots_));
+  memset(&stats_, 0, sizeof(stats_));
+  tokens_ = ECU_COMMAND_BURST;
+}
+
+void ECUCommandQueue::request(ECUCommandType type, uint8_t value, uint32_t now_ms) {
+  if (type < CMD_BOOST_MAP || type > CMD_SAFE_MODE) return;
+  Slot& slot = slots_[type - CMD_BOOST_MAP];
+
+  stats_.requested++;
+  if (slot.state == SLOT_QUEUED) {
+    stats_.coalesced++;
+  }
+
+  slot.state = SLOT_QUEUED;
+  slot.value = value;
+  slot.attempts = 0;
+  slot.requested_ms = now_ms;
+}
+
+void ECUCommandQueue::complete(Slot& slot, uint32_t now_ms) {
+  uint32_t latency = now_ms - slot.requested_ms;
+  stats_.confirmed++;
+  stats_.last_latency_ms = latency;
+  if (latency > stats_.max_latency_ms) stats_.max_latency_ms = latency;
+  slot.state = SLOT_IDLE;
+}
+
+void ECUCommandQueue::service(uint32_t now_ms, ECUCommandTransmitFn transmit) {
+  // Refill the bucket
+  if (tokens_ >= ECU_COMMAND_BURST) {
+    last_refill_ms_ = now_ms;
+  } else {
+    uint32_t earned = (now_ms - last_refill_ms_) / ECU_COMMAND_INTERVAL_MS;
+    if (earned > 0) {
+      tokens_ = (tokens_ + earned > ECU_COMMAND_BURST) ? ECU_COMMAND_BURST : tokens_ + earned;
+      last_refill_ms_ += earned * ECU_COMMAND_INTERVAL_MS;
+    }
+  }
+
+  for (uint8_t i = 0; i < ECU_COMMAND_TYPES; i++) {
+    Slot& slot = slots_[i];
+    ECUCommandType type = slotType(i);
+
+    // Unconfirmed: resend, or give up
+    if (slot.state == SLOT_AWAITING && now_ms - slot.sent_ms >= ECU_COMMAND_TIMEOUT_MS) {
+      if (slot.attempts >= ECU_COMMAND_MAX_ATTEMPTS) {
+        stats_.failed++;
+        slot.state = SLOT_IDLE;
+      } else {
+        stats_.retries++;
+        slot.state = SLOT_QUEUED;
+      }
+    }
+
+    if (slot.state != SLOT_QUEUED || tokens_ == 0) continue;
+
+    uint8_t data[8] = {type, slot.value, ECU_COMMAND_CONFIRM, 0, 0, 0, 0, 0};
+    if (!transmit(data)) break;   // Driver queue full - try again next pass
+
+    tokens_--;
+    stats_.transmitted++;
+    slot.attempts++;
+    slot.sent_ms = now_ms;
+
+    if (echo_available_ && commandEchoed(type)) {
+      slot.state = SLOT_AWAITING;
+    } else {
+      complete(slot, now_ms);
+    }
+  }
+}
+
+void ECUCommandQueue::onStatusEcho(const ECUData& data, uint32_t now_ms) {
+  for (uint8_t i = 0; i < ECU_COMMAND_TYPES; i++) {
+    Slot& slot = slots_[i];
+    if (slot.state == SLOT_AWAITING && echoMatches(slotType(i), slot.value, data)) {
+      complete(slot, now_ms);
+    }
+  }
+}
+
+uint8_t ECUCommandQueue::pendingCount() const {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < ECU_COMMAND_TYPES; i++) {
+    if (slots_[i].state != SLOT_IDLE) count++;
+  }
+  return count;
+}
@@ -0,0 +1,84 @@
+// Link G4X Monitor - Dashboard -> ECU command queue (frame 0x600)
+//
+// One slot per command type, so repeated taps coalesce to the latest
+// value. service() transmits from loop() through a token bucket: a full
+// bucket lets a preset go out as one burst, after which frames are spaced
+// by ECU_COMMAND_INTERVAL_MS. Commands the ECU echoes in 0x502 (boost
+// map, launch, anti-lag) stay pending until the echo matches or they time
+// out and are resent; the others complete once transmitted.
+#pragma once
+
+#include <stdint.h>
+#include "ecu_data.h"
+
+// Frame layout from docs/CAN_Frame_Reference.md
+const uint32_t ECU_COMMAND_ID = 0x600;
+const uint8_t ECU_COMMAND_CONFIRM = 0xAA;
+
+enum ECUCommandType : uint8_t {
+  CMD_BOOST_MAP = 0x01,      // Value 1-8
+  CMD_BOOST_ADJUST = 0x02,   // Value -10..+10 (two's complement)
+  CMD_LAUNCH = 0x03,         // Value 0/1
+  CMD_ANTI_LAG = 0x04,       // Value 0/1
+  CMD_SAFE_MODE = 0x05,      // Value 1
+};
+
+#define ECU_COMMAND_TYPES 5
+#define ECU_COMMAND_BURST 5            // Frames sent back to back
+#define ECU_COMMAND_INTERVAL_MS 50     // Token refill after a burst
+#define ECU_COMMAND_TIMEOUT_MS 300     // 0x502 runs at 10Hz
+#define ECU_COMMAND_MAX_ATTEMPTS 3
+
+// Queue one 8-byte 0x600 payload without blocking; false if the driver is full
+typedef bool (*ECUCommandTransmitFn)(const uint8_t* data);
+
+struct ECUCommandStats {
+  uint32_t requested;
+  uint32_t coalesced;       // Requests that replaced one not yet sent
+  uint32_t transmitted;     // Frames, including retries
+  uint32_t retries;
+  uint32_t confirmed;
+  uint32_t failed;          // Gave up after ECU_COMMAND_MAX_ATTEMPTS
+  uint32_t last_latency_ms; // Request to confirmation
+  uint32_t max_latency_ms;
+};
+
+class ECUCommandQueue {
+public:
+  void reset();
+
+  // Only wait for 0x502 echoes when the custom stream is being decoded
+  void setEchoAvailable(bool available) { echo_available_ = available; }
+
+  void request(ECUCommandType type, uint8_t value, uint32_t now_ms);
+  void service(uint32_t now_ms, ECUCommandTransmitFn transmit);
+
+  // Call after each decoded 0x502 frame
+  void onStatusEcho(const ECUData& data, uint32_t now_ms);
+
+  uint8_t pendingCount() const;
+  const ECUCommandStats& stats() const { return stats_; }
+
+private:
+  enum SlotState : uint8_t {
+    SLOT_IDLE,
+    SLOT_QUEUED,       // Waiting for a token
+    SLOT_AWAITING      // Sent, waiting for the 0x502 echo
+  };
+
+  struct Slot {
+    SlotState state;
+    uint8_t value;
+    uint8_t attempts;
+    uint32_t requested_ms;
+    uint32_t sent_ms;
+  };
+
+  void complete(Slot& slot, uint32_t now_ms);
+
+  Slot slots_[ECU_COMMAND_TYPES] = {};
+  ECUCommandStats stats_ = {};
+  uint8_t tokens_ = ECU_COMMAND_BURST;
+  uint32_t last_refill_ms_ = 0;
+  bool echo_available_ = false;
+};
@@ -0,0 +1,146 @@
+// Link G4X Monitor - Decoded ECU data
+//
+// Shared between the firmware and host-side tools, so no Arduino headers.
+#pragma once
+
+#include <stdint.h>
+
+// ========== DECODED SIGNALS ==========
+// Every ECUData field a CAN decoder can write. Decoder tables name these
+// instead of struct fields so per-signal state can live in flat arrays.
+enum SignalId : uint8_t {
+  SIG_RPM,
+  SIG_TPS,
+  SIG_APS,
+  SIG_MGP,
+  SIG_ECT,
+  SIG_IAT,
+  SIG_BATTERY,
+  SIG_LAMBDA,
+  SIG_LAMBDA_TARGET,
+  SIG_INJECTOR_DUTY,
+  SIG_ETHANOL,
+  SIG_OIL_PRESS,
+  SIG_FUEL_PRESS,
+  SIG_OIL_TEMP,
+  SIG_FUEL_TEMP,
+  SIG_IGNITION_TIMING,
+  SIG_INJECTOR_DUTY_2,
+  SIG_LAMBDA_2,
+  SIG_VEHICLE_SPEED,
+  SIG_ECU_TEMP,
+  SIG_BOOST_MAP,
+  SIG_ETHROTTLE_MAP,
+  SIG_LAUNCH_ACTIVE,
+  SIG_ANTI_LAG_ACTIVE,
+  SIG_COUNT
+};
+
+// ========== ECU DATA STRUCTURE ==========
+struct ECUData {
+  // Primary Engine Data (Frame 0x500)
+  float rpm = 2150;
+  float tps = 15;
+  float aps = 18;
+  float mgp = 5;
+  float ect = 87;
+  float iat = 28;
+  float battery = 12.5;
+
+  // Lambda & Fuel Data (Frame 0x501)
+  float lambda = 1.0;
+  float lambda_target = 1.0;
+  float injector_duty = 20;
+  float ethanol_percent = 85;
+
+  // Pressures & Status (Frame 0x502)
+  float oil_press = 50;
+  float fuel_press = 300;
+  uint8_t current_boost_map = 1;
+  uint8_t current_ethrottle_map = 1;
+
+  // Control System Status
+  bool boost_control_active = false;
+  bool launch_control_active = false;
+  bool anti_lag_active = false;
+
+  // Control interface variables
+  float boost_adjustment = 0.0;
+  int launch_rpm = 4000;
+  bool system_ready = true;
+
+  // Additional data fields (not in CAN stream but needed for display)
+  float speed = 0.0;
+
+  // Haltech IC7 extended data
+  float oil_temp = 90;            // °C
+  float fuel_temp = 30;           // °C
+  float ignition_timing = 15;     // Degrees BTDC
+  float injector_duty_2 = 0;      // Secondary injector duty %
+  float lambda_2 = 1.0;           // Second wideband sensor
+
+  // Generic Dash 2 extended data
+  float ecu_temp = 45;            // °C
+
+  // Freshness, maintained by SignalDecoder: when each signal was last
+  // decoded (millis()) and one bit per SignalId that is set on decode and
+  // cleared once the signal's frame has gone quiet for too long
+  uint32_t signal_updated_ms[SIG_COUNT] = {};
+  uint32_t signal_valid = 0;
+
+  bool valid(SignalId signal) const {
+    return (signal_valid & (1UL << signal)) != 0;
+  }
+};
+
+enum SignalKind : uint8_t {
+  KIND_FLOAT,
+  KIND_U8,
+  KIND_BOOL
+};
+
+// Where a decoded signal lands in ECUData (exactly one member is set)
+struct SignalField {
+  const char* name;
+  SignalKind kind;
+  float ECUData::* f;
+  uint8_t ECUData::* u8;
+  bool ECUData::* flag;
+};
+
+constexpr SignalField SIGNAL_FIELDS[SIG_COUNT] = {
+  {"RPM",        KIND_FLOAT, &ECUData::rpm,             nullptr, nullptr},
+  {"TPS",        KIND_FLOAT, &ECUData::tps,             nullptr, nullptr},
+  {"APS",        KIND_FLOAT, &ECUData::aps,             nullptr, nullptr},
+  {"MGP",        KIND_FLOAT, &ECUData::mgp,             nullptr, nullptr},
+  {"ECT",        KIND_FLOAT, &ECUData::ect,             nullptr, nullptr},
+  {"IAT",        KIND_FLOAT, &ECUData::iat,             nullptr, nullptr},
+  {"BATTERY",    KIND_FLOAT, &ECUData::battery,         nullptr, nullptr},
+  {"LAMBDA",     KIND_FLOAT, &ECUData::lambda,          nullptr, nullptr},
+  {"LAMBDA TGT", KIND_FLOAT, &ECUData::lambda_target,   nullptr, nullptr},
+  {"INJ DUTY",   KIND_FLOAT, &ECUData::injector_duty,   nullptr, nullptr},
+  {"ETHANOL",    KIND_FLOAT, &ECUData::ethanol_percent, nullptr, nullptr},
+  {"OIL PRESS",  KIND_FLOAT, &ECUData::oil_press,       nullptr, nullptr},
+  {"FUEL PRESS", KIND_FLOAT, &ECUData::fuel_press,      nullptr, nullptr},
+  {"OIL TEMP",   KIND_FLOAT, &ECUData::oil_temp,        nullptr, nullptr},
+  {"FUEL TEMP",  KIND_FLOAT, &ECUData::fuel_temp,       nullptr, nullptr},
+  {"TIMING",     KIND_FLOAT, &ECUData::ignition_timing, nullptr, nullptr},
+  {"INJ DUTY 2", KIND_FLOAT, &ECUData::injector_duty_2, nullptr, nullptr},
+  {"LAMBDA 2",   KIND_FLOAT, &ECUData::lambda_2,        nullptr, nullptr},
+  {"SPEED",      KIND_FLOAT, &ECUData::speed,           nullptr, nullptr},
+  {"ECU TEMP",   KIND_FLOAT, &ECUData::ecu_temp,        nullptr, nullptr},
+  {"BOOST MAP",  KIND_U8,    nullptr, &ECUData::current_boost_map,     nullptr},
+  {"ETC MAP",    KIND_U8,    nullptr, &ECUData::current_ethrottle_map, nullptr},
+  {"LAUNCH",     KIND_BOOL,  nullptr, nullptr, &ECUData::launch_control_active},
+  {"ANTI-LAG",   KIND_BOOL,  nullptr, nullptr, &ECUData::anti_lag_active},
+};
+
+// Current value of any signal as a float (maps as their number, flags 0/1)
+inline float signalValue(const ECUData& data, SignalId signal) {
+  const SignalField& field = SIGNAL_FIELDS[signal];
+  switch (field.kind) {
+    case KIND_FLOAT: return data.*field.f;
+    case KIND_U8: return data.*field.u8;
+    default: return data.*field.flag ? 1.0f : 0.0f;
+  }
+}
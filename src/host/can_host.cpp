@@ -0,0 +1,235 @@
+// Link G4X Monitor - Native host entry point
+//
+// The dashboard's receive path without the display: frames from a
+// SocketCAN interface go through the same CANPipeline, statistics table,
+// bus load meter, signal decoder and bus supervisor as on the Tab5, and
+// a status line is printed once a second. A candump/ASC log can stand
+// in for the interface (-R), replayed at its own pace, faster, or flat
+// out. Built by [env:native]:
+//
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+//   pio run -e native
+//   .pio/build/native/program -i vcan0 -p custom &
+//   cangen vcan0 -g 0 -I 500 -L 8          # or canplayer -I capture.log
+//   perf record -g .pio/build/native/program -i vcan0
+//   .pio/build/native/program -R trackday.log -s max
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "can_pipeline.h"
+#include "can_replay.h"
+#include "can_supervisor.h"
+#include "can_transport_socketcan.h"
+
+#define HOST_BATCH_FRAMES 512          // Frames per batch, as CAN_RX_RING_SIZE on device
+#define HOST_REPORT_MS 1000
+
+static volatile sig_atomic_t host_stop = 0;
+
+static void onSignal(int) {
+  host_stop = 1;
+}
+
+static uint64_t monotonicNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static size_t readLogFile(void* context, char* buffer, size_t length) {
+  return fread(buffer, 1, length, (FILE*)context);
+}
+
+// "max", or a multiplier such as 1, 10x, 0.5x
+static bool parseReplaySpeed(const char* text, uint32_t& speed_percent) {
+  if (strcmp(text, "max") == 0) {
+    speed_percent = CAN_REPLAY_SPEED_MAX;
+    return true;
+  }
+  char* end;
+  double factor = strtod(text, &end);
+  if (end == text || (*end && strcmp(end, "x") != 0) || factor < 0.01) return false;
+  speed_percent = (uint32_t)(factor * 100 + 0.5);
+  return true;
+}
+
+static void usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [-i interface | -R log [-s speed]] [-p custom|ic7|dash2] [-b base_id] [-r bitrate] [-f]\n"
+          "  -i  SocketCAN interface (default vcan0)\n"
+          "  -R  Replay a candump/ASC log instead (- for stdin)\n"
+          "  -s  Replay speed: 1x (default), 10x, 0.5x or max\n"
+          "  -p  Stream layout to decode (default custom)\n"
+          "  -b  Haltech IC7 base ID (default 864)\n"
+          "  -r  Bitrate for the bus load figures (default 1000000)\n"
+          "  -f  Install the decoder's acceptance filter in the kernel\n",
+          program);
+}
+
+int main(int argc, char** argv) {
+  const char* interface_name = "vcan0";
+  const char* protocol = "custom";
+  uint32_t base_id = 864;
+  uint32_t bitrate = 1000000;
+  bool use_filter = false;
+  const char* replay_path = NULL;
+  uint32_t replay_speed = CAN_REPLAY_SPEED_1X;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "i:R:s:p:b:r:fh")) != -1) {
+    switch (opt) {
+      case 'i': interface_name = optarg; break;
+      case 'R': replay_path = optarg; break;
+      case 's':
+        if (!parseReplaySpeed(optarg, replay_speed)) {
+          usage(argv[0]);
+          return 2;
+        }
+        break;
+      case 'p': protocol = optarg; break;
+      case 'b': base_id = strtoul(optarg, NULL, 0); break;
+      case 'r': bitrate = strtoul(optarg, NULL, 0); break;
+      case 'f': use_filter = true; break;
+      default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+    }
+  }
+
+  SignalDecoder decoder;
+  bool configured;
+  if (strcmp(protocol, "custom") == 0) {
+    configured = decoder.configure(CUSTOM_STREAM_FRAMES.data(), CUSTOM_STREAM_FRAMES.size());
+  } else if (strcmp(protocol, "ic7") == 0) {
+    configured = decoder.configure(HALTECH_IC7_FRAMES.data(), HALTECH_IC7_FRAMES.size(), base_id);
+  } else if (strcmp(protocol, "dash2") == 0) {
+    configured = decoder.configure(GENERIC_DASH2_FRAMES.data(), GENERIC_DASH2_FRAMES.size());
+  } else {
+    usage(argv[0]);
+    return 2;
+  }
+  if (!configured) {
+    fprintf(stderr, "Decoder table for %s rejected\n", protocol);
+    return 1;
+  }
+
+  CANStatsTable stats;
+  if (!stats.allocate()) {
+    fprintf(stderr, "CAN statistics table allocation failed\n");
+    return 1;
+  }
+  BusLoadMeter bus_load;
+  ECUData data;
+  CANPipeline pipeline(stats, bus_load, decoder, data);
+  CANSupervisor supervisor;
+
+  CANFilter filter;
+  bool filter_valid = use_filter && decoder.acceptanceFilter(filter.code, filter.dont_care);
+  SocketCANTransport transport(interface_name);
+  static CANReplay replay;   // Holds the read buffer
+  FILE* replay_file = NULL;
+  if (replay_path) {
+    replay_file = strcmp(replay_path, "-") == 0 ? stdin : fopen(replay_path, "rb");
+    if (!replay_file) {
+      perror(replay_path);
+      return 1;
+    }
+  } else if (!transport.begin(bitrate, filter_valid ? &filter : nullptr, false)) {
+    return 1;
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  uint64_t start_ns = monotonicNanos();
+  uint32_t now_ms = (uint32_t)(start_ns / 1000000);
+  bus_load.reset((uint32_t)(start_ns / 1000));
+  supervisor.driverStarted(now_ms);
+  if (replay_file) replay.begin(readLogFile, replay_file, replay_speed, (uint32_t)(start_ns / 1000));
+  printf("Decoding %s on %s: %d frames, %d signals%s\n", protocol, replay_path ? replay_path : transport.name(),
+         decoder.frameCount(), decoder.signalCount(), filter_valid && !replay_path ? ", kernel filter" : "");
+
+  uint64_t frames = 0, pipeline_ns = 0;
+  uint64_t report_frames = 0, report_ns = 0;
+  uint32_t last_report_ms = now_ms;
+  uint32_t last_supervised_ms = now_ms;
+
+  while (!host_stop) {
+    RxFrame frame;
+    uint32_t batch = 0;
+    uint64_t batch_start = 0;
+    uint32_t batch_ms = 0, batch_us = 0;
+    if (replay_file) {
+      // Everything due now; sleep towards the next frame when paced
+      batch_start = monotonicNanos();
+      batch_ms = (uint32_t)(batch_start / 1000000);
+      batch_us = (uint32_t)(batch_start / 1000);
+      batch = replay.service(batch_us, HOST_BATCH_FRAMES, [&](const RxFrame& replayed) {
+        pipeline.process(replayed, batch_ms, batch_us);
+        return true;
+      });
+      uint32_t due_us;
+      if (batch == 0 && replay.finished()) break;
+      if (batch == 0 && replay.nextDue(due_us) && (int32_t)(due_us - batch_us) > 0) {
+        usleep(due_us - batch_us < 10000 ? due_us - batch_us : 10000);
+      }
+    } else {
+      // Block for the first frame, then drain without waiting
+      while (batch < HOST_BATCH_FRAMES && transport.receive(frame, batch ? 0 : supervisor.pollIntervalMs())) {
+        if (batch == 0) {
+          batch_start = monotonicNanos();
+          batch_ms = (uint32_t)(batch_start / 1000000);
+          batch_us = (uint32_t)(batch_start / 1000);
+        }
+        pipeline.process(frame, batch_ms, batch_us);
+        batch++;
+      }
+    }
+
+    uint64_t now_ns = monotonicNanos();
+    now_ms = (uint32_t)(now_ns / 1000000);
+    pipeline.finishBatch(now_ms, (uint32_t)(now_ns / 1000));
+    if (batch) {
+      // Includes the receive syscalls or log parsing - run perf for the split
+      frames += batch;
+      pipeline_ns += now_ns - batch_start;
+    }
+
+    if (now_ms - last_supervised_ms >= supervisor.pollIntervalMs()) {
+      last_supervised_ms = now_ms;
+      CANDriverStatus status;
+      uint8_t events;
+      if (transport.status(status, events)) {
+        CANSupervisorAction action = supervisor.update(status, events, now_ms);
+        if (action != CAN_ACTION_NONE) transport.recover(action);
+      }
+    }
+
+    if (now_ms - last_report_ms >= HOST_REPORT_MS) {
+      uint64_t interval_frames = frames - report_frames;
+      uint64_t interval_ns = pipeline_ns - report_ns;
+      const CANErrorStats& errors = supervisor.stats();
+      printf("%8.0f frames/s  %6.0f ns/frame  load %5.1f%%  IDs %4d  valid %08X  RPM %5.0f  missed %u  bus-off %u\n",
+             interval_frames * 1000.0 / (now_ms - last_report_ms),
+             interval_frames ? (double)interval_ns / interval_frames : 0.0, bus_load.load(BUS_LOAD_1S, bitrate),
+             stats.idCount(), data.signal_valid, data.rpm, errors.rx_missed, errors.bus_off);
+      fflush(stdout);
+      report_frames = frames;
+      report_ns = pipeline_ns;
+      last_report_ms = now_ms;
+    }
+  }
+
+  double seconds = (monotonicNanos() - start_ns) / 1e9;
+  printf("\n%llu frames in %.1f s (%.0f frames/s), %.0f ns/frame, %d IDs, %u untracked\n",
+         (unsigned long long)frames, seconds, frames / seconds, frames ? (double)pipeline_ns / frames : 0.0,
+         stats.idCount(), stats.untrackedFrames());
+  if (replay_file) {
+    printf("Replay: %u log lines, %u skipped\n", replay.reader().lineCount(), replay.reader().skippedLines());
+    if (replay_file != stdin) fclose(replay_file);
+  }
+  transport.end();
+  return 0;
+}
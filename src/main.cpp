@@ -1,13 +1,36 @@
 // Link G4X Monitor - Clean CAN Bus Implementation
 #include <Arduino.h>
 #include <M5Unified.h>
-#include <ESP32-TWAI-CAN.hpp>
 #include <Preferences.h>
+#include <SD.h>
+#include <SPI.h>
+#include <esp_vfs_fat.h>
+#include <unistd.h>
+#include "can_autodetect.h"
+#include "can_capture.h"
+#include "can_log_format.h"
+#include "can_log_writer.h"
+#include "can_pipeline.h"
+#include "can_replay.h"
+#include "can_ring.h"
+#include "can_stats.h"
+#include "can_supervisor.h"
+#include "can_transport_twai.h"
+#include "bus_load.h"
+#include "ecu_commands.h"
+#include "ecu_data.h"
+#include "pipeline_bench.h"
+#include "seqlock.h"
+#include "session_log.h"
+#include "signal_changes.h"
+#include "signal_decoder.h"
+#include "units.h"
 
 // ========== CONFIGURATION ==========
-enum UnitSystem {
-  METRIC = 0,    // Celsius, kPa, km/h
-  IMPERIAL = 1   // Fahrenheit, PSI, mph
+enum StreamProtocol {
+  STREAM_CUSTOM = 0,        // Link custom stream (0x500-0x502)
+  STREAM_HALTECH_IC7 = 1,   // Haltech IC7 broadcast at base_can_id
+  STREAM_GENERIC_DASH2 = 2  // Link Generic Dash 2 (1000-1003)
 };
 
 enum LoggingMode {
@@ -41,10 +64,13 @@ struct Config {
   uint32_t base_can_id = 864;           // Base CAN ID for Haltech IC7
   uint32_t can_speed = 1000000;         // CAN bus speed (1000 kbps / 1 Mbps)
   bool simulation_mode = true;          // Start in simulation mode
-  bool use_custom_streams = true;       // Use custom stream configuration
+  StreamProtocol stream_protocol = STREAM_CUSTOM;  // ECU CAN stream to decode
+  bool can_auto_detect = true;          // Find bitrate and stream type on the bus
   UnitSystem units = METRIC;            // Unit system (metric/imperial)
 
-  // CAN Logging Configuration (UI only - actual logging not implemented)
+  // CAN Logging Configuration (LOG_FULL captures frames, see can_capture.h;
+  // LOG_CHANGES logs decoded signals past a deadband, see signal_changes.h;
+  // LOG_SESSION records columns of signals on demand, see session_log.h)
   LoggingMode logging_mode = LOG_DISABLED;     // Logging mode
   LogDetail log_detail = LOG_BASIC;            // Detail level
   BufferSize buffer_size = BUFFER_MEDIUM;      // Buffer size
@@ -63,25 +89,16 @@ unsigned long last_blink_time = 0;
 bool global_blink_state = false;
 
 // ========== UNIT CONVERSION FUNCTIONS ==========
-float convertTemperature(float celsius) {
-  if (config.units == IMPERIAL) {
-    return celsius * 9.0f / 5.0f + 32.0f; // Convert to Fahrenheit
-  }
-  return celsius; // Return Celsius
-}
+// Metric -> display coefficients per signal for config.units; rebuilt by
+// applyUnitSystem() whenever the unit system changes
+DisplayScale display_scales[SIG_COUNT];
 
-float convertPressure(float kpa) {
-  if (config.units == IMPERIAL) {
-    return kpa * 0.145038f; // Convert to PSI
-  }
-  return kpa; // Return kPa
+void applyUnitSystem() {
+  buildDisplayScales(config.units, display_scales);
 }
 
-float convertSpeed(float kmh) {
-  if (config.units == IMPERIAL) {
-    return kmh * 0.621371f; // Convert to mph
-  }
-  return kmh; // Return km/h
+float displayValue(SignalId signal, float metric) {
+  return display_scales[signal].apply(metric);
 }
 
 const char* getTemperatureUnit() {
@@ -92,6 +109,11 @@ const char* getPressureUnit() {
   return (config.units == IMPERIAL) ? "PSI" : "KPA";
 }
 
+// Oil and fuel pressure gauges
+const char* getFluidPressureUnit() {
+  return (config.units == IMPERIAL) ? "PSI" : "BAR";
+}
+
 const char* getSpeedUnit() {
   return (config.units == IMPERIAL) ? "MPH" : "KM/H";
 }
@@ -100,7 +122,33 @@ const char* getUnitSystemName() {
   return (config.units == IMPERIAL) ? "IMPERIAL" : "METRIC";
 }
 
+const char* getStreamProtocolName() {
+  switch (config.stream_protocol) {
+    case STREAM_CUSTOM: return "CUSTOM";
+    case STREAM_HALTECH_IC7: return "HALTECH IC7";
+    case STREAM_GENERIC_DASH2: return "GENERIC DASH 2";
+    default: return "CUSTOM";
+  }
+}
+
+uint16_t getStreamProtocolColor() {
+  switch (config.stream_protocol) {
+    case STREAM_HALTECH_IC7: return M5.Display.color565(255, 100, 255);
+    case STREAM_GENERIC_DASH2: return M5.Display.color565(100, 200, 255);
+    default: return M5.Display.color565(0, 255, 200);
+  }
+}
+
 const char* getCANSpeedName() {
+  if (config.can_auto_detect) {
+    switch (config.can_speed) {
+      case 125000: return "AUTO 125K";
+      case 250000: return "AUTO 250K";
+      case 500000: return "AUTO 500K";
+      case 1000000: return "AUTO 1000K";
+      default: return "AUTO";
+    }
+  }
   switch (config.can_speed) {
     case 125000: return "125 KBPS";
     case 250000: return "250 KBPS";
@@ -156,68 +204,55 @@ bool isLoggingEnabled() {
 }
 
 // ========== CAN MONITORING SYSTEM ==========
-struct CANFrameStats {
-  uint32_t can_id;
-  uint32_t packet_count;
-  uint32_t last_seen;
-  uint8_t data_length;
-  uint8_t last_data[8];
-  bool active;
-};
-
-#define MAX_MONITORED_FRAMES 10
-CANFrameStats can_frame_stats[MAX_MONITORED_FRAMES];
+// Per-ID counters for every standard ID plus hashed 29-bit IDs
+CANStatsTable can_stats;
 uint32_t total_can_frames = 0;
-uint32_t can_errors = 0;
 uint32_t last_can_stats_reset = 0;
+uint32_t can_filter_accepted = 0;      // Frames inside the acceptance filter
+uint32_t can_filter_outside = 0;       // Frames it would reject (promiscuous only)
+BusLoadMeter can_bus_load;
+
+// CAN MON tab paging through every ID seen
+#define CAN_MONITOR_ROWS 8
+uint16_t can_monitor_page = 0;
+
+// Frames handed from the CAN receive task to loop()
+#define CAN_RX_RING_SIZE 512
+CANRing<CAN_RX_RING_SIZE> can_rx_ring;
+
+// Bus error supervision runs in the CAN receive task; CAN MON reads the
+// totals through a snapshot and asks for resets through a flag
+CANSupervisor can_supervisor;
+SeqLock<CANErrorStats> can_error_snapshot;
+volatile bool can_error_reset_requested = false;
+volatile bool can_restart_requested = false;
+
+// LOG_FULL: every frame the receive task takes from the driver, as 16-byte
+// records in PSRAM (replayed frames are not captured)
+CANCaptureRing can_capture;
 
 // ========== CAN MONITORING FUNCTIONS ==========
+extern CANPipeline can_pipeline;   // Defined with the signal decoder
+
 void initCANMonitoring() {
-  for (int i = 0; i < MAX_MONITORED_FRAMES; i++) {
-    can_frame_stats[i].can_id = 0;
-    can_frame_stats[i].packet_count = 0;
-    can_frame_stats[i].last_seen = 0;
-    can_frame_stats[i].data_length = 0;
-    can_frame_stats[i].active = false;
-    memset(can_frame_stats[i].last_data, 0, 8);
+  if (!can_stats.allocated() && !can_stats.allocate()) {
+    Serial.println("CAN statistics table allocation failed!");
   }
+  can_stats.clear();
+  can_monitor_page = 0;
   total_can_frames = 0;
-  can_errors = 0;
+  can_error_reset_requested = true;
+  can_rx_ring.resetCounters();
+  can_pipeline.resetCounters();
+  can_filter_accepted = 0;
+  can_filter_outside = 0;
+  can_bus_load.reset(micros());
   last_can_stats_reset = millis();
 }
 
-void updateCANStats(uint32_t can_id, const uint8_t* data, uint8_t length) {
+void updateCANStats(const RxFrame& frame) {
   total_can_frames++;
-
-  // Find existing frame or create new entry
-  int frame_index = -1;
-  for (int i = 0; i < MAX_MONITORED_FRAMES; i++) {
-    if (can_frame_stats[i].active && can_frame_stats[i].can_id == can_id) {
-      frame_index = i;
-      break;
-    }
-  }
-
-  // If not found, find empty slot
-  if (frame_index == -1) {
-    for (int i = 0; i < MAX_MONITORED_FRAMES; i++) {
-      if (!can_frame_stats[i].active) {
-        frame_index = i;
-        can_frame_stats[i].can_id = can_id;
-        can_frame_stats[i].active = true;
-        can_frame_stats[i].packet_count = 0;
-        break;
-      }
-    }
-  }
-
-  // Update stats if we have a valid index
-  if (frame_index >= 0) {
-    can_frame_stats[frame_index].packet_count++;
-    can_frame_stats[frame_index].last_seen = millis();
-    can_frame_stats[frame_index].data_length = length;
-    memcpy(can_frame_stats[frame_index].last_data, data, (length < 8) ? length : 8);
-  }
+  can_stats.update(frame, millis());
 }
 
 void resetCANStats() {
@@ -225,11 +260,7 @@ void resetCANStats() {
 }
 
 int countActiveFrames() {
-  int count = 0;
-  for (int i = 0; i < MAX_MONITORED_FRAMES; i++) {
-    if (can_frame_stats[i].active) count++;
-  }
-  return count;
+  return can_stats.idCount();
 }
 
 // ========== GLOBAL ANIMATION SYSTEM ==========
@@ -263,140 +294,483 @@ const char* getConfigTabSubtitle(ConfigTab tab) {
 }
 
 // ========== CAN BUS CONFIGURATION ==========
-// Custom Stream Configuration
-const uint32_t CUSTOM_STREAM_ID_1 = 0x500;  // Primary Engine Data
-const uint32_t CUSTOM_STREAM_ID_2 = 0x501;  // Lambda & Fuel Data
-const uint32_t CUSTOM_STREAM_ID_3 = 0x502;  // Pressures & Status
-
 unsigned long last_can_message = 0;
 
-// ========== ECU DATA STRUCTURE ==========
-struct ECUData {
-  // Primary Engine Data (Frame 0x500)
-  float rpm = 2150;
-  float tps = 15;
-  float aps = 18;
-  float mgp = 5;
-  float ect = 87;
-  float iat = 28;
-  float battery = 12.5;
-  
-  // Lambda & Fuel Data (Frame 0x501)
-  float lambda = 1.0;
-  float lambda_target = 1.0;
-  float injector_duty = 20;
-  float ethanol_percent = 85;
-  
-  // Pressures & Status (Frame 0x502)
-  float oil_press = 50;
-  float fuel_press = 300;
-  uint8_t current_boost_map = 1;
-  uint8_t current_ethrottle_map = 1;
-  
-  // Control System Status
-  bool boost_control_active = false;
-  bool launch_control_active = false;
-  bool anti_lag_active = false;
-
-  // Control interface variables
-  float boost_adjustment = 0.0;
-  int launch_rpm = 4000;
-  bool system_ready = true;
-
-  // Additional data fields (not in CAN stream but needed for display)
-  float speed = 0.0;
-};
-
 ECUData ecu_data;
 
+// ========== CAN RECEIVE TASK ==========
+// A pinned task blocks on the CAN transport and drains every pending
+// frame into can_rx_ring; loop() consumes the ring in readCANData().
+#define CAN_TX_PIN GPIO_NUM_26
+#define CAN_RX_PIN GPIO_NUM_27
+#define CAN_DRIVER_RX_QUEUE 64        // TWAI driver RX queue length
+#define CAN_RX_TASK_STACK 4096
+#define CAN_RX_TASK_PRIORITY (configMAX_PRIORITIES - 2)
+#define CAN_RX_TASK_CORE 0            // Keep RX off the Arduino loop() core
+#define CAN_RX_BLOCK_MS CAN_SUPERVISE_MS  // Wake periodically to supervise and honour stop requests
+
+TWAITransport twai_transport(CAN_TX_PIN, CAN_RX_PIN, CAN_DRIVER_RX_QUEUE, ECU_COMMAND_BURST);
+CANTransport& can_transport = twai_transport;
+
+TaskHandle_t can_rx_task_handle = NULL;
+volatile bool can_rx_task_stop = false;
+volatile TaskHandle_t can_rx_task_waiter = NULL;   // Notified once the task has exited
+
+// Poll controller status and alerts, and act on bus-off. Runs in the
+// receive task so recovery never waits on rendering.
+void superviseCANBus() {
+  CANDriverStatus status;
+  uint8_t events;
+  if (!can_transport.status(status, events)) return;
+
+  if (can_error_reset_requested) {
+    can_error_reset_requested = false;
+    can_supervisor.clearStats();
+  }
+
+  switch (CANSupervisorAction action = can_supervisor.update(status, events, millis())) {
+    case CAN_ACTION_INITIATE_RECOVERY:
+    case CAN_ACTION_START:
+      can_transport.recover(action);
+      break;
+    case CAN_ACTION_RESTART_DRIVER:
+      can_restart_requested = true;   // loop() reinstalls the driver
+      break;
+    case CAN_ACTION_NONE:
+      break;
+  }
+  can_error_snapshot.publish(can_supervisor.stats());
+}
+
+void canReceiveTask(void* param) {
+  RxFrame frame;
+  uint32_t last_supervised = millis();
+
+  while (!can_rx_task_stop) {
+    // Block until the driver has something, then drain the whole queue
+    if (can_transport.receive(frame, can_supervisor.pollIntervalMs())) {
+      do {
+        if (can_capture.allocated()) can_capture.push(frame);
+        can_rx_ring.push(frame);
+      } while (can_transport.receive(frame, 0));
+    }
+
+    if (millis() - last_supervised >= can_supervisor.pollIntervalMs()) {
+      last_supervised = millis();
+      superviseCANBus();
+    }
+  }
+
+  TaskHandle_t waiter = can_rx_task_waiter;
+  can_rx_task_handle = NULL;
+  if (waiter != NULL) xTaskNotifyGive(waiter);
+  vTaskDelete(NULL);
+}
+
+bool startCANReceiveTask() {
+  if (can_rx_task_handle != NULL) return true;
+
+  can_rx_task_stop = false;
+  BaseType_t result = xTaskCreatePinnedToCore(canReceiveTask, "can_rx", CAN_RX_TASK_STACK, NULL,
+                                              CAN_RX_TASK_PRIORITY, &can_rx_task_handle, CAN_RX_TASK_CORE);
+  if (result != pdPASS) {
+    can_rx_task_handle = NULL;
+    Serial.println("CAN receive task creation failed!");
+    return false;
+  }
+  return true;
+}
+
+// Returns once the task has exited, so the driver can be ended or the
+// ring reallocated under it. The task sees the request within one
+// CAN_RX_BLOCK_MS read timeout.
+void stopCANReceiveTask() {
+  if (can_rx_task_handle == NULL) return;
+
+  can_rx_task_waiter = xTaskGetCurrentTaskHandle();
+  can_rx_task_stop = true;
+  while (can_rx_task_handle != NULL) {
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_RX_BLOCK_MS * 10)) == 0) {
+      Serial.println("CAN receive task still stopping");
+    }
+  }
+  can_rx_task_waiter = NULL;
+}
+
+bool startLogWriter();
+void stopLogWriter();
+bool sessionRecording();
+
+bool logWriterStopping();
+extern bool log_writer_restart;
+
+// Size the capture ring for the logging mode and buffer size, and start
+// the SD card writer for LOG_FULL frames or LOG_CHANGES signal changes
+// when there is a card (LOG_SESSION starts it on demand). The ring is
+// only reallocated while the receive task is stopped; it restarts after.
+// A writer that is still stopping calls this again once it has.
+void configureLogging() {
+  uint32_t frames = config.logging_mode == LOG_FULL ? getBufferFrameCount() : 0;
+  if (frames != can_capture.capacity()) {
+    stopLogWriter();
+    if (logWriterStopping()) {
+      log_writer_restart = true;   // The writer reads the ring until it is gone
+      return;
+    }
+    bool receiving = can_rx_task_handle != NULL;
+    stopCANReceiveTask();
+
+    if (frames == 0) {
+      can_capture.release();
+    } else if (!can_capture.allocate(frames)) {
+      Serial.printf("Frame capture buffer allocation failed (%lu frames)\n", frames);
+    } else {
+      Serial.printf("Frame capture: %lu frames (%d bytes)\n", frames, (int)(frames * sizeof(CANLogRecord)));
+    }
+    if (receiving) startCANReceiveTask();
+  }
+  if (can_capture.allocated() || config.logging_mode == LOG_CHANGES) {
+    startLogWriter();
+  } else if (config.logging_mode != LOG_SESSION || !sessionRecording()) {
+    stopLogWriter();
+  }
+}
+
+// ========== CAN ACCEPTANCE FILTER ==========
+// Derived from the active decoder so the TWAI controller drops unrelated
+// bus traffic before it reaches the ISR. CAN MON can override it to see
+// every ID on the bus.
+bool can_running = false;
+bool can_promiscuous = false;          // CAN MON override: accept all IDs
+bool can_filter_valid = false;         // code/dont_care describe the decoder
+bool can_filter_in_hardware = false;   // Driver started with the filter
+uint16_t can_filter_code = 0;
+uint16_t can_filter_dont_care = 0x7FF;
+
+bool canFilterMatches(const RxFrame& frame) {
+  if (!can_filter_valid) return true;
+  if (frame.extended) return false;
+  return ((frame.identifier ^ can_filter_code) & ~can_filter_dont_care & 0x7FF) == 0;
+}
+
 // ========== CAN BUS FUNCTIONS ==========
 bool initializeCAN() {
-  ESP32Can.setPins(GPIO_NUM_26, GPIO_NUM_27);
-  
-  // Convert speed to enum
-  TwaiSpeed speed = TWAI_SPEED_500KBPS;
-  switch (config.can_speed) {
-    case 125000: speed = TWAI_SPEED_125KBPS; break;
-    case 250000: speed = TWAI_SPEED_250KBPS; break;
-    case 500000: speed = TWAI_SPEED_500KBPS; break;
-    case 1000000: speed = TWAI_SPEED_1000KBPS; break;
-    default: speed = TWAI_SPEED_500KBPS; break;
-  }
-  
-  if (!ESP32Can.begin(speed)) {
+  CANFilter filter = {can_filter_code, can_filter_dont_care};
+  can_filter_in_hardware = can_filter_valid && !can_promiscuous;
+
+  if (!can_transport.begin(config.can_speed, can_filter_in_hardware ? &filter : nullptr, false)) {
     Serial.println("CAN initialization failed!");
     return false;
   }
+  can_supervisor.driverStarted(millis());
+  can_restart_requested = false;
+
+  if (!startCANReceiveTask()) {
+    can_transport.end();
+    return false;
+  }
   
+  can_running = true;
   Serial.printf("CAN initialized at %d bps\n", config.can_speed);
+  if (can_filter_in_hardware) {
+    Serial.printf("CAN acceptance filter: 0x%03X, don't care 0x%03X\n", can_filter_code, can_filter_dont_care);
+  } else {
+    Serial.println("CAN acceptance filter: accept all");
+  }
   return true;
 }
 
-// ========== CUSTOM STREAM PARSING ==========
-void parseCustomStream1(const twai_message_t& message) {
-  // Frame 0x500 - Primary Engine Data
-  if (message.data_length_code >= 8) {
-    ecu_data.rpm = ((message.data[1] << 8) | message.data[0]) * 0.1;
-    ecu_data.tps = message.data[2] * 0.5;
-    ecu_data.aps = message.data[3] * 0.5;
-    ecu_data.mgp = ((message.data[5] << 8) | message.data[4]) * 0.1;
-    ecu_data.ect = message.data[6] - 40;
-    ecu_data.iat = message.data[7] - 40;
+void shutdownCAN() {
+  stopCANReceiveTask();
+  can_transport.end();
+  can_running = false;
+}
+
+// Restart a running driver so a new acceptance filter takes effect
+void restartCANIfRunning() {
+  if (!can_running) return;
+  shutdownCAN();
+  delay(100);
+  if (!initializeCAN()) {
+    Serial.println("CAN restart failed! Falling back to simulation mode");
+    config.simulation_mode = true;
   }
 }
 
-void parseCustomStream2(const twai_message_t& message) {
-  // Frame 0x501 - Lambda & Fuel Data
-  if (message.data_length_code >= 8) {
-    ecu_data.lambda = ((message.data[1] << 8) | message.data[0]) * 0.001;
-    ecu_data.lambda_target = ((message.data[3] << 8) | message.data[2]) * 0.001;
-    ecu_data.injector_duty = message.data[4] * 0.5;
-    ecu_data.ethanol_percent = message.data[5];
-    ecu_data.battery = ((message.data[7] << 8) | message.data[6]) * 0.01;
+// ========== ECU COMMANDS ==========
+// 0x600 commands from the control page, sent from loop() by the queue
+ECUCommandQueue ecu_commands;
+
+bool transmitECUCommand(const uint8_t* data) {
+  return can_transport.transmit(ECU_COMMAND_ID, false, data, 8);   // Never waits on a full TX queue
+}
+
+void sendECUCommand(ECUCommandType type, uint8_t value) {
+  if (!can_running) return;   // Simulation only changes ecu_data
+  ecu_commands.request(type, value, millis());
+}
+
+void sendBoostAdjustment() {
+  int8_t value = (int8_t)constrain(lroundf(ecu_data.boost_adjustment), -10, 10);
+  sendECUCommand(CMD_BOOST_ADJUST, (uint8_t)value);
+}
+
+// ========== STREAM DECODING ==========
+SignalDecoder signal_decoder;
+
+// Statistics, bus load and decode for each received frame - the same
+// path the native host build drives from SocketCAN
+CANPipeline can_pipeline(can_stats, can_bus_load, signal_decoder, ecu_data);
+
+// Load the compiled frame layouts for the selected stream type
+void configureSignalDecoder() {
+  switch (config.stream_protocol) {
+    case STREAM_CUSTOM:
+      if (!signal_decoder.configure(CUSTOM_STREAM_FRAMES.data(), CUSTOM_STREAM_FRAMES.size())) {
+        Serial.println("Custom stream decoder table rejected!");
+      }
+      break;
+    case STREAM_HALTECH_IC7:
+      if (!signal_decoder.configure(HALTECH_IC7_FRAMES.data(), HALTECH_IC7_FRAMES.size(), config.base_can_id)) {
+        Serial.printf("Haltech IC7 layout does not fit base ID 0x%03lX!\n", config.base_can_id);
+      }
+      break;
+    case STREAM_GENERIC_DASH2:
+      if (!signal_decoder.configure(GENERIC_DASH2_FRAMES.data(), GENERIC_DASH2_FRAMES.size())) {
+        Serial.println("Generic Dash 2 decoder table rejected!");
+      }
+      break;
   }
+  Serial.printf("Signal decoder: %d frames, %d signals\n",
+                signal_decoder.frameCount(), signal_decoder.signalCount());
+
+  can_filter_valid = signal_decoder.acceptanceFilter(can_filter_code, can_filter_dont_care);
+
+  // Only the custom stream echoes command state back in 0x502
+  ecu_commands.setEchoAvailable(config.stream_protocol == STREAM_CUSTOM);
+}
+
+// ========== CAN AUTO-DETECT ==========
+// With CAN SPEED set to AUTO the controller is cycled through the
+// supported bitrates in listen-only mode (it never ACKs or sends error
+// frames, so a wrong guess cannot disturb the bus) until valid frames
+// arrive. The IDs seen at that bitrate are fingerprinted against the
+// known stream layouts, and the result is saved as the normal can_speed
+// and stream_proto settings. Live mode never joins the bus in normal
+// mode on an unconfirmed bitrate: every start scans first, from the saved
+// bitrate, so an unchanged bus locks within a few frames. Once running,
+// the scan only runs again after nothing has decoded for a while.
+#define AUTOBAUD_DWELL_MS 100          // Listen time per bitrate
+#define AUTOBAUD_LOCK_FRAMES 2         // Valid frames that confirm a bitrate
+#define DETECT_FINGERPRINT_MS 1000     // Longest wait for a complete layout
+#define DETECT_IDLE_MS 1500            // No decoded signal this long -> rescan
+#define DETECT_IDLE_MAX_MS 60000       // Backoff cap while the bus is unrecognised
+
+const uint32_t CAN_BITRATES[] = {125000, 250000, 500000, 1000000};
+const uint8_t CAN_BITRATE_COUNT = sizeof(CAN_BITRATES) / sizeof(CAN_BITRATES[0]);
+
+enum CANDetectState {
+  DETECT_IDLE,           // Normal operation, watching for decoded data
+  DETECT_BAUD_SCAN,      // Listen-only, waiting for frames at one bitrate
+  DETECT_FINGERPRINT     // Bitrate locked, collecting the ID set
+};
+
+CANDetectState can_detect_state = DETECT_IDLE;
+ProtocolDetector protocol_detector;
+uint8_t can_detect_rate = 0;              // Index into CAN_BITRATES
+uint8_t can_detect_lock_frames = 0;
+unsigned long can_detect_started = 0;     // Current dwell / fingerprint start
+unsigned long can_detect_last_decoded = 0;
+uint32_t can_detect_idle_ms = DETECT_IDLE_MS;
+
+void saveConfig();
+
+bool beginListenOnly(uint32_t bitrate) {
+  return can_transport.begin(bitrate, nullptr, true);
 }
 
-void parseCustomStream3(const twai_message_t& message) {
-  // Frame 0x502 - Pressures & Status
-  if (message.data_length_code >= 8) {
-    ecu_data.oil_press = ((message.data[1] << 8) | message.data[0]) * 0.1;
-    ecu_data.fuel_press = ((message.data[3] << 8) | message.data[2]) * 0.1;
-    ecu_data.current_boost_map = message.data[4];
-    ecu_data.current_ethrottle_map = message.data[5];
-    ecu_data.launch_control_active = (message.data[6] & 0x01) != 0;
-    ecu_data.anti_lag_active = (message.data[6] & 0x02) != 0;
+// Live bus, but none of our layouts (or no listen-only driver): wait
+// longer before scanning again
+void backOffCANAutoDetect() {
+  can_detect_idle_ms = min((uint32_t)(can_detect_idle_ms * 2), (uint32_t)DETECT_IDLE_MAX_MS);
+}
+
+// Listen-only at the current scan bitrate. A driver that will not start
+// ends the scan - it would otherwise look like a silent bus - and backs
+// off the next one; false then, and the caller restarts the configured
+// settings.
+bool listenForAutoDetect() {
+  if (beginListenOnly(CAN_BITRATES[can_detect_rate])) return true;
+  Serial.printf("CAN auto-detect: listen-only start at %lu bps failed\n", CAN_BITRATES[can_detect_rate]);
+  can_detect_state = DETECT_IDLE;
+  can_detect_last_decoded = millis();
+  backOffCANAutoDetect();
+  return false;
+}
+
+bool startCANAutoDetect() {
+  if (can_running) shutdownCAN();
+  if (can_detect_state != DETECT_IDLE) can_transport.end();
+
+  // Start from the saved bitrate - usually still right
+  can_detect_rate = 0;
+  for (uint8_t i = 0; i < CAN_BITRATE_COUNT; i++) {
+    if (CAN_BITRATES[i] == config.can_speed) can_detect_rate = i;
   }
+
+  protocol_detector.clear();
+  can_detect_lock_frames = 0;
+  can_detect_state = DETECT_BAUD_SCAN;
+  can_detect_started = millis();
+  if (!listenForAutoDetect()) return false;
+  Serial.println("CAN auto-detect: scanning bitrates (listen-only)");
+  return true;
+}
+
+// Leave listen-only mode without starting the normal driver
+void stopCANAutoDetect() {
+  if (can_detect_state == DETECT_IDLE) return;
+  can_transport.end();
+  can_detect_state = DETECT_IDLE;
+}
+
+void finishCANAutoDetect(int protocol) {
+  stopCANAutoDetect();
+  config.can_speed = CAN_BITRATES[can_detect_rate];
+
+  if (protocol != DETECT_NO_MATCH) {
+    config.stream_protocol = (StreamProtocol)protocol;
+    can_detect_idle_ms = DETECT_IDLE_MS;
+  } else {
+    backOffCANAutoDetect();   // Keep the configured stream
+  }
+  Serial.printf("CAN auto-detect: %lu bps, %s%s (%lu frames)\n", config.can_speed, getStreamProtocolName(),
+                protocol == DETECT_NO_MATCH ? " (no layout matched)" : "", protocol_detector.frameCount());
+
+  saveConfig();
+  configureSignalDecoder();
+  can_detect_last_decoded = millis();
+  if (!initializeCAN()) {
+    Serial.println("CAN start after auto-detect failed! Falling back to simulation mode");
+    config.simulation_mode = true;
+  }
+}
+
+// Start live mode: through a listen-only scan with auto-detect on,
+// straight onto the configured bitrate otherwise (or if listen-only will
+// not start)
+bool startLiveCAN() {
+  if (config.can_auto_detect && startCANAutoDetect()) return true;
+  return initializeCAN();
+}
+
+// Called every loop() in live mode: runs the scan, or watches a running
+// bus and rescans once the current settings stop decoding
+void serviceCANAutoDetect() {
+  unsigned long now = millis();
+
+  if (can_detect_state == DETECT_IDLE) {
+    if (!config.can_auto_detect || !can_running) return;
+    if (ecu_data.signal_valid) {
+      can_detect_last_decoded = now;
+    } else if (now - can_detect_last_decoded > can_detect_idle_ms) {
+      Serial.printf("No decodable CAN data for %lu ms\n", can_detect_idle_ms);
+      if (!startLiveCAN()) {
+        Serial.println("CAN restart failed! Falling back to simulation mode");
+        config.simulation_mode = true;
+      }
+    }
+    return;
+  }
+
+  // No RX task while listening - drain the driver here
+  RxFrame frame;
+  while (can_transport.receive(frame, 0)) {
+    updateCANStats(frame);
+    protocol_detector.addFrame(frame.identifier, frame.extended, frame.data_length);
+
+    if (can_detect_state == DETECT_BAUD_SCAN && ++can_detect_lock_frames >= AUTOBAUD_LOCK_FRAMES) {
+      Serial.printf("CAN auto-detect: traffic at %lu bps\n", CAN_BITRATES[can_detect_rate]);
+      can_detect_state = DETECT_FINGERPRINT;
+      can_detect_started = now;
+    }
+  }
+
+  if (can_detect_state == DETECT_BAUD_SCAN) {
+    if (now - can_detect_started < AUTOBAUD_DWELL_MS) return;
+
+    // Nothing valid at this bitrate - try the next one
+    can_transport.end();
+    can_detect_rate = (can_detect_rate + 1) % CAN_BITRATE_COUNT;
+    can_detect_lock_frames = 0;
+    protocol_detector.clear();
+    can_detect_started = now;
+    if (!listenForAutoDetect() && !initializeCAN()) {
+      Serial.println("CAN restart failed! Falling back to simulation mode");
+      config.simulation_mode = true;
+    }
+    return;
+  }
+
+  // Candidates in StreamProtocol order
+  const DetectCandidate candidates[] = {
+    {CUSTOM_STREAM_FRAMES.data(), (uint8_t)CUSTOM_STREAM_FRAMES.size(), 0},
+    {HALTECH_IC7_FRAMES.data(), (uint8_t)HALTECH_IC7_FRAMES.size(), (uint16_t)config.base_can_id},
+    {GENERIC_DASH2_FRAMES.data(), (uint8_t)GENERIC_DASH2_FRAMES.size(), 0},
+  };
+  const uint8_t candidate_count = sizeof(candidates) / sizeof(candidates[0]);
+
+  int protocol = protocol_detector.completeMatch(candidates, candidate_count);
+  if (protocol == DETECT_NO_MATCH) {
+    if (now - can_detect_started < DETECT_FINGERPRINT_MS) return;
+    protocol = protocol_detector.bestMatch(candidates, candidate_count);
+  }
+  finishCANAutoDetect(protocol);
 }
 
 bool readCANData() {
-  twai_message_t message;
+  RxFrame frame;
   bool data_received = false;
+  uint32_t now_ms = millis();
+  uint32_t now_us = micros();
 
-  // Check for received messages
-  if (ESP32Can.readFrame(message, 0) == ESP_OK) {
+  auto check_status_echo = [](const RxFrame& decoded) {
+    if (!decoded.extended && decoded.identifier == CUSTOM_STREAM_ID_3 && config.stream_protocol == STREAM_CUSTOM) {
+      ecu_commands.onStatusEcho(ecu_data, millis());
+    }
+  };
+
+  // After a long redraw the ring holds several frames per ID: decode only
+  // the newest of each, critical signals first
+  bool backlogged = can_rx_ring.depth() > CAN_BACKLOG_FRAMES;
+
+  // Drain everything the receive task has queued, bounded so a flooded
+  // bus cannot starve touch and rendering
+  for (uint32_t n = 0; n < CAN_RX_RING_SIZE && can_rx_ring.pop(frame); n++) {
     data_received = true;
-    last_can_message = millis();
 
-    // Update CAN monitoring statistics
-    updateCANStats(message.identifier, message.data, message.data_length_code);
-
-    if (config.use_custom_streams) {
-      switch (message.identifier) {
-        case CUSTOM_STREAM_ID_1:
-          parseCustomStream1(message);
-          break;
-        case CUSTOM_STREAM_ID_2:
-          parseCustomStream2(message);
-          break;
-        case CUSTOM_STREAM_ID_3:
-          parseCustomStream3(message);
-          break;
-      }
+    total_can_frames++;
+    if (backlogged) {
+      can_pipeline.defer(frame, now_ms, now_us);
+    } else {
+      can_pipeline.process(frame, now_ms, now_us);
+      check_status_echo(frame);
+    }
+    if (canFilterMatches(frame)) {
+      can_filter_accepted++;
+    } else {
+      can_filter_outside++;
     }
-    // Add Haltech IC7 parsing here if needed
+  }
+  if (backlogged) can_pipeline.flushDeferred(now_ms, now_us, check_status_echo);
+
+  can_pipeline.finishBatch(millis(), micros());
+
+  if (data_received) {
+    last_can_message = millis();
 
-    // Calculate approximate speed from RPM (since not in CAN stream)
-    if (ecu_data.rpm > 0) {
+    // Calculate approximate speed from RPM when the stream has no speed
+    if (!signal_decoder.provides(SIG_VEHICLE_SPEED) && ecu_data.rpm > 0) {
       // Simple speed estimation based on RPM (adjust these ratios for your vehicle)
       // Using average gear ratio for speed calculation
       ecu_data.speed = ecu_data.rpm * 0.045; // Average gear ratio
@@ -466,6 +840,762 @@ void simulateData() {
   }
 }
 
+// ========== STORAGE ==========
+// microSD slot on the Tab5, on its own SPI bus
+#define SD_SPI_CS_PIN 42
+#define SD_SPI_SCK_PIN 43
+#define SD_SPI_MOSI_PIN 44
+#define SD_SPI_MISO_PIN 39
+#define SD_SPI_FREQUENCY 25000000
+#define SD_MOUNT_POINT "/sd"          // Where SD paths live for POSIX calls
+
+bool sd_mounted = false;
+
+bool mountSDCard() {
+  if (sd_mounted) return true;
+  SPI.begin(SD_SPI_SCK_PIN, SD_SPI_MISO_PIN, SD_SPI_MOSI_PIN, SD_SPI_CS_PIN);
+  sd_mounted = SD.begin(SD_SPI_CS_PIN, SPI, SD_SPI_FREQUENCY, SD_MOUNT_POINT);
+  if (!sd_mounted) {
+    Serial.println("SD card mount failed!");
+  }
+  return sd_mounted;
+}
+
+// ========== SD CARD LOG WRITER ==========
+// LOG_FULL records go from can_capture to numbered files in /logs through
+// CANLogWriter (see can_log_writer.h): loop() fills its blocks and a
+// low-priority task on the receive core writes them, so neither the
+// receive task nor rendering waits on the card. LOG_CHANGES fills the
+// same blocks with signal change groups instead, encoded from ecu_data
+// once per loop() (signal_changes.h), and LOG_SESSION with column chunks
+// and, when recording stops, their time index (session_log.h), each into
+// files of their own. Files are preallocated and written in sealed blocks
+// (can_log_format.h), so nothing is synced per write and a power cut
+// loses at most the block in flight; "logcheck" shows what a file
+// recovers to. Without a card the capture ring stays a flight recorder of
+// the last frames.
+#define LOG_DIRECTORY "/logs"
+#define LOG_PATH_MAX 32
+#define LOG_PRUNE_BATCH 16             // Files deleted per directory scan
+#define LOG_WRITER_TASK_STACK 4096
+#define LOG_WRITER_TASK_PRIORITY 1     // Below the receive task, level with loop()
+#define LOG_WRITER_TASK_CORE 0
+#define LOG_WRITER_IDLE_MS 5
+#define LOG_WRITER_STOP_MS 2000       // Longest drain before the task is told to stop anyway
+
+// By CANLogContent
+const char* const LOG_FILE_FORMATS[] = {LOG_DIRECTORY "/CAN%05u.BIN", LOG_DIRECTORY "/CHG%05u.BIN",
+                                        LOG_DIRECTORY "/SES%05u.BIN"};
+
+class SDLogSink : public LogFileSink {
+public:
+  void setContent(CANLogContent content) { format_ = LOG_FILE_FORMATS[content]; }
+  const char* format() const { return format_; }
+
+  bool open(uint32_t index, uint32_t preallocate_bytes) override {
+    snprintf(path_, sizeof(path_), format_, (unsigned)index);
+    preallocated_ = preallocate_bytes;
+
+    // f_expand() gives the file one contiguous run of clusters and its
+    // final size in a single FAT update, so block writes never touch FAT
+    // metadata and go out as plain sequential sector writes. It needs an
+    // empty file; "r+" then writes into the allocation without truncating.
+    char vfs_path[sizeof(SD_MOUNT_POINT) + LOG_PATH_MAX];
+    vfsPath(vfs_path, sizeof(vfs_path));
+    if (SD.exists(path_)) SD.remove(path_);
+    if (esp_vfs_fat_create_contiguous_file(SD_MOUNT_POINT, vfs_path, preallocate_bytes, true) == ESP_OK) {
+      file_ = SD.open(path_, "r+");
+      if (file_) return true;
+    }
+
+    // No contiguous run free (a fragmented card): writing the last byte
+    // still allocates the whole chain now, just not in one piece
+    file_ = SD.open(path_, FILE_WRITE);
+    if (!file_) return false;
+    if (!file_.seek(preallocate_bytes - 1) || file_.write((uint8_t)0) != 1) {
+      file_.close();
+      return false;
+    }
+    file_.flush();
+    return file_.seek(0);
+  }
+
+  bool write(const uint8_t* data, size_t length) override { return file_.write(data, length) == length; }
+
+  // A session's index has to end its file, so the unwritten space goes
+  void close(uint32_t written_bytes) override {
+    file_.close();
+    if (written_bytes >= preallocated_) return;
+    char vfs_path[sizeof(SD_MOUNT_POINT) + LOG_PATH_MAX];
+    vfsPath(vfs_path, sizeof(vfs_path));
+    truncate(vfs_path, written_bytes);
+  }
+
+  void remove(uint32_t index) override { removeFile(index); }
+
+  // false if the file is there and could not be deleted
+  bool removeFile(uint32_t index) {
+    char path[LOG_PATH_MAX];
+    snprintf(path, sizeof(path), format_, (unsigned)index);
+    return !SD.exists(path) || SD.remove(path);
+  }
+
+private:
+  // The current file's path for ESP-IDF and POSIX calls
+  void vfsPath(char* out, size_t size) const { snprintf(out, size, SD_MOUNT_POINT "%s", path_); }
+
+  const char* format_ = LOG_FILE_FORMATS[CAN_LOG_CONTENT_FRAMES];
+  char path_[LOG_PATH_MAX];
+  uint32_t preallocated_ = 0;
+  File file_;
+};
+
+CANLogWriter can_log_writer;
+SDLogSink sd_log_sink;
+TaskHandle_t log_writer_task_handle = NULL;
+volatile bool log_writer_stop = false;
+CANLogContent log_writer_content = CAN_LOG_CONTENT_FRAMES;
+uint32_t log_writer_first_index = 0;
+
+// Stopping the writer runs over several loop() passes, one step each from
+// serviceLogWriter(), so neither rendering nor readCANData() waits on the
+// card while the last blocks go out
+enum LogWriterStopState {
+  LOG_STOP_NONE,         // Running, or no writer
+  LOG_STOP_SESSION_CHUNK,    // LOG_SESSION: closing the last chunk
+  LOG_STOP_SESSION_SETTLE,   // Waiting for every chunk block to be written
+  LOG_STOP_SESSION_INDEX,    // Appending the index, a block per pass
+  LOG_STOP_DRAIN,        // Handing over what is left until both blocks are written
+  LOG_STOP_JOIN          // Task told to stop, waiting for it to exit
+};
+
+LogWriterStopState log_writer_stopping = LOG_STOP_NONE;
+unsigned long log_writer_stop_started = 0;   // Current step's start
+bool log_writer_restart = false;             // configureLogging() again once stopped
+
+// The session index while LOG_STOP_SESSION_INDEX writes it out
+const uint8_t* session_index = nullptr;
+size_t session_index_length = 0;
+size_t session_index_done = 0;
+
+// LOG_CHANGES, from loop() while the writer runs; the start point is for
+// comparing with what raw frames would have taken
+SignalChangeEncoder signal_change_encoder;
+unsigned long signal_changes_started = 0;
+uint32_t signal_changes_start_frames = 0;
+
+// LOG_SESSION, from loop() while recording
+SessionLogEncoder session_log;
+unsigned long session_started = 0;
+
+uint32_t logClockMicros() {
+  return micros();
+}
+
+// Number of a log file named as format (one of LOG_FILE_FORMATS)
+bool parseLogFileName(const char* name, const char* format, uint32_t& index) {
+  const char* base = strrchr(name, '/');
+  unsigned value;
+  if (sscanf(base ? base + 1 : name, strrchr(format, '/') + 1, &value) != 1) return false;
+  index = value;
+  return true;
+}
+
+// Number for the next log file of the sink's kind (one past the highest
+// on the card), after deleting every one that falls outside the max_files
+// window once the writer opens it
+uint32_t prepareLogDirectory() {
+  const char* format = sd_log_sink.format();
+  if (!SD.exists(LOG_DIRECTORY)) SD.mkdir(LOG_DIRECTORY);
+
+  uint32_t next = 0;
+  File dir = SD.open(LOG_DIRECTORY);
+  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+    uint32_t index;
+    if (parseLogFileName(entry.name(), format, index) && index >= next) next = index + 1;
+  }
+  dir.close();
+
+  // The writer removes next - max_files itself when it opens next
+  for (;;) {
+    uint32_t stale[LOG_PRUNE_BATCH];
+    uint8_t stale_count = 0;
+    dir = SD.open(LOG_DIRECTORY);
+    for (File entry = dir.openNextFile(); entry && stale_count < LOG_PRUNE_BATCH; entry = dir.openNextFile()) {
+      uint32_t index;
+      if (parseLogFileName(entry.name(), format, index) && index + config.max_files < next) stale[stale_count++] = index;
+    }
+    dir.close();
+
+    uint8_t removed = 0;
+    for (uint8_t i = 0; i < stale_count; i++) {
+      if (sd_log_sink.removeFile(stale[i])) removed++;
+    }
+    // A batch that removed nothing would be listed again forever
+    if (stale_count < LOG_PRUNE_BATCH || removed == 0) {
+      if (removed < stale_count) Serial.printf("Log files: %d old files could not be removed\n", stale_count - removed);
+      break;
+    }
+  }
+  return next;
+}
+
+void logWriterTask(void* param) {
+  for (;;) {
+    if (can_log_writer.writeReady()) continue;
+    if (log_writer_stop) break;
+    vTaskDelay(pdMS_TO_TICKS(LOG_WRITER_IDLE_MS));
+  }
+
+  can_log_writer.end();
+  log_writer_task_handle = NULL;
+  vTaskDelete(NULL);
+}
+
+bool startLogWriter() {
+  CANLogContent content = CAN_LOG_CONTENT_FRAMES;
+  if (config.logging_mode == LOG_CHANGES) content = CAN_LOG_CONTENT_CHANGES;
+  if (config.logging_mode == LOG_SESSION) content = CAN_LOG_CONTENT_SESSION;
+  if (log_writer_task_handle != NULL || logWriterStopping()) {
+    if (content == log_writer_content && !logWriterStopping()) return true;
+    // The running writer finishes over the next passes; this one starts after
+    stopLogWriter();
+    log_writer_restart = true;
+    return false;
+  }
+  if (content == CAN_LOG_CONTENT_FRAMES && !can_capture.allocated()) return false;
+  if (!mountSDCard()) return false;
+  if (!can_log_writer.allocate()) {
+    Serial.println("Log writer buffer allocation failed!");
+    return false;
+  }
+  if (content == CAN_LOG_CONTENT_SESSION && !session_log.allocate(SESSION_INDEX_ENTRIES)) {
+    Serial.println("Session log buffer allocation failed!");
+    return false;
+  }
+
+  sd_log_sink.setContent(content);
+  uint32_t first_index = prepareLogDirectory();
+  can_log_writer.begin(&sd_log_sink, logClockMicros, content, esp_random(), first_index,
+                       config.max_file_size_mb * 1024UL * 1024UL, config.max_files);
+  log_writer_content = content;
+  log_writer_first_index = first_index;
+  log_writer_stop = false;
+  BaseType_t result = xTaskCreatePinnedToCore(logWriterTask, "log_writer", LOG_WRITER_TASK_STACK, NULL,
+                                              LOG_WRITER_TASK_PRIORITY, &log_writer_task_handle, LOG_WRITER_TASK_CORE);
+  if (result != pdPASS) {
+    log_writer_task_handle = NULL;
+    Serial.println("Log writer task creation failed!");
+    return false;
+  }
+
+  char path[LOG_PATH_MAX];
+  snprintf(path, sizeof(path), sd_log_sink.format(), (unsigned)first_index);
+  if (content == CAN_LOG_CONTENT_SESSION) {
+    session_started = millis();
+    session_log.begin(session_started);
+    Serial.printf("Recording session to %s, %dMB files\n", path, config.max_file_size_mb);
+  } else if (content == CAN_LOG_CONTENT_CHANGES) {
+    signal_change_encoder.resetStats();
+    signal_changes_started = millis();
+    signal_changes_start_frames = total_can_frames;
+    Serial.printf("Logging signal changes to %s onwards, %dMB x%d files\n", path, config.max_file_size_mb,
+                  config.max_files);
+  } else {
+    // The files need a gap-free stream: drop new frames rather than old
+    can_capture.setPolicy(CAPTURE_KEEP_OLDEST);
+    Serial.printf("Logging frames to %s onwards, %dMB x%d files\n", path, config.max_file_size_mb,
+                  config.max_files);
+  }
+  return true;
+}
+
+bool logWriterStopping() {
+  return log_writer_stopping != LOG_STOP_NONE;
+}
+
+bool sessionRecording() {
+  return log_writer_task_handle != NULL && !logWriterStopping() && log_writer_content == CAN_LOG_CONTENT_SESSION;
+}
+
+bool startSessionRecording() {
+  if (config.logging_mode != LOG_SESSION) {
+    Serial.println("Session recording needs LOG MODE: SESSION");
+    return false;
+  }
+  if (logWriterStopping()) {
+    Serial.println("Session: the last recording is still being closed");
+    return false;
+  }
+  return startLogWriter();
+}
+
+void setLogWriterStopStep(LogWriterStopState step, unsigned long now) {
+  log_writer_stopping = step;
+  log_writer_stop_started = now;
+}
+
+// Begin stopping the writer; serviceLogWriter() completes it
+void stopLogWriter() {
+  if (log_writer_task_handle == NULL || logWriterStopping()) return;
+  setLogWriterStopStep(log_writer_content == CAN_LOG_CONTENT_SESSION ? LOG_STOP_SESSION_CHUNK : LOG_STOP_DRAIN,
+                       millis());
+}
+
+// A session ends with its last chunk and then the index, appended from a
+// block of its own. The index places chunks by block number, which only
+// holds if every chunk block was written where it was numbered; after a
+// write error it is left out, and a viewer reads the chunks in order
+// instead. Each wait on the card gives up after LOG_WRITER_STOP_MS.
+void finishSessionLog(unsigned long now) {
+  bool timed_out = now - log_writer_stop_started >= LOG_WRITER_STOP_MS;
+  bool fresh;
+
+  if (log_writer_stopping == LOG_STOP_SESSION_CHUNK) {
+    size_t length = session_log.chunkBytes();
+    uint8_t* out = length ? can_log_writer.reserve(length, now, fresh) : nullptr;
+    if (length && !out) {
+      if (timed_out) {
+        Serial.println("Session index not written: SD card too slow");
+        setLogWriterStopStep(LOG_STOP_DRAIN, now);
+      }
+      return;
+    }
+    session_log.closeChunk(out, can_log_writer.fillSequence(), can_log_writer.fillOffset(), now);
+    can_log_writer.commit(length);
+    can_log_writer.flush();
+    setLogWriterStopStep(LOG_STOP_SESSION_SETTLE, now);
+    return;
+  }
+
+  if (log_writer_stopping == LOG_STOP_SESSION_SETTLE) {
+    CANLogWriterStats writer_stats;
+    can_log_writer.readStats(writer_stats);
+    if (!can_log_writer.idle() && !timed_out) return;
+    if (!can_log_writer.idle() || writer_stats.write_errors) {
+      Serial.printf("Session index not written: %lu block write errors%s\n", writer_stats.write_errors,
+                    can_log_writer.idle() ? "" : ", SD card too slow");
+      setLogWriterStopStep(LOG_STOP_DRAIN, now);
+      return;
+    }
+    session_index = session_log.finishIndex(can_log_writer.fillSequence(), log_writer_first_index,
+                                            can_log_writer.blocksPerFile(), session_index_length);
+    session_index_done = 0;
+    setLogWriterStopStep(LOG_STOP_SESSION_INDEX, now);
+    return;
+  }
+
+  // LOG_STOP_SESSION_INDEX: at most one block's worth per pass
+  size_t piece = min(session_index_length - session_index_done, (size_t)CAN_LOG_BLOCK_PAYLOAD);
+  uint8_t* out = can_log_writer.reserve(piece, now, fresh);
+  if (!out) {
+    if (timed_out) {
+      Serial.println("Session index not written: SD card too slow");
+      setLogWriterStopStep(LOG_STOP_DRAIN, now);
+    }
+    return;
+  }
+  memcpy(out, session_index + session_index_done, piece);
+  can_log_writer.commit(piece);
+  session_index_done += piece;
+  log_writer_stop_started = now;   // The next piece gets a wait of its own
+  if (session_index_done < session_index_length) return;
+
+  const SessionLogStats& stats = session_log.stats();
+  Serial.printf("Session: %lu s, %lu chunks, %lu values, %lu bytes, index %u bytes\n",
+                (millis() - session_started) / 1000, stats.chunks, stats.values, stats.bytes,
+                (unsigned)session_index_length);
+  setLogWriterStopStep(LOG_STOP_DRAIN, now);
+}
+
+// One step of stopping the writer per loop() pass
+void serviceLogWriterStop(unsigned long now) {
+  if (log_writer_stopping < LOG_STOP_DRAIN) {
+    finishSessionLog(now);
+    return;
+  }
+
+  if (log_writer_stopping == LOG_STOP_DRAIN) {
+    // Once both blocks are written, one flush hands over everything captured
+    bool caught_up = can_log_writer.idle();
+    if (log_writer_content == CAN_LOG_CONTENT_FRAMES) {
+      can_log_writer.fill(can_capture, now, true);
+    } else {
+      can_log_writer.flush();
+    }
+    if (!caught_up && now - log_writer_stop_started < LOG_WRITER_STOP_MS) return;
+
+    log_writer_stop = true;
+    setLogWriterStopStep(LOG_STOP_JOIN, now);
+    return;
+  }
+
+  // The task clears its handle on the way out
+  if (log_writer_task_handle != NULL) {
+    if (now - log_writer_stop_started >= LOG_WRITER_STOP_MS) {
+      Serial.println("Log writer task still stopping");
+      log_writer_stop_started = now;
+    }
+    return;
+  }
+
+  log_writer_stopping = LOG_STOP_NONE;
+  can_capture.setPolicy(CAPTURE_KEEP_NEWEST);
+  if (log_writer_restart) {
+    log_writer_restart = false;
+    configureLogging();
+  }
+}
+
+// Called every loop(): move captured frames into the writer's blocks, or
+// log what has changed in ecu_data, or sample it into session columns
+void serviceLogWriter() {
+  unsigned long now = millis();
+  if (logWriterStopping()) {
+    serviceLogWriterStop(now);
+    return;
+  }
+  if (log_writer_task_handle == NULL) return;
+  if (log_writer_content == CAN_LOG_CONTENT_FRAMES) {
+    can_log_writer.fill(can_capture, now);
+    return;
+  }
+
+  if (log_writer_content == CAN_LOG_CONTENT_SESSION) {
+    if (session_log.chunkDue(now)) {
+      // Both blocks waiting on the card: the chunk runs on until a column fills
+      size_t length = session_log.chunkBytes();
+      bool fresh;
+      uint8_t* chunk = length ? can_log_writer.reserve(length, now, fresh) : nullptr;
+      if (!length || chunk) {
+        session_log.closeChunk(chunk, can_log_writer.fillSequence(), can_log_writer.fillOffset(), now);
+        can_log_writer.commit(length);
+      }
+    }
+    session_log.sample(ecu_data, now);
+    return;
+  }
+
+  // Both blocks waiting on the card: skip the sample (counted as a stall)
+  bool fresh;
+  uint8_t* group = can_log_writer.reserve(SIGNAL_CHANGE_GROUP_MAX, now, fresh);
+  if (!group) return;
+  if (fresh) signal_change_encoder.restart();   // Every block starts with a keyframe
+  can_log_writer.commit(signal_change_encoder.encode(ecu_data, now, group));
+}
+
+// ========== CAN LOG REPLAY ==========
+// A candump or ASC log from the SD card stands in for the bus: due frames
+// are pushed into can_rx_ring and readCANData() handles them exactly as
+// live traffic. The CAN driver and its receive task are stopped for the
+// duration, so loop() is the ring's only producer, and nothing is ever
+// transmitted. Started from the serial console ("replay <file> [speed]").
+#define REPLAY_REPORT_MS 5000
+
+CANReplay can_replay;
+File replay_file;
+bool replay_active = false;
+bool replay_saved_simulation = false;   // Mode to return to afterwards
+unsigned long replay_started = 0;
+unsigned long replay_last_report = 0;
+uint32_t replay_last_report_frames = 0;
+
+size_t readReplayFile(void* context, char* buffer, size_t length) {
+  return ((File*)context)->read((uint8_t*)buffer, length);
+}
+
+void stopCANReplay();
+
+bool startCANReplay(const char* path, uint32_t speed_percent) {
+  stopCANReplay();
+  if (!mountSDCard()) return false;
+
+  replay_file = SD.open(path, FILE_READ);
+  if (!replay_file) {
+    Serial.printf("Replay: cannot open %s\n", path);
+    return false;
+  }
+
+  stopCANAutoDetect();
+  if (can_running) shutdownCAN();
+  replay_saved_simulation = config.simulation_mode;
+  config.simulation_mode = false;
+  initCANMonitoring();
+
+  can_replay.begin(readReplayFile, &replay_file, speed_percent, micros());
+  replay_active = true;
+  replay_started = replay_last_report = millis();
+  replay_last_report_frames = 0;
+  if (speed_percent == CAN_REPLAY_SPEED_MAX) {
+    Serial.printf("Replay: %s at max speed\n", path);
+  } else {
+    Serial.printf("Replay: %s at %.2fx\n", path, speed_percent / 100.0);
+  }
+  return true;
+}
+
+void stopCANReplay() {
+  if (!replay_active) return;
+  replay_active = false;
+  replay_file.close();
+
+  unsigned long elapsed = millis() - replay_started;
+  Serial.printf("Replay: %lu frames in %lu ms (%.0f frames/s), %lu lines skipped, %lu ring drops\n",
+                can_replay.frameCount(), elapsed, elapsed ? can_replay.frameCount() * 1000.0 / elapsed : 0.0,
+                can_replay.reader().skippedLines(), can_rx_ring.droppedFrames());
+
+  config.simulation_mode = replay_saved_simulation;
+  if (!config.simulation_mode && !startLiveCAN()) {
+    Serial.println("CAN restart after replay failed! Falling back to simulation mode");
+    config.simulation_mode = true;
+  }
+}
+
+// Called every loop() before readCANData() while a replay runs
+void serviceCANReplay() {
+  // Only as many as the ring holds - a sink that refuses keeps the frame
+  uint32_t space = can_rx_ring.capacity() - can_rx_ring.depth();
+  can_replay.service(micros(), space, [](const RxFrame& frame) { return can_rx_ring.push(frame); });
+
+  unsigned long now = millis();
+  if (now - replay_last_report >= REPLAY_REPORT_MS) {
+    uint32_t frames = can_replay.frameCount();
+    Serial.printf("Replay: %.0f frames/s\n", (frames - replay_last_report_frames) * 1000.0 / (now - replay_last_report));
+    replay_last_report = now;
+    replay_last_report_frames = frames;
+  }
+
+  // Finish once readCANData() has taken the last frames
+  if (can_replay.finished() && can_rx_ring.depth() == 0) {
+    stopCANReplay();
+  }
+}
+
+// ========== LOG FILE CHECK ==========
+// candump -l line, which "replay" and canplayer read back
+void printLogRecord(const CANLogRecord& record) {
+  char line[64];
+  int length = sprintf(line, record.extended() ? "(%lu.%06lu) can0 %08lX#" : "(%lu.%06lu) can0 %03lX#",
+                       record.timestampUs() / 1000000, record.timestampUs() % 1000000, record.identifier());
+  for (uint8_t b = 0; b < record.length(); b++) length += sprintf(line + length, "%02X", record.data[b]);
+  Serial.println(line);
+}
+
+// One line per logged value of a LOG_CHANGES block
+void printSignalChanges(const uint8_t* block) {
+  const CANLogBlockHeader* header = (const CANLogBlockHeader*)block;
+  SignalChangeDecoder decoder;
+  auto print = [](uint32_t time_ms, SignalId signal, float value) {
+    Serial.printf("%lu.%03lu %s %.3f\n", time_ms / 1000, time_ms % 1000, SIGNAL_FIELDS[signal].name, value);
+  };
+  if (!decoder.decode(logBlockPayload(block), header->record_count, print)) {
+    Serial.printf("logcheck: block %lu: malformed change group\n", header->sequence);
+  }
+}
+
+// One line per sample of a LOG_SESSION block's chunks, column by column;
+// false once the index section starts
+bool printSessionChunks(const uint8_t* block) {
+  const CANLogBlockHeader* header = (const CANLogBlockHeader*)block;
+  const uint8_t* payload = logBlockPayload(block);
+  auto print = [](SignalId signal, uint32_t time_ms, float value) {
+    Serial.printf("%lu.%03lu %s %.3f\n", time_ms / 1000, time_ms % 1000, SIGNAL_FIELDS[signal].name, value);
+  };
+  for (size_t offset = 0; offset < header->record_count;) {
+    if (payload[offset] == SESSION_INDEX_TAG) return false;
+    size_t length = decodeSessionChunk(payload + offset, header->record_count - offset, UINT32_MAX, print);
+    if (!length) {
+      Serial.printf("logcheck: block %lu: malformed chunk\n", header->sequence);
+      break;
+    }
+    offset += length;
+  }
+  return true;
+}
+
+// Walk a log file the way a reader recovers it after a power cut
+void checkLogFile(const char* path, bool dump) {
+  if (!mountSDCard()) return;
+  File file = SD.open(path, FILE_READ);
+  if (!file) {
+    Serial.printf("logcheck: cannot open %s\n", path);
+    return;
+  }
+  uint8_t* block = (uint8_t*)malloc(CAN_LOG_BLOCK_BYTES);
+  if (!block) {
+    file.close();
+    Serial.println("logcheck: out of memory");
+    return;
+  }
+
+  CANLogBlockReader reader;
+  reader.begin(readReplayFile, &file);
+  CANLogBlockStatus status;
+  SessionFooter footer;
+  bool indexed = false, chunks = true;
+  while ((status = reader.next(block)) == LOG_BLOCK_OK) {
+    const CANLogBlockHeader* header = (const CANLogBlockHeader*)block;
+    if (header->content == CAN_LOG_CONTENT_SESSION) {
+      indexed = readSessionFooter(logBlockPayload(block), header->record_count, footer);
+      if (dump && chunks) chunks = printSessionChunks(block);
+      continue;
+    }
+    if (!dump) continue;
+    if (header->content == CAN_LOG_CONTENT_CHANGES) {
+      printSignalChanges(block);
+      continue;
+    }
+    for (uint32_t i = 0; i < header->record_count; i++) printLogRecord(logBlockRecords(block)[i]);
+  }
+  if (reader.blockCount() == 0) {
+    Serial.printf("logcheck: %s: no valid blocks (%s)\n", path, canLogBlockStatusName(status));
+  } else {
+    Serial.printf("logcheck: %s: %lu blocks, %lu %s (session %08lX, file %lu, blocks %lu-%lu), stopped at %s\n", path,
+                  reader.blockCount(), reader.recordCount(),
+                  reader.first().content == CAN_LOG_CONTENT_FRAMES ? "frames" : "bytes",
+                  reader.first().session, reader.first().file_index,
+                  reader.first().sequence, reader.first().sequence + reader.blockCount() - 1,
+                  canLogBlockStatusName(status));
+  }
+  if (indexed) {
+    Serial.printf("logcheck: session index: %lu chunks from block %lu, files of %lu blocks from %lu\n",
+                  footer.entry_count, footer.index_sequence, footer.blocks_per_file, footer.first_file_index);
+  }
+  free(block);
+  file.close();
+}
+
+// ========== SERIAL CONSOLE ==========
+//   replay <file> [1x|10x|0.5x|max]   Replay a CAN log from the SD card
+//   replay stop
+//   bench [passes]                   Receive path benchmarks, JSON lines
+//   capture [dump|newest|oldest]     LOG_FULL ring (LOG_CHANGES encoder)
+//                                    and SD writer status,
+//                                    drain the ring as a candump -l log
+//                                    (no SD card), or set overflow policy
+//   logcheck <file> [dump]           Recoverable blocks of a log file and
+//                                    a session's index, optionally printed
+//                                    (candump -l, or time signal value)
+//   session [start|stop]             LOG_SESSION recording
+#define SERIAL_LINE_MAX 96
+#define CAPTURE_DUMP_BATCH 32
+#define BENCH_DEVICE_PASSES 200         // ~0.2M frames per case
+
+void printLogWriterStats() {
+  CANLogWriterStats stats = {};
+  can_log_writer.readStats(stats);
+  Serial.printf("Writer: file %lu (%lu bytes), %lu files, %.1f MB written at %.2f MB/s, worst write %lu us, "
+                "worst open %lu us, %lu fill stalls, %lu errors (%lu %s lost)\n",
+                stats.file_index, stats.file_bytes, stats.files_opened, stats.bytes_written / 1048576.0,
+                stats.writeRate(), stats.worst_write_us, stats.worst_open_us, can_log_writer.fillStalls(),
+                stats.write_errors, stats.records_lost,
+                log_writer_content == CAN_LOG_CONTENT_FRAMES ? "frames" : "bytes");
+}
+
+void handleSerialCommand(char* line) {
+  char* command = strtok(line, " \t");
+  if (!command) return;
+
+  if (strcmp(command, "replay") == 0) {
+    char* path = strtok(NULL, " \t");
+    char* speed = strtok(NULL, " \t");
+    if (!path) {
+      Serial.println("Usage: replay <file> [1x|10x|0.5x|max] | replay stop");
+    } else if (strcmp(path, "stop") == 0) {
+      stopCANReplay();
+    } else {
+      uint32_t speed_percent = CAN_REPLAY_SPEED_1X;
+      if (speed && strcmp(speed, "max") == 0) {
+        speed_percent = CAN_REPLAY_SPEED_MAX;
+      } else if (speed) {
+        speed_percent = (uint32_t)max(1L, lroundf(atof(speed) * 100));
+      }
+      startCANReplay(path, speed_percent);
+    }
+  } else if (strcmp(command, "bench") == 0) {
+    // Blocks loop() for a few seconds; uses its own tables, not the live ones
+    char* passes = strtok(NULL, " \t");
+    uint32_t pass_count = passes ? max(1L, atol(passes)) : BENCH_DEVICE_PASSES;
+    Serial.printf("Benchmark: %lu passes per case at %lu MHz\n", pass_count, getCpuFrequencyMhz());
+    if (!runPipelineBenchmarks("esp32p4", pass_count, [](const char* line) { Serial.println(line); })) {
+      Serial.println("Benchmark table allocation failed!");
+    }
+  } else if (strcmp(command, "logcheck") == 0) {
+    char* path = strtok(NULL, " \t");
+    char* action = strtok(NULL, " \t");
+    if (!path) {
+      Serial.println("Usage: logcheck <file> [dump]");
+    } else {
+      checkLogFile(path, action && strcmp(action, "dump") == 0);
+    }
+  } else if (strcmp(command, "session") == 0) {
+    char* action = strtok(NULL, " \t");
+    if (action && strcmp(action, "start") == 0) {
+      startSessionRecording();
+    } else if (action && strcmp(action, "stop") == 0) {
+      if (sessionRecording()) stopLogWriter();
+    } else if (sessionRecording()) {
+      const SessionLogStats& stats = session_log.stats();
+      Serial.printf("Session: recording %lu s, %lu chunks, %lu values, %lu bytes, %lu dropped, %lu unindexed\n",
+                    (millis() - session_started) / 1000, stats.chunks, stats.values, stats.bytes, stats.dropped,
+                    stats.unindexed);
+      printLogWriterStats();
+    } else {
+      Serial.println("Session: not recording (session start)");
+    }
+  } else if (strcmp(command, "capture") == 0) {
+    char* action = strtok(NULL, " \t");
+    if (!can_capture.allocated()) {
+      Serial.println("Frame capture is off (LOG MODE: FULL)");
+      if (log_writer_task_handle != NULL && log_writer_content == CAN_LOG_CONTENT_CHANGES) {
+        const SignalChangeStats& changes = signal_change_encoder.stats();
+        Serial.printf("Signal changes: %lu samples, %lu logged, %lu values, %lu bytes\n", changes.samples, changes.groups,
+                      changes.changes, changes.bytes);
+        printLogWriterStats();
+      }
+    } else if (action && strcmp(action, "dump") == 0 && log_writer_task_handle != NULL) {
+      Serial.println("Frame capture is being written to the SD card");
+    } else if (action && strcmp(action, "dump") == 0) {
+      // Drains the ring; the output replays with "replay" or canplayer
+      CANLogRecord records[CAPTURE_DUMP_BATCH];
+      uint32_t count;
+      while ((count = can_capture.pop(records, CAPTURE_DUMP_BATCH)) > 0) {
+        for (uint32_t i = 0; i < count; i++) {
+          printLogRecord(records[i]);
+        }
+      }
+    } else if (action && (strcmp(action, "newest") == 0 || strcmp(action, "oldest") == 0)) {
+      can_capture.setPolicy(strcmp(action, "newest") == 0 ? CAPTURE_KEEP_NEWEST : CAPTURE_KEEP_OLDEST);
+      Serial.printf("Capture overflow policy: %s\n", canCapturePolicyName(can_capture.policy()));
+    } else {
+      Serial.printf("Capture: %lu/%lu frames, peak %lu, captured %lu, dropped %lu, overwritten %lu, %s\n",
+                    can_capture.depth(), can_capture.capacity(), can_capture.peakDepth(),
+                    can_capture.capturedFrames(), can_capture.droppedFrames(), can_capture.overwrittenFrames(),
+                    canCapturePolicyName(can_capture.policy()));
+      if (log_writer_task_handle != NULL) printLogWriterStats();
+    }
+  } else {
+    Serial.printf("Unknown command: %s\n", command);
+  }
+}
+
+void serviceSerialCommands() {
+  static char line[SERIAL_LINE_MAX + 1];
+  static uint8_t length = 0;
+
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\r' || c == '\n') {
+      if (length == 0) continue;
+      line[length] = '\0';
+      length = 0;
+      handleSerialCommand(line);
+    } else if (length < SERIAL_LINE_MAX) {
+      line[length++] = c;
+    }
+  }
+}
+
 // ========== CONFIGURATION ==========
 void loadConfig() {
   preferences.begin("link_g4x", false);
@@ -473,12 +1603,19 @@ void loadConfig() {
   config.base_can_id = preferences.getUInt("base_can_id", 864);
   config.can_speed = preferences.getUInt("can_speed", 1000000);
   config.simulation_mode = preferences.getBool("simulation", true);
-  config.use_custom_streams = preferences.getBool("custom_streams", true);
+  // Older firmware stored only custom stream on/off
+  StreamProtocol legacy_protocol = preferences.getBool("custom_streams", true) ? STREAM_CUSTOM : STREAM_HALTECH_IC7;
+  config.stream_protocol = (StreamProtocol)preferences.getUChar("stream_proto", legacy_protocol);
+  if (config.stream_protocol > STREAM_GENERIC_DASH2) config.stream_protocol = STREAM_CUSTOM;
+  // On by default only on a fresh device: an existing config without the
+  // key keeps the bitrate and stream it was set to
+  config.can_auto_detect = preferences.getBool("can_auto", !preferences.isKey("can_speed"));
 
   // Load unit system (new unified approach)
   config.units = (UnitSystem)preferences.getUChar("units", METRIC);
+  applyUnitSystem();
 
-  // Load CAN logging configuration (UI only)
+  // Load CAN logging configuration
   config.logging_mode = (LoggingMode)preferences.getUChar("log_mode", LOG_DISABLED);
   config.log_detail = (LogDetail)preferences.getUChar("log_detail", LOG_BASIC);
   config.buffer_size = (BufferSize)preferences.getUChar("buffer_size", BUFFER_MEDIUM);
@@ -489,9 +1626,9 @@ void loadConfig() {
 
   Serial.println("Configuration loaded:");
   Serial.printf("  Base CAN ID: %d\n", config.base_can_id);
-  Serial.printf("  CAN Speed: %d bps\n", config.can_speed);
+  Serial.printf("  CAN Speed: %lu bps%s\n", config.can_speed, config.can_auto_detect ? " (auto)" : "");
   Serial.printf("  Simulation: %s\n", config.simulation_mode ? "ON" : "OFF");
-  Serial.printf("  Custom Streams: %s\n", config.use_custom_streams ? "ON" : "OFF");
+  Serial.printf("  Stream: %s\n", getStreamProtocolName());
   Serial.printf("  Units: %s\n", getUnitSystemName());
   Serial.printf("  Logging: %s (%s)\n", getLoggingModeName(), getLogDetailName());
   Serial.printf("  Buffer: %s (%d frames)\n", getBufferSizeName(), getBufferFrameCount());
@@ -502,13 +1639,15 @@ void saveConfig() {
 
   preferences.putUInt("base_can_id", config.base_can_id);
   preferences.putUInt("can_speed", config.can_speed);
-  preferences.putBool("simulation", config.simulation_mode);
-  preferences.putBool("custom_streams", config.use_custom_streams);
+  // A replay only borrows live mode
+  preferences.putBool("simulation", replay_active ? replay_saved_simulation : config.simulation_mode);
+  preferences.putUChar("stream_proto", config.stream_protocol);
+  preferences.putBool("can_auto", config.can_auto_detect);
 
   // Save new unit system
   preferences.putUChar("units", config.units);
 
-  // Save CAN logging configuration (UI only)
+  // Save CAN logging configuration
   preferences.putUChar("log_mode", config.logging_mode);
   preferences.putUChar("log_detail", config.log_detail);
   preferences.putUChar("buffer_size", config.buffer_size);
@@ -706,6 +1845,142 @@ enum AppMode {
 
 AppMode current_mode = MODE_GAUGES;
 
+// ========== FRAME CAPTURE STATUS ==========
+// LOGGING tab panel under the STORAGE section (LOG_FULL and LOG_CHANGES),
+// redrawn with the blinking dots so the fill, loss and SD writer counters
+// stay current
+#define CAPTURE_PANEL_H 120
+
+// Bottom line of either logging panel
+void drawLogWriterStatus(int x, int y) {
+  M5.Display.setTextColor(M5.Display.color565(150, 150, 150));
+  if (log_writer_task_handle == NULL) {
+    M5.Display.drawString(config.logging_mode == LOG_SESSION ? "SD: NOT RECORDING" : "SD: NOT WRITING (NO CARD)", x, y);
+    return;
+  }
+  CANLogWriterStats stats = {};
+  can_log_writer.readStats(stats);
+  char line[96];
+  M5.Display.setTextColor(stats.write_errors ? M5.Display.color565(255, 80, 80) : M5.Display.color565(0, 255, 255));
+  sprintf(line, "SD #%lu %.1f/%dMB  %.2f MB/s  STALL %lums  WAITS %lu  ERR %lu", stats.file_index,
+          stats.file_bytes / 1048576.0f, config.max_file_size_mb, stats.writeRate(), stats.worst_write_us / 1000,
+          can_log_writer.fillStalls(), stats.write_errors);
+  M5.Display.drawString(line, x, y);
+}
+
+void drawFrameCaptureStatus(int y) {
+  int screen_w = M5.Display.width();
+  int section_w = screen_w - 40;
+  int section_x = 20;
+  uint16_t accent_color = M5.Display.color565(255, 100, 100);
+
+  M5.Display.fillRoundRect(section_x, y, section_w, CAPTURE_PANEL_H, 8, M5.Display.color565(40, 40, 80));
+  M5.Display.drawRoundRect(section_x, y, section_w, CAPTURE_PANEL_H, 8, accent_color);
+  M5.Display.setTextDatum(textdatum_t::middle_left);
+  M5.Display.setTextSize(2);
+
+  if (!can_capture.allocated()) {
+    M5.Display.setTextColor(M5.Display.color565(255, 80, 80));
+    M5.Display.drawString("CAPTURE BUFFER NOT ALLOCATED", section_x + 15, y + 20);
+    return;
+  }
+
+  uint32_t depth = can_capture.depth();
+  uint32_t dropped = can_capture.droppedFrames();
+  uint32_t overwritten = can_capture.overwrittenFrames();
+  char line[96];
+
+  M5.Display.setTextColor(TFT_WHITE);
+  sprintf(line, "CAPTURE %lu/%lu FRAMES  PEAK %lu (%lu%%)", depth, can_capture.capacity(), can_capture.peakDepth(),
+          can_capture.peakDepth() * 100 / can_capture.capacity());
+  M5.Display.drawString(line, section_x + 15, y + 18);
+
+  M5.Display.setTextColor(dropped || overwritten ? M5.Display.color565(255, 165, 0) : M5.Display.color565(100, 255, 100));
+  sprintf(line, "Captured %lu  Dropped %lu  Overwritten %lu", can_capture.capturedFrames(), dropped, overwritten);
+  M5.Display.drawString(line, section_x + 15, y + 46);
+
+  M5.Display.setTextColor(M5.Display.color565(150, 150, 150));
+  sprintf(line, "Overflow: %s", canCapturePolicyName(can_capture.policy()));
+  M5.Display.drawString(line, section_x + 15, y + 74);
+
+  drawLogWriterStatus(section_x + 15, y + 102);
+}
+
+// LOG_CHANGES: what the deadbands keep out of the log, against the 16-byte
+// records LOG_FULL would have written for the same traffic
+void drawSignalChangeStatus(int y) {
+  int screen_w = M5.Display.width();
+  int section_w = screen_w - 40;
+  int section_x = 20;
+  uint16_t accent_color = M5.Display.color565(255, 100, 100);
+
+  M5.Display.fillRoundRect(section_x, y, section_w, CAPTURE_PANEL_H, 8, M5.Display.color565(40, 40, 80));
+  M5.Display.drawRoundRect(section_x, y, section_w, CAPTURE_PANEL_H, 8, accent_color);
+  M5.Display.setTextDatum(textdatum_t::middle_left);
+  M5.Display.setTextSize(2);
+
+  const SignalChangeStats& stats = signal_change_encoder.stats();
+  char line[96];
+  M5.Display.setTextColor(TFT_WHITE);
+  sprintf(line, "CHANGES %lu SAMPLES  %lu LOGGED  %lu VALUES", stats.samples, stats.groups, stats.changes);
+  M5.Display.drawString(line, section_x + 15, y + 18);
+
+  float seconds = log_writer_task_handle != NULL ? (millis() - signal_changes_started) / 1000.0f : 0.0f;
+  uint32_t raw_bytes = (total_can_frames - signal_changes_start_frames) * sizeof(CANLogRecord);
+  M5.Display.setTextColor(M5.Display.color565(100, 255, 100));
+  if (seconds < 1.0f) {
+    strcpy(line, "Logged: --");
+  } else if (raw_bytes == 0) {
+    sprintf(line, "Logged: %.0f B/s", stats.bytes / seconds);
+  } else {
+    sprintf(line, "Logged: %.0f B/s  Frames: %.0f B/s  (1/%.0f)", stats.bytes / seconds, raw_bytes / seconds,
+            stats.bytes ? (float)raw_bytes / stats.bytes : 0.0f);
+  }
+  M5.Display.drawString(line, section_x + 15, y + 46);
+
+  M5.Display.setTextColor(M5.Display.color565(150, 150, 150));
+  M5.Display.drawString("Deadband: 10 RPM  0.005 LAMBDA  0.5 TEMP/%", section_x + 15, y + 74);
+
+  drawLogWriterStatus(section_x + 15, y + 102);
+}
+
+// LOG_SESSION: tap to start or stop recording
+void drawSessionStatus(int y) {
+  int screen_w = M5.Display.width();
+  int section_w = screen_w - 40;
+  int section_x = 20;
+  uint16_t accent_color = M5.Display.color565(255, 100, 100);
+
+  M5.Display.fillRoundRect(section_x, y, section_w, CAPTURE_PANEL_H, 8, M5.Display.color565(40, 40, 80));
+  M5.Display.drawRoundRect(section_x, y, section_w, CAPTURE_PANEL_H, 8, accent_color);
+  M5.Display.setTextDatum(textdatum_t::middle_left);
+  M5.Display.setTextSize(2);
+
+  char line[96];
+  bool recording = sessionRecording();
+  unsigned long seconds = recording ? (millis() - session_started) / 1000 : 0;
+  if (recording) {
+    M5.Display.setTextColor(M5.Display.color565(255, 80, 80));
+    sprintf(line, "REC %02lu:%02lu:%02lu  (TAP TO STOP)", seconds / 3600, seconds / 60 % 60, seconds % 60);
+  } else {
+    M5.Display.setTextColor(TFT_WHITE);
+    strcpy(line, "SESSION STOPPED  (TAP TO RECORD)");
+  }
+  M5.Display.drawString(line, section_x + 15, y + 18);
+
+  const SessionLogStats& stats = session_log.stats();
+  M5.Display.setTextColor(stats.dropped || stats.unindexed ? M5.Display.color565(255, 165, 0)
+                                                           : M5.Display.color565(100, 255, 100));
+  sprintf(line, "Chunks %lu  Values %lu  %.0f B/s  Dropped %lu", stats.chunks, stats.values,
+          seconds ? (float)stats.bytes / seconds : 0.0f, stats.dropped);
+  M5.Display.drawString(line, section_x + 15, y + 46);
+
+  M5.Display.setTextColor(M5.Display.color565(150, 150, 150));
+  M5.Display.drawString("Engine: every update  Press: 5Hz  Temps: 1Hz", section_x + 15, y + 74);
+
+  drawLogWriterStatus(section_x + 15, y + 102);
+}
+
 // ========== BLINKING DOTS REFRESH FUNCTION ==========
 void refreshConfigBlinkingDots() {
   if (current_mode != MODE_CONFIG) return;
@@ -732,7 +2007,7 @@ void refreshConfigBlinkingDots() {
 
         switch (i) {
           case 0: accent_color = config.simulation_mode ? M5.Display.color565(255, 150, 0) : M5.Display.color565(0, 255, 100); break;
-          case 1: accent_color = config.use_custom_streams ? M5.Display.color565(0, 255, 200) : M5.Display.color565(255, 100, 255); break;
+          case 1: accent_color = getStreamProtocolColor(); break;
           case 2: accent_color = M5.Display.color565(255, 255, 0); break;
           case 3: accent_color = M5.Display.color565(255, 100, 255); break;
           case 4: accent_color = config.units == METRIC ? M5.Display.color565(100, 255, 100) : M5.Display.color565(255, 165, 0); break;
@@ -775,6 +2050,14 @@ void refreshConfigBlinkingDots() {
             M5.Display.fillCircle(section_x + section_w - 25, y + 25, 4, accent_color);
           }
         }
+
+        if (config.logging_mode == LOG_FULL) {
+          drawFrameCaptureStatus(section_y + logging_sections * (section_h + section_spacing));
+        } else if (config.logging_mode == LOG_CHANGES) {
+          drawSignalChangeStatus(section_y + logging_sections * (section_h + section_spacing));
+        } else if (config.logging_mode == LOG_SESSION) {
+          drawSessionStatus(section_y + logging_sections * (section_h + section_spacing));
+        }
       }
       break;
 
@@ -792,28 +2075,106 @@ enum ControlPreset {
 
 ControlPreset current_preset = PRESET_STREET;
 
+const char* getCANBusStateName(CANBusState state) {
+  switch (state) {
+    case CAN_BUS_RUNNING: return "RUNNING";
+    case CAN_BUS_OFF: return "BUS-OFF";
+    case CAN_BUS_RECOVERING: return "RECOVERING";
+    default: return "STOPPED";
+  }
+}
+
+// Bit heatmap: one cell per payload bit, bytes left to right, MSB first
+// within each byte. Orange = changed in the last second, blue to cyan =
+// toggle count (log scale), grey = never changed.
+#define BIT_CELL_W 5
+#define BIT_CELL_H 12
+#define BIT_HEATMAP_X 580
+#define BIT_RECENT_MS 1000
+
+void drawBitHeatmap(const CANBitActivity* bits, uint8_t length, int x, int y) {
+  uint32_t now = millis();
+  for (uint8_t byte = 0; byte < 8; byte++) {
+    for (uint8_t col = 0; col < 8; col++) {
+      int cell_x = x + byte * (8 * (BIT_CELL_W + 1) + 4) + col * (BIT_CELL_W + 1);
+      if (byte >= length) {
+        M5.Display.fillRect(cell_x, y, BIT_CELL_W, BIT_CELL_H, TFT_BLACK);
+        continue;
+      }
+
+      uint8_t bit = byte * 8 + (7 - col);
+      uint16_t color = M5.Display.color565(40, 40, 40);
+      if (bits->toggled & (1ULL << bit)) {
+        if (now - canBitLastChange(*bits, bit) < BIT_RECENT_MS) {
+          color = M5.Display.color565(255, 120, 0);
+        } else {
+          int level = 31 - __builtin_clz(canBitToggleCount(*bits, bit));   // 0-15
+          color = M5.Display.color565(0, 60 + level * 12, 100 + level * 10);
+        }
+      }
+      M5.Display.fillRect(cell_x, y, BIT_CELL_W, BIT_CELL_H, color);
+    }
+  }
+}
+
 void drawCANMonitoringDisplay(int start_y) {
   int screen_w = M5.Display.width();
-  int line_height = 35;
+  int line_height = 31;
   int current_y = start_y;
 
   // Header section with overall stats
-  M5.Display.fillRect(20, current_y, screen_w - 40, 60, M5.Display.color565(20, 40, 80));
-  M5.Display.drawRect(20, current_y, screen_w - 40, 60, M5.Display.color565(0, 255, 255));
+  M5.Display.fillRect(20, current_y, screen_w - 40, 100, M5.Display.color565(20, 40, 80));
+  M5.Display.drawRect(20, current_y, screen_w - 40, 100, M5.Display.color565(0, 255, 255));
 
   M5.Display.setTextSize(1);
   M5.Display.setTextColor(M5.Display.color565(0, 255, 255));
   M5.Display.setTextDatum(textdatum_t::top_left);
 
-  char stats_line1[60], stats_line2[60];
+  static CANErrorStats bus;   // Keeps the last clean copy if a read is missed
+  can_error_snapshot.read(bus);
+
+  // Sized for every counter at its full 10 digits
+  char stats_line1[128], stats_line2[224], stats_line3[80], stats_line4[96], stats_line5[224];
   uint32_t uptime_sec = (millis() - last_can_stats_reset) / 1000;
-  sprintf(stats_line1, "Total Frames: %lu  Errors: %lu  Speed: %s", total_can_frames, can_errors, getCANSpeedName());
-  sprintf(stats_line2, "Uptime: %lu:%02lu  Active IDs: %d", uptime_sec / 60, uptime_sec % 60,
-          countActiveFrames());
+  snprintf(stats_line1, sizeof(stats_line1), "Total Frames: %lu  Bus: %s  TEC/REC: %lu/%lu  Untracked: %lu  Speed: %s",
+           total_can_frames, getCANBusStateName(bus.state), bus.tx_error_counter, bus.rx_error_counter,
+           can_stats.untrackedFrames(), getCANSpeedName());
+  const CANDecodeCounters& decoded = can_pipeline.counters();
+  snprintf(stats_line2, sizeof(stats_line2), "Uptime: %lu:%02lu  Active IDs: %d  RX Peak: %lu/%lu  Dropped: %lu  "
+           "Decoded: %lu/%lu/%lu  Superseded: %lu/%lu/%lu (crit/norm/slow)",
+           uptime_sec / 60, uptime_sec % 60, countActiveFrames(),
+           can_rx_ring.peakDepth(), can_rx_ring.capacity(), can_rx_ring.droppedFrames(),
+           decoded.processed[PRIORITY_CRITICAL], decoded.processed[PRIORITY_NORMAL], decoded.processed[PRIORITY_SLOW],
+           decoded.superseded[PRIORITY_CRITICAL], decoded.superseded[PRIORITY_NORMAL],
+           decoded.superseded[PRIORITY_SLOW]);
+
+  if (!can_filter_valid) {
+    sprintf(stats_line3, "Filter: NONE  Accepted: %lu", can_filter_accepted);
+  } else {
+    sprintf(stats_line3, "Filter: 0x%03X/0x%03X %s  Accepted: %lu  Outside: %lu",
+            can_filter_code, (~can_filter_dont_care) & 0x7FF, can_filter_in_hardware ? "HW" : "OFF",
+            can_filter_accepted, can_filter_outside);
+  }
 
-  M5.Display.drawString(stats_line1, 30, current_y + 10);
-  M5.Display.drawString(stats_line2, 30, current_y + 30);
-  current_y += 70;
+  snprintf(stats_line5, sizeof(stats_line5), "Errors: bus %lu  tx fail %lu  arb lost %lu  overrun %lu  missed %lu  "
+           "passive %lu  bus-off %lu  recovered %lu (%lums, max %lums)  restarts %lu",
+           bus.bus_errors, bus.tx_failed, bus.arb_lost, bus.rx_overrun, bus.rx_missed, bus.error_passive,
+           bus.bus_off, bus.recoveries, bus.last_downtime_ms, bus.max_downtime_ms, bus.driver_restarts);
+
+  M5.Display.drawString(stats_line1, 30, current_y + 8);
+  M5.Display.drawString(stats_line2, 30, current_y + 26);
+  sprintf(stats_line4, "Bus Load: %.1f%% / %.1f%% / %.1f%% (0.1/1/10s)  Peak: %.1f%% / %.1f%% / %.1f%%",
+          can_bus_load.load(BUS_LOAD_100MS, config.can_speed), can_bus_load.load(BUS_LOAD_1S, config.can_speed),
+          can_bus_load.load(BUS_LOAD_10S, config.can_speed), can_bus_load.peakLoad(BUS_LOAD_100MS, config.can_speed),
+          can_bus_load.peakLoad(BUS_LOAD_1S, config.can_speed), can_bus_load.peakLoad(BUS_LOAD_10S, config.can_speed));
+
+  M5.Display.drawString(stats_line3, 30, current_y + 44);
+  M5.Display.drawString(stats_line4, 30, current_y + 62);
+  uint16_t error_color = bus.bus_off > 0 || bus.error_passive > 0 ? M5.Display.color565(255, 150, 0)
+                                                                   : M5.Display.color565(0, 255, 255);
+  M5.Display.setTextColor(error_color);
+  M5.Display.drawString(stats_line5, 30, current_y + 80);
+  current_y += 110;
 
   // Column headers
   M5.Display.setTextColor(M5.Display.color565(255, 255, 0));
@@ -822,18 +2183,23 @@ void drawCANMonitoringDisplay(int start_y) {
   M5.Display.drawString("RATE", 220, current_y);
   M5.Display.drawString("LAST DATA", 290, current_y);
   M5.Display.drawString("AGE", 500, current_y);
+  M5.Display.drawString("BITS CHANGED (BYTE 0-7, MSB LEFT)", BIT_HEATMAP_X, current_y);
   current_y += 25;
 
   // Draw separator line
   M5.Display.drawLine(20, current_y, screen_w - 20, current_y, M5.Display.color565(100, 100, 100));
   current_y += 10;
 
-  // Display active CAN frames
-  int displayed_frames = 0;
-  for (int i = 0; i < MAX_MONITORED_FRAMES && displayed_frames < 8; i++) {
-    if (!can_frame_stats[i].active) continue;
+  // Display one page of the IDs seen so far
+  uint16_t id_count = can_stats.idCount();
+  uint16_t page_count = id_count > 0 ? (id_count + CAN_MONITOR_ROWS - 1) / CAN_MONITOR_ROWS : 1;
+  if (can_monitor_page >= page_count) can_monitor_page = 0;
+  uint16_t first_row = can_monitor_page * CAN_MONITOR_ROWS;
+
+  for (uint16_t n = first_row; n < id_count && n < first_row + CAN_MONITOR_ROWS; n++) {
+    const CANFrameStats& stats = can_stats.seen(n);
 
-    uint32_t age_ms = millis() - can_frame_stats[i].last_seen;
+    uint32_t age_ms = millis() - stats.last_seen;
     bool is_recent = age_ms < 1000;
     uint16_t text_color = is_recent ? TFT_WHITE : M5.Display.color565(150, 150, 150);
 
@@ -841,31 +2207,33 @@ void drawCANMonitoringDisplay(int start_y) {
     M5.Display.setTextDatum(textdatum_t::top_left);
 
     // CAN ID (hex)
-    char id_str[10];
-    sprintf(id_str, "0x%03X", can_frame_stats[i].can_id);
+    char id_str[12];
+    sprintf(id_str, stats.extended ? "0x%08lX" : "0x%03lX", (unsigned long)stats.can_id);
     M5.Display.drawString(id_str, 30, current_y);
 
     // Packet count
     char count_str[10];
-    if (can_frame_stats[i].packet_count > 9999) {
-      sprintf(count_str, "%luk", can_frame_stats[i].packet_count / 1000);
+    if (stats.packet_count > 9999) {
+      sprintf(count_str, "%luk", stats.packet_count / 1000);
     } else {
-      sprintf(count_str, "%lu", can_frame_stats[i].packet_count);
+      sprintf(count_str, "%lu", stats.packet_count);
     }
     M5.Display.drawString(count_str, 150, current_y);
 
-    // Calculate rate (packets per second)
-    uint32_t time_active = millis() - last_can_stats_reset;
-    float rate = time_active > 0 ? (float)can_frame_stats[i].packet_count * 1000.0 / time_active : 0;
+    // Smoothed rate (packets per second), decays while the ID is silent
+    float rate = canFrameRate(stats, micros());
     char rate_str[10];
     sprintf(rate_str, "%.1fHz", rate);
     M5.Display.drawString(rate_str, 220, current_y);
 
-    // Last data (first 4 bytes in hex)
-    char data_str[20];
-    sprintf(data_str, "%02X %02X %02X %02X",
-            can_frame_stats[i].last_data[0], can_frame_stats[i].last_data[1],
-            can_frame_stats[i].last_data[2], can_frame_stats[i].last_data[3]);
+    // Last data (every byte in hex)
+    char data_str[25];
+    uint8_t length = stats.data_length < 8 ? stats.data_length : 8;
+    char* data_end = data_str;
+    *data_end = '\0';
+    for (uint8_t b = 0; b < length; b++) {
+      data_end += sprintf(data_end, b ? " %02X" : "%02X", stats.last_data[b]);
+    }
     M5.Display.drawString(data_str, 290, current_y);
 
     // Age
@@ -877,8 +2245,20 @@ void drawCANMonitoringDisplay(int start_y) {
     }
     M5.Display.drawString(age_str, 500, current_y);
 
+    const CANBitActivity* bits = can_stats.bits(n);
+    if (bits) drawBitHeatmap(bits, length, BIT_HEATMAP_X, current_y);
+
+    // Inter-arrival spread below the row
+    if (stats.packet_count >= 2) {
+      char interval_str[64];
+      sprintf(interval_str, "ms  min %.1f  p50 %.1f  p99 %.1f  max %.1f",
+              stats.min_interval_us / 1000.0, canIntervalPercentile(stats, 50) / 1000.0,
+              canIntervalPercentile(stats, 99) / 1000.0, stats.max_interval_us / 1000.0);
+      M5.Display.setTextColor(M5.Display.color565(120, 120, 160));
+      M5.Display.drawString(interval_str, 150, current_y + 16);
+    }
+
     current_y += line_height;
-    displayed_frames++;
   }
 
   // Reset button
@@ -887,6 +2267,29 @@ void drawCANMonitoringDisplay(int start_y) {
   int button_x = screen_w - button_w - 30;
   int button_y = start_y + 400;
 
+  // Page button and position, left of RESET
+  int page_button_x = button_x - button_w - 20;
+  M5.Display.fillRoundRect(page_button_x, button_y, button_w, button_h, 8, M5.Display.color565(20, 40, 80));
+  M5.Display.drawRoundRect(page_button_x, button_y, button_w, button_h, 8, M5.Display.color565(0, 255, 255));
+  M5.Display.setTextColor(TFT_WHITE);
+  M5.Display.setTextDatum(textdatum_t::middle_center);
+  M5.Display.drawString("NEXT PAGE", page_button_x + button_w/2, button_y + button_h/2);
+
+  // Acceptance filter override, left of NEXT PAGE
+  int filter_button_x = page_button_x - button_w - 20;
+  uint16_t filter_color = can_promiscuous ? M5.Display.color565(255, 150, 0) : M5.Display.color565(0, 255, 100);
+  M5.Display.fillRoundRect(filter_button_x, button_y, button_w, button_h, 8, M5.Display.color565(20, 40, 80));
+  M5.Display.drawRoundRect(filter_button_x, button_y, button_w, button_h, 8, filter_color);
+  M5.Display.setTextColor(filter_color);
+  M5.Display.drawString(can_promiscuous ? "ALL IDS" : "FILTERED", filter_button_x + button_w/2, button_y + button_h/2);
+
+  char page_str[40];
+  sprintf(page_str, "IDs %u-%u of %u", id_count > 0 ? first_row + 1 : 0,
+          (first_row + CAN_MONITOR_ROWS < id_count) ? first_row + CAN_MONITOR_ROWS : id_count, id_count);
+  M5.Display.setTextColor(M5.Display.color565(150, 150, 150));
+  M5.Display.setTextDatum(textdatum_t::middle_left);
+  M5.Display.drawString(page_str, 30, button_y + button_h/2);
+
   M5.Display.fillRoundRect(button_x, button_y, button_w, button_h, 8, M5.Display.color565(80, 40, 40));
   M5.Display.drawRoundRect(button_x, button_y, button_w, button_h, 8, M5.Display.color565(255, 100, 100));
   M5.Display.setTextColor(TFT_WHITE);
@@ -1008,8 +2411,7 @@ void showConfigurationPage() {
 
       // Stream Type Section
       drawJDMConfigSection("STREAM TYPE", "ストリーム", section_y,
-                          config.use_custom_streams ? "CUSTOM" : "HALTECH IC7",
-                          config.use_custom_streams ? M5.Display.color565(0, 255, 200) : M5.Display.color565(255, 100, 255));
+                          getStreamProtocolName(), getStreamProtocolColor());
       section_y += section_h + section_spacing;
 
       // CAN Speed Section
@@ -1055,6 +2457,15 @@ void showConfigurationPage() {
         sprintf(storage_text, "%dMB x%d", config.max_file_size_mb, config.max_files);
         drawJDMConfigSection("STORAGE", "ストレージ", section_y, storage_text,
                             M5.Display.color565(255, 165, 0));
+        section_y += section_h + section_spacing;
+      }
+
+      if (config.logging_mode == LOG_FULL) {
+        drawFrameCaptureStatus(section_y);
+      } else if (config.logging_mode == LOG_CHANGES) {
+        drawSignalChangeStatus(section_y);
+      } else if (config.logging_mode == LOG_SESSION) {
+        drawSessionStatus(section_y);
       }
       break;
 
@@ -1654,8 +3065,8 @@ float sim_tps = 0.0;
 float sim_boost = 0.0;
 float sim_iat = 25.0;
 float sim_ect = 85.0;
-float sim_oil_press = 0.5;
-float sim_fuel_press = 3.0;
+float sim_oil_press = 50.0;    // kPa, as decoded
+float sim_fuel_press = 300.0;
 float sim_battery = 12.6;
 float sim_speed = 0.0;
 float sim_ethanol = 85.0;
@@ -1676,6 +3087,10 @@ float last_sim_ethanol = -1.0;
 float last_sim_lambda = -1;
 float last_sim_lambda_target = -1;
 
+// Signal validity as last drawn, so a stale gauge is redrawn once as "--"
+uint32_t gauge_drawn_valid = 0xFFFFFFFF;
+uint32_t last_lambda_valid = 0xFFFFFFFF;
+
 // Lambda gauge sprite for smooth updates (reuse existing declaration)
 
 // Simulation timing
@@ -1766,12 +3181,12 @@ void updateSimulationData() {
   sim_iat += (target_iat - sim_iat) * dt * 0.5;
 
   // Oil pressure
-  float target_oil_press = sim_engine_running ? 1.0 + sim_rpm * 0.0008 : 0.0;
+  float target_oil_press = sim_engine_running ? 100.0 + sim_rpm * 0.08 : 0.0;
   sim_oil_press += (target_oil_press - sim_oil_press) * dt * 2.0;
-  sim_oil_press = constrain(sim_oil_press, 0.0, 8.0);
+  sim_oil_press = constrain(sim_oil_press, 0.0, 800.0);
 
   // Fuel pressure
-  float target_fuel_press = sim_engine_running ? 3.0 + sim_throttle_input * 1.5 : 0.5;
+  float target_fuel_press = sim_engine_running ? 300.0 + sim_throttle_input * 150.0 : 50.0;
   sim_fuel_press += (target_fuel_press - sim_fuel_press) * dt * 1.0;
 
   // Battery voltage
@@ -1829,6 +3244,27 @@ void drawGaugeStatic(int x, int y, int w, int h, const char* label, const char*
   }
 }
 
+// Signals the gauges may show right now. Simulated data is always valid;
+// an estimated speed is as fresh as the RPM it is derived from.
+uint32_t gaugeValidMask() {
+  if (config.simulation_mode) return 0xFFFFFFFF;
+
+  uint32_t mask = ecu_data.signal_valid;
+  if (!signal_decoder.provides(SIG_VEHICLE_SPEED) && ecu_data.valid(SIG_RPM)) {
+    mask |= 1UL << SIG_VEHICLE_SPEED;
+  }
+  return mask;
+}
+
+// Gauge text for one signal, or "--" when it is stale or not in the stream
+void formatGaugeValue(char* out, const char* format, float value, uint32_t valid_mask, SignalId signal) {
+  if (valid_mask & (1UL << signal)) {
+    sprintf(out, format, value);
+  } else {
+    strcpy(out, "--");
+  }
+}
+
 // Efficient digit update - clears area then redraws value
 void updateGaugeValue(int x, int y, int w, int h, const char* new_value, const char* old_value, int value_size, uint16_t text_color) {
   // Only update if value changed
@@ -1905,11 +3341,23 @@ void drawOptimalGauge(int x, int y, int w, int h, const char* label, const char*
   }
 }
 
+// Lambda gauge source: simulation, or live CAN data with its validity
+void getLambdaReadout(float& lambda, float& lambda_target, uint32_t& valid) {
+  lambda = config.simulation_mode ? sim_lambda : ecu_data.lambda;
+  lambda_target = config.simulation_mode ? sim_lambda_target : ecu_data.lambda_target;
+  valid = gaugeValidMask() & ((1UL << SIG_LAMBDA) | (1UL << SIG_LAMBDA_TARGET));
+}
+
 // Efficient lambda gauge with sprite for smooth updates
 void drawOptimalLambdaGauge(int x, int y, int w, int h) {
-  // Only redraw if lambda values changed significantly
-  if (abs(sim_lambda - last_sim_lambda) < 0.005 &&
-      abs(sim_lambda_target - last_sim_lambda_target) < 0.005 &&
+  float lambda, lambda_target;
+  uint32_t valid;
+  getLambdaReadout(lambda, lambda_target, valid);
+
+  // Only redraw if lambda values or their validity changed significantly
+  if (abs(lambda - last_sim_lambda) < 0.005 &&
+      abs(lambda_target - last_sim_lambda_target) < 0.005 &&
+      valid == last_lambda_valid &&
       last_sim_lambda != -1) {
     return; // Skip redraw
   }
@@ -1966,33 +3414,37 @@ void drawOptimalLambdaGauge(int x, int y, int w, int h) {
   lambda_sprite.drawString("STOICH", bar_x + rich_w + stoich_w/2, bar_y - 20);
   lambda_sprite.drawString("LEAN", bar_x + rich_w + stoich_w + lean_w/2, bar_y - 20);
 
-  // Lambda triangles with simulated values
-  float lambda_norm = (sim_lambda - 0.6) / 0.8;
+  // Lambda triangles, hidden while their signal is stale
+  float lambda_norm = (lambda - 0.6) / 0.8;
   lambda_norm = constrain(lambda_norm, 0.0, 1.0);
   int lambda_x = bar_x + (lambda_norm * bar_w);
 
   uint16_t lambda_color = M5.Display.color565(255, 255, 100);
-  lambda_sprite.fillTriangle(lambda_x, bar_y - 5, lambda_x - 15, bar_y - 25, lambda_x + 15, bar_y - 25, lambda_color);
+  if (valid & (1UL << SIG_LAMBDA)) {
+    lambda_sprite.fillTriangle(lambda_x, bar_y - 5, lambda_x - 15, bar_y - 25, lambda_x + 15, bar_y - 25, lambda_color);
+  }
 
-  float target_norm = (sim_lambda_target - 0.6) / 0.8;
+  float target_norm = (lambda_target - 0.6) / 0.8;
   target_norm = constrain(target_norm, 0.0, 1.0);
   int target_x = bar_x + (target_norm * bar_w);
 
   uint16_t target_color = M5.Display.color565(255, 255, 255);
-  lambda_sprite.fillTriangle(target_x, bar_y + bar_h + 5, target_x - 15, bar_y + bar_h + 25, target_x + 15, bar_y + bar_h + 25, target_color);
+  if (valid & (1UL << SIG_LAMBDA_TARGET)) {
+    lambda_sprite.fillTriangle(target_x, bar_y + bar_h + 5, target_x - 15, bar_y + bar_h + 25, target_x + 15, bar_y + bar_h + 25, target_color);
+  }
 
   // Digital readouts
   lambda_sprite.setTextSize(4);
   lambda_sprite.setTextColor(lambda_color);
   lambda_sprite.setTextDatum(textdatum_t::middle_left);
   char lambda_str[10];
-  sprintf(lambda_str, "%.3f", sim_lambda);
+  formatGaugeValue(lambda_str, "%.3f", lambda, valid, SIG_LAMBDA);
   lambda_sprite.drawString(lambda_str, 30, sprite_h - 35);
 
   lambda_sprite.setTextColor(target_color);
   lambda_sprite.setTextDatum(textdatum_t::middle_right);
   char target_str[10];
-  sprintf(target_str, "%.3f", sim_lambda_target);
+  formatGaugeValue(target_str, "%.3f", lambda_target, valid, SIG_LAMBDA_TARGET);
   lambda_sprite.drawString(target_str, sprite_w - 30, sprite_h - 35);
 
   // Labels
@@ -2013,12 +3465,17 @@ void drawOptimalLambdaGauge(int x, int y, int w, int h) {
   lambda_sprite.pushSprite(x, y);
 
   // Update last values
-  last_sim_lambda = sim_lambda;
-  last_sim_lambda_target = sim_lambda_target;
+  last_sim_lambda = lambda;
+  last_sim_lambda_target = lambda_target;
+  last_lambda_valid = valid;
 }
 
 // Fallback direct drawing for lambda gauge
 void drawOptimalLambdaGaugeDirect(int x, int y, int w, int h) {
+  float lambda, lambda_target;
+  uint32_t valid;
+  getLambdaReadout(lambda, lambda_target, valid);
+
   // Direct drawing fallback if sprite creation fails
   M5.Display.fillRect(x, y, w, h, M5.Display.color565(20, 20, 40));
   M5.Display.drawRoundRect(x, y, w, h, 12, M5.Display.color565(0, 255, 255));
@@ -2048,32 +3505,36 @@ void drawOptimalLambdaGaugeDirect(int x, int y, int w, int h) {
   M5.Display.drawString("LEAN", bar_x + rich_w + stoich_w + lean_w/2, bar_y - 20);
 
   // Lambda triangles
-  float lambda_norm = (sim_lambda - 0.6) / 0.8;
+  float lambda_norm = (lambda - 0.6) / 0.8;
   lambda_norm = constrain(lambda_norm, 0.0, 1.0);
   int lambda_x = bar_x + (lambda_norm * bar_w);
 
   uint16_t lambda_color = M5.Display.color565(255, 255, 100);
-  M5.Display.fillTriangle(lambda_x, bar_y - 5, lambda_x - 15, bar_y - 25, lambda_x + 15, bar_y - 25, lambda_color);
+  if (valid & (1UL << SIG_LAMBDA)) {
+    M5.Display.fillTriangle(lambda_x, bar_y - 5, lambda_x - 15, bar_y - 25, lambda_x + 15, bar_y - 25, lambda_color);
+  }
 
-  float target_norm = (sim_lambda_target - 0.6) / 0.8;
+  float target_norm = (lambda_target - 0.6) / 0.8;
   target_norm = constrain(target_norm, 0.0, 1.0);
   int target_x = bar_x + (target_norm * bar_w);
 
   uint16_t target_color = M5.Display.color565(255, 255, 255);
-  M5.Display.fillTriangle(target_x, bar_y + bar_h + 5, target_x - 15, bar_y + bar_h + 25, target_x + 15, bar_y + bar_h + 25, target_color);
+  if (valid & (1UL << SIG_LAMBDA_TARGET)) {
+    M5.Display.fillTriangle(target_x, bar_y + bar_h + 5, target_x - 15, bar_y + bar_h + 25, target_x + 15, bar_y + bar_h + 25, target_color);
+  }
 
   // Digital readouts
   M5.Display.setTextSize(4);
   M5.Display.setTextColor(lambda_color);
   M5.Display.setTextDatum(textdatum_t::middle_left);
   char lambda_str[10];
-  sprintf(lambda_str, "%.3f", sim_lambda);
+  formatGaugeValue(lambda_str, "%.3f", lambda, valid, SIG_LAMBDA);
   M5.Display.drawString(lambda_str, x + 30, y + h - 35);
 
   M5.Display.setTextColor(target_color);
   M5.Display.setTextDatum(textdatum_t::middle_right);
   char target_str[10];
-  sprintf(target_str, "%.3f", sim_lambda_target);
+  formatGaugeValue(target_str, "%.3f", lambda_target, valid, SIG_LAMBDA_TARGET);
   M5.Display.drawString(target_str, x + w - 30, y + h - 35);
 
   // Labels
@@ -2135,6 +3596,8 @@ void resetGaugeStates() {
   last_sim_ethanol = -1.0;
   last_sim_lambda = -1;
   last_sim_lambda_target = -1;
+  gauge_drawn_valid = 0xFFFFFFFF;
+  last_lambda_valid = 0xFFFFFFFF;
 
   Serial.println("All gauge states reset for optimal dashboard");
 }
@@ -2234,16 +3697,16 @@ void showGaugesPage() {
                     "ECT", getTemperatureUnit(), M5.Display.color565(255, 100, 255), 3);
 
     drawGaugeStatic(gauge_positions[6].x, gauge_positions[6].y, gauge_positions[6].w, gauge_positions[6].h,
-                    "OIL PRESS", "BAR", M5.Display.color565(255, 200, 100), 2);
+                    "OIL PRESS", getFluidPressureUnit(), M5.Display.color565(255, 200, 100), 2);
 
     drawGaugeStatic(gauge_positions[7].x, gauge_positions[7].y, gauge_positions[7].w, gauge_positions[7].h,
-                    "FUEL PRESS", "BAR", M5.Display.color565(100, 255, 255), 2);
+                    "FUEL PRESS", getFluidPressureUnit(), M5.Display.color565(100, 255, 255), 2);
 
     drawGaugeStatic(gauge_positions[8].x, gauge_positions[8].y, gauge_positions[8].w, gauge_positions[8].h,
                     "BATTERY", "V", M5.Display.color565(255, 255, 100), 2);
 
     drawGaugeStatic(gauge_positions[9].x, gauge_positions[9].y, gauge_positions[9].w, gauge_positions[9].h,
-                    "SPEED", "KM/H", M5.Display.color565(0, 255, 255), 2);
+                    "SPEED", getSpeedUnit(), M5.Display.color565(0, 255, 255), 2);
 
     drawGaugeStatic(side_margin + 4*(bot_gauge_w + gap), bot_y, bot_gauge_w, row_height,
                     "ETHANOL", "%", M5.Display.color565(255, 0, 255), 2);
@@ -2287,53 +3750,59 @@ void showGaugesPage() {
   char last_rpm_str[10], last_tps_str[10], last_boost_str[10], last_iat_str[10], last_ect_str[10];
   char last_oil_press_str[10], last_fuel_press_str[10], last_battery_str[10], last_speed_str[10], last_ethanol_str[10];
 
+  uint32_t live_valid = gaugeValidMask();
+
   if (config.simulation_mode) {
     // Use simulation data
     sprintf(rpm_str, "%.0f", sim_rpm);
     sprintf(tps_str, "%.1f", sim_tps);
-    sprintf(boost_str, "%.1f", convertPressure(sim_boost));
-    sprintf(iat_str, "%.0f", convertTemperature(sim_iat));
-    sprintf(ect_str, "%.0f", convertTemperature(sim_ect));
-    sprintf(oil_press_str, "%.1f", sim_oil_press);
-    sprintf(fuel_press_str, "%.1f", sim_fuel_press);
+    sprintf(boost_str, "%.1f", displayValue(SIG_MGP, sim_boost));
+    sprintf(iat_str, "%.0f", displayValue(SIG_IAT, sim_iat));
+    sprintf(ect_str, "%.0f", displayValue(SIG_ECT, sim_ect));
+    sprintf(oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, sim_oil_press));
+    sprintf(fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, sim_fuel_press));
     sprintf(battery_str, "%.1f", sim_battery);
-    sprintf(speed_str, "%.0f", sim_speed);
+    sprintf(speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, sim_speed));
     sprintf(ethanol_str, "%.0f", sim_ethanol);
 
     sprintf(last_rpm_str, "%.0f", last_sim_rpm);
     sprintf(last_tps_str, "%.1f", last_sim_tps);
-    sprintf(last_boost_str, "%.1f", convertPressure(last_sim_boost));
-    sprintf(last_iat_str, "%.0f", convertTemperature(last_sim_iat));
-    sprintf(last_ect_str, "%.0f", convertTemperature(last_sim_ect));
-    sprintf(last_oil_press_str, "%.1f", last_sim_oil_press);
-    sprintf(last_fuel_press_str, "%.1f", last_sim_fuel_press);
+    sprintf(last_boost_str, "%.1f", displayValue(SIG_MGP, last_sim_boost));
+    sprintf(last_iat_str, "%.0f", displayValue(SIG_IAT, last_sim_iat));
+    sprintf(last_ect_str, "%.0f", displayValue(SIG_ECT, last_sim_ect));
+    sprintf(last_oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, last_sim_oil_press));
+    sprintf(last_fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, last_sim_fuel_press));
     sprintf(last_battery_str, "%.1f", last_sim_battery);
-    sprintf(last_speed_str, "%.0f", last_sim_speed);
+    sprintf(last_speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, last_sim_speed));
     sprintf(last_ethanol_str, "%.0f", last_sim_ethanol);
   } else {
     // Use real CAN data
-    sprintf(rpm_str, "%.0f", ecu_data.rpm);
-    sprintf(tps_str, "%.1f", ecu_data.tps);
-    sprintf(boost_str, "%.1f", convertPressure(ecu_data.mgp));
-    sprintf(iat_str, "%.0f", convertTemperature(ecu_data.iat));
-    sprintf(ect_str, "%.0f", convertTemperature(ecu_data.ect));
-    sprintf(oil_press_str, "%.1f", ecu_data.oil_press);
-    sprintf(fuel_press_str, "%.1f", ecu_data.fuel_press);
-    sprintf(battery_str, "%.1f", ecu_data.battery);
-    sprintf(speed_str, "%.0f", ecu_data.speed);
-    sprintf(ethanol_str, "%.0f", ecu_data.ethanol_percent);
+    formatGaugeValue(rpm_str, "%.0f", ecu_data.rpm, live_valid, SIG_RPM);
+    formatGaugeValue(tps_str, "%.1f", ecu_data.tps, live_valid, SIG_TPS);
+    formatGaugeValue(boost_str, "%.1f", displayValue(SIG_MGP, ecu_data.mgp), live_valid, SIG_MGP);
+    formatGaugeValue(iat_str, "%.0f", displayValue(SIG_IAT, ecu_data.iat), live_valid, SIG_IAT);
+    formatGaugeValue(ect_str, "%.0f", displayValue(SIG_ECT, ecu_data.ect), live_valid, SIG_ECT);
+    formatGaugeValue(oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, ecu_data.oil_press), live_valid, SIG_OIL_PRESS);
+    formatGaugeValue(fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, ecu_data.fuel_press), live_valid,
+                     SIG_FUEL_PRESS);
+    formatGaugeValue(battery_str, "%.1f", ecu_data.battery, live_valid, SIG_BATTERY);
+    formatGaugeValue(speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, ecu_data.speed), live_valid, SIG_VEHICLE_SPEED);
+    formatGaugeValue(ethanol_str, "%.0f", ecu_data.ethanol_percent, live_valid, SIG_ETHANOL);
 
     // For CAN data, use previous ecu_data values for comparison
-    sprintf(last_rpm_str, "%.0f", last_rpm_gauge_value);
-    sprintf(last_tps_str, "%.1f", last_tps_value);
-    sprintf(last_boost_str, "%.1f", convertPressure(last_boost_value));
-    sprintf(last_iat_str, "%.0f", convertTemperature(last_iat_value));
-    sprintf(last_ect_str, "%.0f", convertTemperature(last_ect_value));
-    sprintf(last_oil_press_str, "%.1f", last_oil_press_value);
-    sprintf(last_fuel_press_str, "%.1f", last_fuel_press_value);
-    sprintf(last_battery_str, "%.1f", last_battery_value);
-    sprintf(last_speed_str, "%.0f", last_speed_value);
-    sprintf(last_ethanol_str, "%.0f", last_ethanol_value);
+    formatGaugeValue(last_rpm_str, "%.0f", last_rpm_gauge_value, gauge_drawn_valid, SIG_RPM);
+    formatGaugeValue(last_tps_str, "%.1f", last_tps_value, gauge_drawn_valid, SIG_TPS);
+    formatGaugeValue(last_boost_str, "%.1f", displayValue(SIG_MGP, last_boost_value), gauge_drawn_valid, SIG_MGP);
+    formatGaugeValue(last_iat_str, "%.0f", displayValue(SIG_IAT, last_iat_value), gauge_drawn_valid, SIG_IAT);
+    formatGaugeValue(last_ect_str, "%.0f", displayValue(SIG_ECT, last_ect_value), gauge_drawn_valid, SIG_ECT);
+    formatGaugeValue(last_oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, last_oil_press_value), gauge_drawn_valid,
+                     SIG_OIL_PRESS);
+    formatGaugeValue(last_fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, last_fuel_press_value), gauge_drawn_valid,
+                     SIG_FUEL_PRESS);
+    formatGaugeValue(last_battery_str, "%.1f", last_battery_value, gauge_drawn_valid, SIG_BATTERY);
+    formatGaugeValue(last_speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, last_speed_value), gauge_drawn_valid,
+                     SIG_VEHICLE_SPEED);
+    formatGaugeValue(last_ethanol_str, "%.0f", last_ethanol_value, gauge_drawn_valid, SIG_ETHANOL);
   }
 
   // EFFICIENT UPDATES - Only update changed values
@@ -2397,6 +3866,7 @@ void showGaugesPage() {
     last_battery_value = ecu_data.battery;
     last_speed_value = ecu_data.speed;
     last_ethanol_value = ecu_data.ethanol_percent;
+    gauge_drawn_valid = live_valid;
   }
 
   // Bottom navigation (compact)
@@ -2497,7 +3967,7 @@ void drawBoostMapSelector(int x, int y, int w, int h) {
   M5.Display.setTextDatum(textdatum_t::bottom_center);
   char boost_str[20];
   float current_boost = config.simulation_mode ? sim_boost : ecu_data.mgp;
-  sprintf(boost_str, "%.1f %s", convertPressure(current_boost), getPressureUnit());
+  sprintf(boost_str, "%.1f %s", displayValue(SIG_MGP, current_boost), getPressureUnit());
   M5.Display.drawString(boost_str, x + w/2, y + h - 15);
 }
 
@@ -2544,7 +4014,7 @@ void drawBoostAdjustment(int x, int y, int w, int h) {
   M5.Display.setTextDatum(textdatum_t::bottom_center);
   char target_str[30];
   float current_boost = config.simulation_mode ? sim_boost : ecu_data.mgp;
-  sprintf(target_str, "Target: %.1f %s", convertPressure(current_boost + ecu_data.boost_adjustment), getPressureUnit());
+  sprintf(target_str, "Target: %.1f %s", displayValue(SIG_MGP, current_boost + ecu_data.boost_adjustment), getPressureUnit());
   M5.Display.drawString(target_str, x + w/2, y + h - 15);
 }
 
@@ -2592,6 +4062,22 @@ void drawSystemStatus(int x, int y, int w, int h) {
   M5.Display.drawString("ANTI-LAG:", x + 15, status_y + 3*line_height);
   M5.Display.setTextColor(TFT_WHITE);
   M5.Display.drawString(ecu_data.anti_lag_active ? "ACTIVE" : "OFF", x + 80, status_y + 3*line_height);
+
+  // ECU command link
+  const ECUCommandStats& cmd_stats = ecu_commands.stats();
+  uint8_t cmd_pending = ecu_commands.pendingCount();
+  char cmd_str[40];
+  if (!can_running) {
+    sprintf(cmd_str, "OFFLINE");
+  } else if (cmd_pending > 0) {
+    sprintf(cmd_str, "%d PENDING", cmd_pending);
+  } else {
+    sprintf(cmd_str, "OK %lums F:%lu", cmd_stats.last_latency_ms, cmd_stats.failed);
+  }
+  M5.Display.setTextColor(cmd_stats.failed > 0 ? M5.Display.color565(255, 100, 100) : M5.Display.color565(0, 255, 255));
+  M5.Display.drawString("ECU CMD:", x + 15, status_y + 4*line_height);
+  M5.Display.setTextColor(TFT_WHITE);
+  M5.Display.drawString(cmd_str, x + 80, status_y + 4*line_height);
 }
 
 // Draw quick preset button
@@ -2677,8 +4163,8 @@ void showControlPage() {
   // Boost Display (3rd control)
   char boost_current[15], boost_target[15];
   float current_boost = config.simulation_mode ? sim_boost : ecu_data.mgp;
-  sprintf(boost_current, "%.1f %s", convertPressure(current_boost), getPressureUnit());
-  sprintf(boost_target, "%.1f %s", convertPressure(current_boost + ecu_data.boost_adjustment), getPressureUnit());
+  sprintf(boost_current, "%.1f %s", displayValue(SIG_MGP, current_boost), getPressureUnit());
+  sprintf(boost_target, "%.1f %s", displayValue(SIG_MGP, current_boost + ecu_data.boost_adjustment), getPressureUnit());
   drawControlButton(side_margin + 2*(top_control_w + gap), top_y, top_control_w, row_height,
                     "BOOST DISPLAY", boost_current, ecu_data.boost_control_active,
                     M5.Display.color565(255, 165, 0));
@@ -2790,14 +4276,14 @@ void setup() {
     // Perform actual initialization at specific progress points
     if (progress == 20) {
       loadConfig();
+      configureSignalDecoder();
+      configureLogging();
       Serial.println("Configuration loaded");
     } else if (progress == 50) {
       // Initialize CAN bus if not in simulation mode
-      if (!config.simulation_mode) {
-        if (!initializeCAN()) {
-          Serial.println("Falling back to simulation mode");
-          config.simulation_mode = true;
-        }
+      if (!config.simulation_mode && !startLiveCAN()) {
+        Serial.println("Falling back to simulation mode");
+        config.simulation_mode = true;
       }
       if (config.simulation_mode) {
         Serial.println("Starting in simulation mode");
@@ -2860,11 +4346,14 @@ bool handleConfigTouch(int x, int y) {
   int section_w = screen_w - 40;
   int section_x = 20;
 
-  // Handle section touches based on current tab
+  // Handle section touches based on current tab. Data source, stream
+  // type and CAN speed end a running replay first: it is the only producer
+  // on can_rx_ring, and it restores the data source when it stops.
   switch (current_config_tab) {
     case TAB_BASIC:
       // Data Source section
       if (y >= section_y && y <= section_y + section_h) {
+        stopCANReplay();
         config.simulation_mode = !config.simulation_mode;
         saveConfig();
         showConfigurationPage(); // Refresh display
@@ -2875,30 +4364,51 @@ bool handleConfigTouch(int x, int y) {
 
       // Stream Type section
       if (y >= section_y && y <= section_y + section_h) {
-        config.use_custom_streams = !config.use_custom_streams;
+        stopCANReplay();
+        switch (config.stream_protocol) {
+          case STREAM_CUSTOM: config.stream_protocol = STREAM_HALTECH_IC7; break;
+          case STREAM_HALTECH_IC7: config.stream_protocol = STREAM_GENERIC_DASH2; break;
+          case STREAM_GENERIC_DASH2: config.stream_protocol = STREAM_CUSTOM; break;
+        }
         saveConfig();
+        configureSignalDecoder();
+        restartCANIfRunning();
         showConfigurationPage(); // Refresh display
-        Serial.printf("Stream type changed to: %s\n", config.use_custom_streams ? "Custom Stream" : "Haltech IC7");
+        Serial.printf("Stream type changed to: %s\n", getStreamProtocolName());
         return true;
       }
       section_y += section_h + section_spacing;
 
       // CAN Speed section
       if (y >= section_y && y <= section_y + section_h) {
-        // Cycle through CAN speeds
-        switch (config.can_speed) {
-          case 125000: config.can_speed = 250000; break;
-          case 250000: config.can_speed = 500000; break;
-          case 500000: config.can_speed = 1000000; break;
-          case 1000000: config.can_speed = 125000; break;
-          default: config.can_speed = 500000; break;
+        stopCANReplay();
+        // Cycle through CAN speeds, then AUTO
+        if (config.can_auto_detect) {
+          config.can_auto_detect = false;
+          config.can_speed = 125000;
+        } else {
+          switch (config.can_speed) {
+            case 125000: config.can_speed = 250000; break;
+            case 250000: config.can_speed = 500000; break;
+            case 500000: config.can_speed = 1000000; break;
+            case 1000000: config.can_auto_detect = true; break;
+            default: config.can_speed = 500000; break;
+          }
         }
         saveConfig();
 
-        // Reinitialize CAN bus with new speed if not in simulation mode
-        if (!config.simulation_mode) {
+        if (!config.simulation_mode && config.can_auto_detect) {
+          resetCANStats();
+          if (!startLiveCAN()) {
+            Serial.println("CAN reinitialization failed! Falling back to simulation mode");
+            config.simulation_mode = true;
+            saveConfig();
+          }
+        } else if (!config.simulation_mode) {
+          // Reinitialize CAN bus with new speed
+          stopCANAutoDetect();
           Serial.printf("Reinitializing CAN bus at %d kbps...\n", config.can_speed / 1000);
-          ESP32Can.end(); // Stop current CAN
+          shutdownCAN(); // Stop RX task and current CAN
           delay(100);     // Brief delay for cleanup
           if (!initializeCAN()) {
             Serial.println("CAN reinitialization failed! Falling back to simulation mode");
@@ -2930,6 +4440,7 @@ bool handleConfigTouch(int x, int y) {
       // Units section
       if (y >= section_y && y <= section_y + section_h) {
         config.units = (config.units == METRIC) ? IMPERIAL : METRIC;
+        applyUnitSystem();
         saveConfig();
         showConfigurationPage(); // Refresh display
         Serial.printf("Units changed to: %s\n", getUnitSystemName());
@@ -2948,6 +4459,7 @@ bool handleConfigTouch(int x, int y) {
           case LOG_FULL: config.logging_mode = LOG_SESSION; break;
           case LOG_SESSION: config.logging_mode = LOG_DISABLED; break;
         }
+        configureLogging();
         saveConfig();
         showConfigurationPage(); // Refresh display
         Serial.printf("Logging mode changed to: %s\n", getLoggingModeName());
@@ -2981,6 +4493,7 @@ bool handleConfigTouch(int x, int y) {
           case BUFFER_LARGE: config.buffer_size = BUFFER_CUSTOM; break;
           case BUFFER_CUSTOM: config.buffer_size = BUFFER_SMALL; break;
         }
+        configureLogging();
         saveConfig();
         showConfigurationPage(); // Refresh display
         Serial.printf("Buffer size changed to: %s (%d frames)\n", getBufferSizeName(), getBufferFrameCount());
@@ -3001,11 +4514,28 @@ bool handleConfigTouch(int x, int y) {
           case 100: config.max_file_size_mb = 1; break;
           default: config.max_file_size_mb = 10; break;
         }
+        // The writer takes the new limit with its next file set
+        stopLogWriter();
+        configureLogging();
         saveConfig();
         showConfigurationPage(); // Refresh display
         Serial.printf("Storage settings changed to: %dMB x%d files\n", config.max_file_size_mb, config.max_files);
         return true;
       }
+      if (isLoggingEnabled()) {
+        section_y += section_h + section_spacing;
+      }
+
+      // Session panel (only in LOG_SESSION): start or stop recording
+      if (config.logging_mode == LOG_SESSION && y >= section_y && y <= section_y + CAPTURE_PANEL_H) {
+        if (sessionRecording()) {
+          stopLogWriter();
+        } else {
+          startSessionRecording();
+        }
+        showConfigurationPage(); // Refresh display
+        return true;
+      }
       break;
 
     case TAB_CAN_MONITOR:
@@ -3023,6 +4553,26 @@ bool handleConfigTouch(int x, int y) {
           Serial.println("CAN statistics reset");
           return true;
         }
+
+        // Next page of seen IDs
+        int page_button_x = button_x - button_w - 20;
+        if (x >= page_button_x && x <= page_button_x + button_w &&
+            y >= button_y && y <= button_y + button_h) {
+          can_monitor_page++;
+          showConfigurationPage(); // Refresh display
+          return true;
+        }
+
+        // Promiscuous override
+        int filter_button_x = page_button_x - button_w - 20;
+        if (x >= filter_button_x && x <= filter_button_x + button_w &&
+            y >= button_y && y <= button_y + button_h) {
+          can_promiscuous = !can_promiscuous;
+          restartCANIfRunning();
+          showConfigurationPage(); // Refresh display
+          Serial.printf("CAN acceptance filter %s\n", can_promiscuous ? "bypassed (all IDs)" : "enabled");
+          return true;
+        }
       }
       break;
   }
@@ -3098,6 +4648,8 @@ bool handleCalculatorTouch(int x, int y) {
   if (x >= modal_x + 200 && x <= modal_x + 320 && y >= ctrl_y && y <= ctrl_y + 50) {
     config.base_can_id = calculator_value;
     saveConfig();
+    configureSignalDecoder();
+    restartCANIfRunning();
     calculator_mode = false;
     showConfigurationPage();
     Serial.printf("CAN ID changed to: 0x%03X (%d)\n", config.base_can_id, config.base_can_id);
@@ -3193,6 +4745,7 @@ bool handleControlTouch(int x, int y) {
       int btn_x = side_margin + 15 + (i-1) * (btn_w + 10);
       if (x >= btn_x && x <= btn_x + btn_w && y >= btn_y && y <= btn_y + 40) {
         ecu_data.current_boost_map = i;
+        sendECUCommand(CMD_BOOST_MAP, i);
         Serial.printf("🗺️ Boost map changed to: %d\n", i);
         showControlPage(); // Refresh display
         return true;
@@ -3214,6 +4767,7 @@ bool handleControlTouch(int x, int y) {
         y >= btn_y && y <= btn_y + btn_h) {
       ecu_data.boost_adjustment -= 2.5;
       ecu_data.boost_adjustment = constrain(ecu_data.boost_adjustment, -10.0, 10.0);
+      sendBoostAdjustment();
       Serial.printf("⬇️ Boost adjustment: %.1f PSI\n", ecu_data.boost_adjustment);
       showControlPage();
       return true;
@@ -3224,6 +4778,7 @@ bool handleControlTouch(int x, int y) {
         y >= btn_y && y <= btn_y + btn_h) {
       ecu_data.boost_adjustment += 2.5;
       ecu_data.boost_adjustment = constrain(ecu_data.boost_adjustment, -10.0, 10.0);
+      sendBoostAdjustment();
       Serial.printf("⬆️ Boost adjustment: %.1f PSI\n", ecu_data.boost_adjustment);
       showControlPage();
       return true;
@@ -3246,6 +4801,7 @@ bool handleControlTouch(int x, int y) {
   if (x >= side_margin + top_control_w + gap && x <= side_margin + 2*top_control_w + gap &&
       y >= mid_y && y <= mid_y + row_height) {
     ecu_data.launch_control_active = !ecu_data.launch_control_active;
+    sendECUCommand(CMD_LAUNCH, ecu_data.launch_control_active ? 1 : 0);
     Serial.printf("🚀 Launch control: %s\n", ecu_data.launch_control_active ? "ACTIVE" : "OFF");
     showControlPage();
     return true;
@@ -3255,6 +4811,7 @@ bool handleControlTouch(int x, int y) {
   if (x >= side_margin + 2*(top_control_w + gap) && x <= side_margin + 3*top_control_w + 2*gap &&
       y >= mid_y && y <= mid_y + row_height) {
     ecu_data.anti_lag_active = !ecu_data.anti_lag_active;
+    sendECUCommand(CMD_ANTI_LAG, ecu_data.anti_lag_active ? 1 : 0);
     Serial.printf("💥 Anti-lag: %s\n", ecu_data.anti_lag_active ? "ACTIVE" : "OFF");
     showControlPage();
     return true;
@@ -3339,6 +4896,15 @@ void applyPreset(ControlPreset preset) {
       break;
   }
 
+  // Queue the whole preset; it leaves as one burst on the next loop pass
+  sendECUCommand(CMD_BOOST_MAP, ecu_data.current_boost_map);
+  sendBoostAdjustment();
+  sendECUCommand(CMD_LAUNCH, ecu_data.launch_control_active ? 1 : 0);
+  sendECUCommand(CMD_ANTI_LAG, ecu_data.anti_lag_active ? 1 : 0);
+  if (preset == PRESET_SAFE) {
+    sendECUCommand(CMD_SAFE_MODE, 1);
+  }
+
   showControlPage(); // Refresh display
 }
 
@@ -3362,11 +4928,30 @@ void loop() {
     }
   }
 
-  // Read CAN data or simulate
-  if (config.simulation_mode) {
+  serviceSerialCommands();
+
+  // Read CAN data (live or replayed) or simulate
+  if (replay_active) {
+    serviceCANReplay();
+    readCANData();
+  } else if (config.simulation_mode) {
     simulateData();
   } else {
     readCANData();
+    serviceCANAutoDetect();
+  }
+  serviceLogWriter();
+
+  // Recovery did not complete - reinstall the driver
+  if (can_restart_requested) {
+    can_restart_requested = false;
+    Serial.println("CAN bus recovery timed out, restarting driver");
+    restartCANIfRunning();
+  }
+
+  // Send queued ECU commands (non-blocking)
+  if (can_running) {
+    ecu_commands.service(millis(), transmitECUCommand);
   }
 
   // Simple data output every 5 seconds (less frequent during config)
@@ -3401,52 +4986,58 @@ void loop() {
         char last_rpm_str[10], last_tps_str[10], last_boost_str[10], last_iat_str[10], last_ect_str[10];
         char last_oil_press_str[10], last_fuel_press_str[10], last_battery_str[10], last_speed_str[10], last_ethanol_str[10];
 
+        uint32_t live_valid = gaugeValidMask();
+
         if (config.simulation_mode) {
           // Use simulation data
           sprintf(rpm_str, "%.0f", sim_rpm);
           sprintf(tps_str, "%.1f", sim_tps);
-          sprintf(boost_str, "%.1f", convertPressure(sim_boost));
-          sprintf(iat_str, "%.0f", convertTemperature(sim_iat));
-          sprintf(ect_str, "%.0f", convertTemperature(sim_ect));
-          sprintf(oil_press_str, "%.1f", sim_oil_press);
-          sprintf(fuel_press_str, "%.1f", sim_fuel_press);
+          sprintf(boost_str, "%.1f", displayValue(SIG_MGP, sim_boost));
+          sprintf(iat_str, "%.0f", displayValue(SIG_IAT, sim_iat));
+          sprintf(ect_str, "%.0f", displayValue(SIG_ECT, sim_ect));
+          sprintf(oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, sim_oil_press));
+          sprintf(fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, sim_fuel_press));
           sprintf(battery_str, "%.1f", sim_battery);
-          sprintf(speed_str, "%.0f", sim_speed);
+          sprintf(speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, sim_speed));
           sprintf(ethanol_str, "%.0f", sim_ethanol);
 
           sprintf(last_rpm_str, "%.0f", last_sim_rpm);
           sprintf(last_tps_str, "%.1f", last_sim_tps);
-          sprintf(last_boost_str, "%.1f", convertPressure(last_sim_boost));
-          sprintf(last_iat_str, "%.0f", convertTemperature(last_sim_iat));
-          sprintf(last_ect_str, "%.0f", convertTemperature(last_sim_ect));
-          sprintf(last_oil_press_str, "%.1f", last_sim_oil_press);
-          sprintf(last_fuel_press_str, "%.1f", last_sim_fuel_press);
+          sprintf(last_boost_str, "%.1f", displayValue(SIG_MGP, last_sim_boost));
+          sprintf(last_iat_str, "%.0f", displayValue(SIG_IAT, last_sim_iat));
+          sprintf(last_ect_str, "%.0f", displayValue(SIG_ECT, last_sim_ect));
+          sprintf(last_oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, last_sim_oil_press));
+          sprintf(last_fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, last_sim_fuel_press));
           sprintf(last_battery_str, "%.1f", last_sim_battery);
-          sprintf(last_speed_str, "%.0f", last_sim_speed);
+          sprintf(last_speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, last_sim_speed));
           sprintf(last_ethanol_str, "%.0f", last_sim_ethanol);
         } else {
           // Use real CAN data
-          sprintf(rpm_str, "%.0f", ecu_data.rpm);
-          sprintf(tps_str, "%.1f", ecu_data.tps);
-          sprintf(boost_str, "%.1f", convertPressure(ecu_data.mgp));
-          sprintf(iat_str, "%.0f", convertTemperature(ecu_data.iat));
-          sprintf(ect_str, "%.0f", convertTemperature(ecu_data.ect));
-          sprintf(oil_press_str, "%.1f", ecu_data.oil_press);
-          sprintf(fuel_press_str, "%.1f", ecu_data.fuel_press);
-          sprintf(battery_str, "%.1f", ecu_data.battery);
-          sprintf(speed_str, "%.0f", ecu_data.speed);
-          sprintf(ethanol_str, "%.0f", ecu_data.ethanol_percent);
-
-          sprintf(last_rpm_str, "%.0f", last_rpm_gauge_value);
-          sprintf(last_tps_str, "%.1f", last_tps_value);
-          sprintf(last_boost_str, "%.1f", convertPressure(last_boost_value));
-          sprintf(last_iat_str, "%.0f", convertTemperature(last_iat_value));
-          sprintf(last_ect_str, "%.0f", convertTemperature(last_ect_value));
-          sprintf(last_oil_press_str, "%.1f", last_oil_press_value);
-          sprintf(last_fuel_press_str, "%.1f", last_fuel_press_value);
-          sprintf(last_battery_str, "%.1f", last_battery_value);
-          sprintf(last_speed_str, "%.0f", last_speed_value);
-          sprintf(last_ethanol_str, "%.0f", last_ethanol_value);
+          formatGaugeValue(rpm_str, "%.0f", ecu_data.rpm, live_valid, SIG_RPM);
+          formatGaugeValue(tps_str, "%.1f", ecu_data.tps, live_valid, SIG_TPS);
+          formatGaugeValue(boost_str, "%.1f", displayValue(SIG_MGP, ecu_data.mgp), live_valid, SIG_MGP);
+          formatGaugeValue(iat_str, "%.0f", displayValue(SIG_IAT, ecu_data.iat), live_valid, SIG_IAT);
+          formatGaugeValue(ect_str, "%.0f", displayValue(SIG_ECT, ecu_data.ect), live_valid, SIG_ECT);
+          formatGaugeValue(oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, ecu_data.oil_press), live_valid, SIG_OIL_PRESS);
+          formatGaugeValue(fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, ecu_data.fuel_press), live_valid,
+                           SIG_FUEL_PRESS);
+          formatGaugeValue(battery_str, "%.1f", ecu_data.battery, live_valid, SIG_BATTERY);
+          formatGaugeValue(speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, ecu_data.speed), live_valid, SIG_VEHICLE_SPEED);
+          formatGaugeValue(ethanol_str, "%.0f", ecu_data.ethanol_percent, live_valid, SIG_ETHANOL);
+
+          formatGaugeValue(last_rpm_str, "%.0f", last_rpm_gauge_value, gauge_drawn_valid, SIG_RPM);
+          formatGaugeValue(last_tps_str, "%.1f", last_tps_value, gauge_drawn_valid, SIG_TPS);
+          formatGaugeValue(last_boost_str, "%.1f", displayValue(SIG_MGP, last_boost_value), gauge_drawn_valid, SIG_MGP);
+          formatGaugeValue(last_iat_str, "%.0f", displayValue(SIG_IAT, last_iat_value), gauge_drawn_valid, SIG_IAT);
+          formatGaugeValue(last_ect_str, "%.0f", displayValue(SIG_ECT, last_ect_value), gauge_drawn_valid, SIG_ECT);
+          formatGaugeValue(last_oil_press_str, "%.1f", displayValue(SIG_OIL_PRESS, last_oil_press_value), gauge_drawn_valid,
+                           SIG_OIL_PRESS);
+          formatGaugeValue(last_fuel_press_str, "%.1f", displayValue(SIG_FUEL_PRESS, last_fuel_press_value), gauge_drawn_valid,
+                           SIG_FUEL_PRESS);
+          formatGaugeValue(last_battery_str, "%.1f", last_battery_value, gauge_drawn_valid, SIG_BATTERY);
+          formatGaugeValue(last_speed_str, "%.0f", displayValue(SIG_VEHICLE_SPEED, last_speed_value), gauge_drawn_valid,
+                           SIG_VEHICLE_SPEED);
+          formatGaugeValue(last_ethanol_str, "%.0f", last_ethanol_value, gauge_drawn_valid, SIG_ETHANOL);
         }
 
         // Update only changed values
@@ -3499,6 +5090,7 @@ void loop() {
           last_battery_value = ecu_data.battery;
           last_speed_value = ecu_data.speed;
           last_ethanol_value = ecu_data.ethanol_percent;
+          gauge_drawn_valid = live_valid;
         }
       }
 
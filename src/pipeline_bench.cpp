@@ -0,0 +1,250 @@
+// Link G4X Monitor - Receive path benchmark suite
+#include "pipeline_bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "can_capture.h"
+#include "can_pipeline.h"
+#include "session_log.h"
+#include "signal_changes.h"
+#include "units.h"
+
+#ifdef ARDUINO
+#include <esp_cpu.h>
+#include <esp_timer.h>
+
+static inline uint64_t benchNanos() { return (uint64_t)esp_timer_get_time() * 1000; }
+static inline uint64_t benchCycles() { return esp_cpu_get_cycle_count(); }
+// 32-bit counter: one case must finish within 2^32 cycles (~12s at 360MHz)
+static inline uint64_t cycleDelta(uint64_t start, uint64_t end) { return (uint32_t)end - (uint32_t)start; }
+static const char* const BENCH_CYCLE_CLOCK = "mcycle";
+#else
+#include <time.h>
+
+static inline uint64_t benchNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t benchCycles() { return __rdtsc(); }
+static const char* const BENCH_CYCLE_CLOCK = "tsc";
+#else
+static inline uint64_t benchCycles() { return 0; }
+static const char* const BENCH_CYCLE_CLOCK = "none";
+#endif
+static inline uint64_t cycleDelta(uint64_t start, uint64_t end) { return end - start; }
+#endif
+
+// Keep the compiler from merging or dropping stores across frames
+static inline void clobberMemory() {
+  asm volatile("" : : : "memory");
+}
+
+// ========== FRAME MIXES ==========
+// One entry per ID on the bus at its broadcast rate; frames are laid out
+// in the order a real bus would deliver them
+struct MixRate {
+  uint32_t id;
+  uint8_t extended;
+  uint16_t hz;
+};
+
+static const MixRate CUSTOM_MIX[] = {
+  {CUSTOM_STREAM_ID_1, 0, 20}, {CUSTOM_STREAM_ID_2, 0, 20}, {CUSTOM_STREAM_ID_3, 0, 10},
+};
+
+static const MixRate IC7_MIX[] = {
+  {0x360, 0, 50}, {0x361, 0, 50}, {0x362, 0, 50}, {0x368, 0, 20}, {0x3E0, 0, 5},
+};
+
+static const MixRate DASH2_MIX[] = {
+  {GENERIC_DASH2_ID_1, 0, 20}, {GENERIC_DASH2_ID_1 + 1, 0, 20},
+  {GENERIC_DASH2_ID_1 + 2, 0, 20}, {GENERIC_DASH2_ID_1 + 3, 0, 20},
+};
+
+// IC7 sharing a vehicle bus with body/chassis traffic and J1939-style
+// 29-bit IDs: most frames miss the decoder
+static const MixRate VEHICLE_MIX[] = {
+  {0x360, 0, 50}, {0x361, 0, 50}, {0x362, 0, 50}, {0x368, 0, 20}, {0x3E0, 0, 5},
+  {0x080, 0, 100}, {0x0A0, 0, 100}, {0x0C0, 0, 100}, {0x100, 0, 100}, {0x120, 0, 50},
+  {0x140, 0, 50}, {0x1A0, 0, 50}, {0x1C0, 0, 50}, {0x200, 0, 50}, {0x220, 0, 50},
+  {0x280, 0, 20}, {0x2A0, 0, 20}, {0x2C0, 0, 20}, {0x300, 0, 20}, {0x320, 0, 20},
+  {0x400, 0, 10}, {0x420, 0, 10}, {0x440, 0, 10}, {0x4A0, 0, 10}, {0x580, 0, 10},
+  {0x5A0, 0, 10}, {0x6A0, 0, 5}, {0x6C0, 0, 5}, {0x7DF, 0, 1},
+  {0x18FEF100, 1, 10}, {0x18FEEE00, 1, 1}, {0x18FEF200, 1, 10},
+  {0x0CF00400, 1, 100}, {0x18F00500, 1, 10}, {0x18FEE500, 1, 1},
+};
+
+#define MIX_COUNT(mix) (uint8_t)(sizeof(mix) / sizeof(mix[0]))
+#define MIX_MAX_IDS 40
+#define BENCH_BACKLOG_BATCH 128   // Frames per backlogged batch, ~16ms at full 1Mbps load
+#define BENCH_CAPTURE_FRAMES 2000 // Largest LOG_FULL buffer size
+
+static RxFrame bench_frames[BENCH_MIX_FRAMES];
+
+static void buildMix(const MixRate* rates, uint8_t count, RxFrame* frames) {
+  uint32_t next_us[MIX_MAX_IDS];
+  for (uint8_t i = 0; i < count; i++) next_us[i] = i * 137;   // Stagger the first frames
+
+  uint32_t seed = 0x12345678;
+  for (uint32_t n = 0; n < BENCH_MIX_FRAMES; n++) {
+    uint8_t k = 0;
+    for (uint8_t i = 1; i < count; i++) {
+      if (next_us[i] < next_us[k]) k = i;
+    }
+
+    RxFrame& frame = frames[n];
+    frame.timestamp_us = next_us[k];
+    frame.identifier = rates[k].id;
+    frame.extended = rates[k].extended;
+    frame.data_length = 8;
+    for (int b = 0; b < 8; b++) {
+      seed = seed * 1664525u + 1013904223u;
+      frame.data[b] = seed >> 24;
+    }
+    next_us[k] += 1000000 / rates[k].hz;
+  }
+}
+
+// ========== TIMING ==========
+struct BenchRun {
+  const char* platform;
+  uint32_t passes;
+  BenchPrintFn print;
+};
+
+template <typename Fn>
+static void timeCase(const BenchRun& run, const char* bench, const char* mix, Fn&& fn) {
+  // One untimed pass warms the caches and branch predictors
+  for (uint32_t i = 0; i < BENCH_MIX_FRAMES; i++) fn(bench_frames[i]);
+
+  uint64_t start_ns = benchNanos();
+  uint64_t start_cycles = benchCycles();
+  for (uint32_t p = 0; p < run.passes; p++) {
+    for (uint32_t i = 0; i < BENCH_MIX_FRAMES; i++) {
+      fn(bench_frames[i]);
+      clobberMemory();
+    }
+  }
+  uint64_t cycles = cycleDelta(start_cycles, benchCycles());
+  uint64_t ns = benchNanos() - start_ns;
+
+  uint32_t frames = run.passes * BENCH_MIX_FRAMES;
+  char line[BENCH_LINE_MAX];
+  snprintf(line, sizeof(line),
+           "{\"bench\":\"%s\",\"mix\":\"%s\",\"platform\":\"%s\",\"frames\":%u,"
+           "\"ns_per_frame\":%.1f,\"cycles_per_frame\":%.1f,\"cycle_clock\":\"%s\"}",
+           bench, mix, run.platform, (unsigned)frames, (double)ns / frames, (double)cycles / frames,
+           BENCH_CYCLE_CLOCK);
+  run.print(line);
+}
+
+// ========== CASES ==========
+static SignalDecoder bench_decoder;
+static CANStatsTable bench_stats;
+static BusLoadMeter bench_bus_load;
+static ECUData bench_data;
+static DisplayScale bench_scales[SIG_COUNT];
+static CANCaptureRing bench_capture;
+static SignalChangeEncoder bench_encoder;
+static uint8_t bench_group[SIGNAL_CHANGE_GROUP_MAX];
+static SessionLogEncoder bench_session;
+static uint8_t bench_chunk[SESSION_CHUNK_MAX];
+static volatile float bench_sink;
+
+// Decode alone, then the whole per-frame pipeline, on one mix
+static void timeDecoder(const BenchRun& run, const char* mix) {
+  timeCase(run, "decode", mix, [](const RxFrame& frame) {
+    if (!frame.extended) {
+      bench_decoder.decode(frame.identifier, frame.data, frame.data_length, bench_data, frame.timestamp_us / 1000);
+    }
+  });
+
+  static CANPipeline pipeline(bench_stats, bench_bus_load, bench_decoder, bench_data);
+  bench_stats.clear();
+  bench_bus_load.reset(0);
+  timeCase(run, "pipeline", mix, [](const RxFrame& frame) {
+    pipeline.process(frame, frame.timestamp_us / 1000, frame.timestamp_us);
+  });
+
+  // The same frames arriving in backlogged batches, decoded newest-first
+  static uint32_t batched;
+  batched = 0;
+  timeCase(run, "pipeline_backlog", mix, [](const RxFrame& frame) {
+    pipeline.defer(frame, frame.timestamp_us / 1000, frame.timestamp_us);
+    if (++batched % BENCH_BACKLOG_BATCH == 0) {
+      pipeline.flushDeferred(frame.timestamp_us / 1000, frame.timestamp_us, [](const RxFrame&) {});
+    }
+  });
+}
+
+bool runPipelineBenchmarks(const char* platform, uint32_t passes, BenchPrintFn print) {
+  if (!bench_stats.allocate()) return false;
+  BenchRun run = {platform, passes, print};
+
+  buildMix(CUSTOM_MIX, MIX_COUNT(CUSTOM_MIX), bench_frames);
+  bench_decoder.configure(CUSTOM_STREAM_FRAMES.data(), CUSTOM_STREAM_FRAMES.size());
+  timeDecoder(run, "custom");
+
+  // What a gauge redraw converts per decoded update, in imperial units
+  buildDisplayScales(IMPERIAL, bench_scales);
+  timeCase(run, "units", "custom", [](const RxFrame&) {
+    float sum = bench_scales[SIG_ECT].apply(bench_data.ect) + bench_scales[SIG_IAT].apply(bench_data.iat) +
+                bench_scales[SIG_OIL_TEMP].apply(bench_data.oil_temp) + bench_scales[SIG_MGP].apply(bench_data.mgp) +
+                bench_scales[SIG_OIL_PRESS].apply(bench_data.oil_press) +
+                bench_scales[SIG_FUEL_PRESS].apply(bench_data.fuel_press) +
+                bench_scales[SIG_VEHICLE_SPEED].apply(bench_data.speed);
+    bench_sink = sum;
+  });
+
+  buildMix(DASH2_MIX, MIX_COUNT(DASH2_MIX), bench_frames);
+  bench_decoder.configure(GENERIC_DASH2_FRAMES.data(), GENERIC_DASH2_FRAMES.size());
+  timeDecoder(run, "dash2");
+
+  buildMix(IC7_MIX, MIX_COUNT(IC7_MIX), bench_frames);
+  bench_decoder.configure(HALTECH_IC7_FRAMES.data(), HALTECH_IC7_FRAMES.size(), 864);
+  timeDecoder(run, "ic7");
+
+  // LOG_CHANGES sampling after every frame: random payloads move nearly
+  // every signal past its deadband, so this is the worst case (decode
+  // included; compare with "decode" on the same mix)
+  bench_encoder.restart();
+  timeCase(run, "signal_changes", "ic7", [](const RxFrame& frame) {
+    uint32_t now_ms = frame.timestamp_us / 1000;
+    bench_decoder.decode(frame.identifier, frame.data, frame.data_length, bench_data, now_ms);
+    bench_sink = bench_encoder.encode(bench_data, now_ms, bench_group);
+  });
+
+  // LOG_SESSION sampling after every frame, chunks closed into a buffer
+  // of their own (decode included, as above)
+  if (!bench_session.allocated() && !bench_session.allocate(16)) return false;
+  bench_session.begin(bench_frames[0].timestamp_us / 1000);
+  timeCase(run, "session_sample", "ic7", [](const RxFrame& frame) {
+    uint32_t now_ms = frame.timestamp_us / 1000;
+    bench_decoder.decode(frame.identifier, frame.data, frame.data_length, bench_data, now_ms);
+    if (bench_session.chunkDue(now_ms)) bench_session.closeChunk(bench_chunk, 0, 0, now_ms);
+    bench_session.sample(bench_data, now_ms);
+  });
+
+  buildMix(VEHICLE_MIX, MIX_COUNT(VEHICLE_MIX), bench_frames);
+  timeDecoder(run, "vehicle");
+
+  bench_stats.clear();
+  timeCase(run, "stats_update", "vehicle", [](const RxFrame& frame) {
+    bench_stats.update(frame, frame.timestamp_us / 1000);
+  });
+
+  bench_bus_load.reset(0);
+  timeCase(run, "bus_load", "vehicle", [](const RxFrame& frame) {
+    bench_bus_load.addFrame(frame.extended, frame.data_length, frame.timestamp_us);
+  });
+
+  // What LOG_FULL adds to the receive task: the ring stays full, so every
+  // push also discards the oldest record
+  if (!bench_capture.allocated() && !bench_capture.allocate(BENCH_CAPTURE_FRAMES)) return false;
+  bench_capture.setPolicy(CAPTURE_KEEP_NEWEST);
+  timeCase(run, "capture_push", "vehicle", [](const RxFrame& frame) { bench_capture.push(frame); });
+  return true;
+}
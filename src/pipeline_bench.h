@@ -0,0 +1,30 @@
+// Link G4X Monitor - Receive path benchmark suite
+//
+// Times what one frame costs in each stage of the receive path - decode
+// per stream layout, the per-ID statistics update, bus load accounting,
+// the LOG_FULL capture copy, LOG_CHANGES and LOG_SESSION encoding, the
+// whole CANPipeline in order and under backlog - plus the display unit
+// conversion, on frame mixes built from each stream's real broadcast
+// rates. The same code runs on the host (./build.sh bench) and on the
+// Tab5 (serial console "bench"), on objects of its own, so live
+// statistics are left alone.
+//
+// Every result is one JSON line, e.g.
+//   {"bench":"decode","mix":"ic7","platform":"esp32p4","frames":51200,
+//    "ns_per_frame":412.3,"cycles_per_frame":148.4,"cycle_clock":"mcycle"}
+// so runs can be collected and compared when a decoder changes. Cycles
+// come from the CPU cycle counter on the ESP32-P4 and the TSC on x86
+// hosts (reference cycles, not core cycles); "none" elsewhere.
+#pragma once
+
+#include <stdint.h>
+
+#define BENCH_MIX_FRAMES 1024      // Frames per mix, replayed once per pass
+#define BENCH_LINE_MAX 256
+
+// Receives each result line (no trailing newline)
+typedef void (*BenchPrintFn)(const char* line);
+
+// Run every case, passes times over its mix. Returns false if the
+// working tables could not be allocated.
+bool runPipelineBenchmarks(const char* platform, uint32_t passes, BenchPrintFn print);
@@ -0,0 +1,81 @@
+// Link G4X Monitor - Sequence-locked snapshot
+//
+// One writer publishes whole copies of a trivially copyable struct; any
+// number of readers take consistent copies without locks and without
+// ever blocking the writer. The sequence is odd while a publish is in
+// progress, and a reader retries if it saw an odd sequence or the
+// sequence moved during its copy.
+//
+// The payload is held as relaxed 32-bit atomics rather than raw bytes,
+// so the overlapping copy is well defined and costs plain loads/stores
+// on a 32-bit core.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+#define SEQLOCK_READ_ATTEMPTS 4
+
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+  static_assert(sizeof(T) % sizeof(uint32_t) == 0, "SeqLock payload must be a whole number of words");
+
+public:
+  // Writer side - a single task only
+  void publish(const T& value) {
+    uint32_t words[WORDS];
+    memcpy(words, &value, sizeof(T));
+
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t i = 0; i < WORDS; i++) {
+      data_[i].store(words[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // Reader side - one attempt; false if a publish overlapped it
+  bool tryRead(T& out) const {
+    uint32_t words[WORDS];
+    uint32_t before = seq_.load(std::memory_order_acquire);
+    if (before & 1) return false;
+
+    for (uint32_t i = 0; i < WORDS; i++) {
+      words[i] = data_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) != before) return false;
+
+    memcpy(&out, words, sizeof(T));
+    return true;
+  }
+
+  // A few attempts, then give up and leave out untouched. Never spins
+  // indefinitely: a reader that preempted the writer mid-publish on the
+  // same core would otherwise wait forever. Callers keep their previous
+  // copy, which is itself consistent, and try again next frame.
+  bool read(T& out) const {
+    for (int attempt = 0; attempt < SEQLOCK_READ_ATTEMPTS; attempt++) {
+      if (tryRead(out)) return true;
+    }
+    missed_reads_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Number of publishes so far
+  uint32_t version() const { return seq_.load(std::memory_order_acquire) >> 1; }
+
+  // read() calls that gave up and kept the previous copy
+  uint32_t missedReads() const { return missed_reads_.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr uint32_t WORDS = sizeof(T) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> data_[WORDS] = {};
+  mutable std::atomic<uint32_t> missed_reads_{0};
+};
@@ -0,0 +1,208 @@
+// Link G4X Monitor - Columnar, indexed session log (LOG_SESSION)
+#include "session_log.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#endif
+
+const uint16_t SESSION_CHANNEL_INTERVALS_MS[SIG_COUNT] = {
+  0,       // RPM
+  0,       // TPS
+  0,       // APS
+  0,       // MGP
+  1000,    // ECT
+  1000,    // IAT
+  200,     // Battery
+  0,       // Lambda
+  0,       // Lambda target
+  0,       // Injector duty
+  1000,    // Ethanol
+  200,     // Oil pressure
+  200,     // Fuel pressure
+  1000,    // Oil temperature
+  1000,    // Fuel temperature
+  0,       // Ignition timing
+  0,       // Injector duty 2
+  0,       // Lambda 2
+  0,       // Vehicle speed
+  1000,    // ECU temperature
+  200,     // Boost map
+  200,     // E-throttle map
+  200,     // Launch active
+  200,     // Anti-lag active
+};
+
+// ========== ENCODER ==========
+static uint8_t* allocateSessionBuffer(size_t bytes) {
+#ifdef ARDUINO
+  uint8_t* buffer = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (buffer) return buffer;
+#endif
+  return (uint8_t*)malloc(bytes);
+}
+
+bool SessionLogEncoder::allocate(uint32_t index_entries) {
+  if (allocated() && index_capacity_ == index_entries) return true;
+  release();
+
+  columns_ = allocateSessionBuffer(SIG_COUNT * SESSION_COLUMN_BYTES);
+  index_ = allocateSessionBuffer(SESSION_INDEX_HEADER_BYTES + index_entries * sizeof(SessionIndexEntry) +
+                                 sizeof(SessionFooter));
+  if (!columns_ || !index_) {
+    release();
+    return false;
+  }
+  index_capacity_ = index_entries;
+  return true;
+}
+
+void SessionLogEncoder::release() {
+  free(columns_);
+  free(index_);
+  columns_ = nullptr;
+  index_ = nullptr;
+  index_capacity_ = 0;
+}
+
+void SessionLogEncoder::begin(uint32_t now_ms) {
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    state_[s] = {};
+    state_[s].last_ms = now_ms;
+    state_[s].next_due_ms = now_ms;
+  }
+  chunk_start_ms_ = now_ms;
+  chunk_full_ = false;
+  entry_count_ = 0;
+  stats_ = {};
+}
+
+void SessionLogEncoder::sample(const ECUData& data, uint32_t now_ms) {
+  stats_.samples++;
+
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    if (!data.valid((SignalId)s)) continue;
+
+    Column& column = state_[s];
+    uint32_t time_ms;
+    if (SESSION_CHANNEL_INTERVALS_MS[s] == 0) {
+      if (data.signal_updated_ms[s] == column.last_update_ms) continue;
+      column.last_update_ms = data.signal_updated_ms[s];
+      time_ms = column.last_update_ms;
+    } else {
+      if ((int32_t)(now_ms - column.next_due_ms) < 0) continue;
+      column.next_due_ms = now_ms + SESSION_CHANNEL_INTERVALS_MS[s];
+      time_ms = now_ms;
+    }
+
+    if (column.length + SESSION_SAMPLE_MAX > SESSION_COLUMN_BYTES) {
+      stats_.dropped++;
+      continue;
+    }
+    // An update decoded before the chunk started goes in at its start
+    if ((int32_t)(time_ms - column.last_ms) < 0) time_ms = column.last_ms;
+
+    int32_t count = (int32_t)lroundf(signalValue(data, (SignalId)s) * SIGNAL_LOG_STEPS[s].counts_per_unit);
+    uint8_t* bytes = columns_ + s * SESSION_COLUMN_BYTES;
+    uint8_t* end = putVarint(bytes + column.length, time_ms - column.last_ms);
+    end = putVarint(end, zigzag(count - column.last_count));
+    column.length = end - bytes;
+    column.last_ms = time_ms;
+    column.last_count = count;
+    stats_.values++;
+    if (column.length + SESSION_SAMPLE_MAX > SESSION_COLUMN_BYTES) chunk_full_ = true;
+  }
+}
+
+size_t SessionLogEncoder::chunkBytes() const {
+  uint8_t scratch[VARINT_MAX_BYTES];
+  size_t length = 0;
+  uint32_t mask = 0;
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    if (!state_[s].length) continue;
+    mask |= 1UL << s;
+    length += (putVarint(scratch, state_[s].length) - scratch) + state_[s].length;
+  }
+  if (!mask) return 0;
+  return length + 1 + (putVarint(scratch, chunk_start_ms_) - scratch) + (putVarint(scratch, mask) - scratch);
+}
+
+void SessionLogEncoder::closeChunk(uint8_t* out, uint32_t sequence, uint32_t offset, uint32_t now_ms) {
+  uint32_t mask = 0;
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    if (state_[s].length) mask |= 1UL << s;
+  }
+
+  if (mask) {
+    uint8_t* end = out;
+    *end++ = SESSION_CHUNK_TAG;
+    end = putVarint(end, chunk_start_ms_);
+    end = putVarint(end, mask);
+    for (uint8_t s = 0; s < SIG_COUNT; s++) {
+      if (state_[s].length) end = putVarint(end, state_[s].length);
+    }
+    for (uint8_t s = 0; s < SIG_COUNT; s++) {
+      memcpy(end, columns_ + s * SESSION_COLUMN_BYTES, state_[s].length);
+      end += state_[s].length;
+    }
+
+    if (entry_count_ < index_capacity_) {
+      SessionIndexEntry entry = {chunk_start_ms_, sequence, offset};
+      memcpy(index_ + SESSION_INDEX_HEADER_BYTES + entry_count_ * sizeof(entry), &entry, sizeof(entry));
+      entry_count_++;
+    } else {
+      stats_.unindexed++;
+    }
+    stats_.chunks++;
+    stats_.bytes += end - out;
+  }
+
+  // Every column starts over against zero
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    state_[s].length = 0;
+    state_[s].last_count = 0;
+    state_[s].last_ms = now_ms;
+  }
+  chunk_start_ms_ = now_ms;
+  chunk_full_ = false;
+}
+
+const uint8_t* SessionLogEncoder::finishIndex(uint32_t index_sequence, uint32_t first_file_index,
+                                              uint32_t blocks_per_file, size_t& length) {
+  uint8_t* header = index_;
+  *header++ = SESSION_INDEX_TAG;
+  *header++ = SIG_COUNT;
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    memcpy(header, &SIGNAL_LOG_STEPS[s].counts_per_unit, sizeof(float));
+    memcpy(header + sizeof(float), &SESSION_CHANNEL_INTERVALS_MS[s], sizeof(uint16_t));
+    header += SESSION_CHANNEL_INFO_BYTES;
+  }
+
+  length = SESSION_INDEX_HEADER_BYTES + entry_count_ * sizeof(SessionIndexEntry) + sizeof(SessionFooter);
+  SessionFooter footer = {index_sequence, (uint32_t)length, entry_count_, first_file_index, blocks_per_file,
+                          SESSION_FOOTER_MAGIC};
+  memcpy(index_ + length - sizeof(footer), &footer, sizeof(footer));
+  return index_;
+}
+
+// ========== READING ==========
+bool readSessionFooter(const uint8_t* payload, size_t length, SessionFooter& footer) {
+  if (length < sizeof(footer)) return false;
+  memcpy(&footer, payload + length - sizeof(footer), sizeof(footer));
+  return footer.magic == SESSION_FOOTER_MAGIC && footer.blocks_per_file != 0;
+}
+
+uint32_t findSessionChunk(const uint8_t* index, uint32_t entry_count, uint32_t time_ms) {
+  uint32_t low = 0, high = entry_count;
+  while (high - low > 1) {
+    uint32_t middle = (low + high) / 2;
+    if ((int32_t)(sessionIndexEntry(index, middle).start_ms - time_ms) <= 0) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
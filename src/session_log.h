@@ -0,0 +1,192 @@
+// Link G4X Monitor - Columnar, indexed session log (LOG_SESSION)
+//
+// A manually started session logs decoded signals column by column. Each
+// signal is sampled at its own rate (SESSION_CHANNEL_INTERVALS_MS: engine
+// signals on every decoded update, pressures and maps at 5 Hz,
+// temperatures at 1 Hz) in the steps of SIGNAL_LOG_STEPS, and appended to
+// its own column as a varint millisecond gap and a zigzag varint delta
+// against the column's previous sample. Columns are cut into chunks of
+// SESSION_CHUNK_MS, or less when one fills:
+//   byte    SESSION_CHUNK_TAG
+//   varint  chunk start, ms
+//   varint  mask of the columns present, one bit per SignalId
+//   varint  byte length of each column present
+//   the columns, in SignalId order, each a run of samples
+//     varint  ms since the previous sample (the first: since the start)
+//     varint  zigzag(count - previous count) (the first: against zero)
+// A viewer after one channel skips the other columns by their lengths,
+// and every chunk decodes on its own.
+//
+// Chunks are packed into the log writer's sealed blocks (content
+// CAN_LOG_CONTENT_SESSION), never across two. When the session stops,
+// the index follows from a block of its own: SESSION_INDEX_TAG, the
+// channel table, one SessionIndexEntry per chunk (start time, block
+// sequence, offset in the block) and a SessionFooter that ends the last
+// block. A viewer reads the last block of the last file, the index blocks
+// the footer points to, and goes straight to the chunk holding any
+// second, checking each block's header for the sequence it expects. The
+// writer keeps every file of a running session, and the index is only
+// written when every chunk block went out where it was numbered. A
+// session that hit a write error or was cut short by power loss has no
+// index, but the chunks in its intact blocks still read in order.
+//
+// Per sample the encoder looks at each signal once and appends at most
+// SESSION_SAMPLE_MAX bytes to a column; closing a chunk is one copy of
+// its columns.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "can_log_format.h"
+#include "ecu_data.h"
+#include "signal_changes.h"
+
+#define SESSION_CHUNK_MS 1000
+#define SESSION_COLUMN_BYTES 512        // Per column and chunk
+#define SESSION_SAMPLE_MAX (2 * VARINT_MAX_BYTES)
+#define SESSION_CHUNK_MAX (1 + 2 * VARINT_MAX_BYTES + SIG_COUNT * (2 + SESSION_COLUMN_BYTES))
+#define SESSION_INDEX_ENTRIES 14400     // Four hours of full chunks
+#define SESSION_CHUNK_TAG 0x43          // 'C'
+#define SESSION_INDEX_TAG 0x49          // 'I'
+#define SESSION_FOOTER_MAGIC 0x53583447u   // "G4XS"
+
+static_assert(SESSION_CHUNK_MAX <= CAN_LOG_BLOCK_PAYLOAD, "A chunk must fit in one block");
+
+// Sampling interval per signal; 0 = on every decoded update (at most once
+// per sample call)
+extern const uint16_t SESSION_CHANNEL_INTERVALS_MS[SIG_COUNT];
+
+// Index section layout: tag, channel count, then per channel
+// float counts_per_unit and uint16_t interval_ms (packed)
+#define SESSION_CHANNEL_INFO_BYTES 6
+#define SESSION_INDEX_HEADER_BYTES (2 + SIG_COUNT * SESSION_CHANNEL_INFO_BYTES)
+
+struct SessionIndexEntry {
+  uint32_t start_ms;
+  uint32_t sequence;    // Block the chunk is in
+  uint32_t offset;      // Payload offset of the chunk in that block
+};
+
+// The last bytes of a finished session's last block
+struct SessionFooter {
+  uint32_t index_sequence;     // First block of the index section
+  uint32_t index_bytes;        // Whole section, footer included
+  uint32_t entry_count;
+  uint32_t first_file_index;   // Sequence s is in file first + s / blocks_per_file
+  uint32_t blocks_per_file;
+  uint32_t magic;              // SESSION_FOOTER_MAGIC
+};
+
+struct SessionLogStats {
+  uint32_t samples;     // sample() calls
+  uint32_t values;      // Column samples
+  uint32_t chunks;
+  uint32_t bytes;       // Chunk bytes
+  uint32_t dropped;     // Samples a full column could not take
+  uint32_t unindexed;   // Chunks past SESSION_INDEX_ENTRIES
+};
+
+// ========== ENCODER ==========
+class SessionLogEncoder {
+public:
+  ~SessionLogEncoder() { release(); }
+
+  // Column buffers and room for index_entries chunks; PSRAM on the Tab5
+  bool allocate(uint32_t index_entries);
+  void release();
+  bool allocated() const { return columns_ != nullptr; }
+
+  void begin(uint32_t now_ms);
+
+  // The chunk's time is up or a column is nearly full: close it before
+  // the next sample, so a chunk holds samples from its start up to the
+  // next one's
+  bool chunkDue(uint32_t now_ms) const { return chunk_full_ || now_ms - chunk_start_ms_ >= SESSION_CHUNK_MS; }
+  // Append the signals that are due
+  void sample(const ECUData& data, uint32_t now_ms);
+
+  // Length of the chunk as it stands, 0 if it holds nothing
+  size_t chunkBytes() const;
+  // Write the chunk to out (chunkBytes(), unless 0) at payload offset
+  // of block sequence, index it, and start the next at now_ms
+  void closeChunk(uint8_t* out, uint32_t sequence, uint32_t offset, uint32_t now_ms);
+
+  // After the last chunk: the index section, to be written from the start
+  // of block index_sequence
+  const uint8_t* finishIndex(uint32_t index_sequence, uint32_t first_file_index, uint32_t blocks_per_file,
+                             size_t& length);
+
+  const SessionLogStats& stats() const { return stats_; }
+
+private:
+  struct Column {
+    uint16_t length;
+    int32_t last_count;
+    uint32_t last_ms;
+    uint32_t last_update_ms;   // signal_updated_ms last sampled
+    uint32_t next_due_ms;      // Decimated signals
+  };
+
+  uint8_t* columns_ = nullptr;   // [SIG_COUNT][SESSION_COLUMN_BYTES]
+  uint8_t* index_ = nullptr;     // The index section, entries added as chunks close
+  uint32_t index_capacity_ = 0;
+  uint32_t entry_count_ = 0;
+  Column state_[SIG_COUNT] = {};
+  uint32_t chunk_start_ms_ = 0;
+  bool chunk_full_ = false;
+  SessionLogStats stats_ = {};
+};
+
+// ========== READING ==========
+inline SessionIndexEntry sessionIndexEntry(const uint8_t* index, uint32_t i) {
+  SessionIndexEntry entry;
+  memcpy(&entry, index + SESSION_INDEX_HEADER_BYTES + i * sizeof(entry), sizeof(entry));
+  return entry;
+}
+
+// Footer at the end of a block's payload, if it is there
+bool readSessionFooter(const uint8_t* payload, size_t length, SessionFooter& footer);
+
+// Entry of the chunk holding time_ms: the last one starting at or before
+// it (the first if none does)
+uint32_t findSessionChunk(const uint8_t* index, uint32_t entry_count, uint32_t time_ms);
+
+// Decode the chunk at data, calling fn(signal, time_ms, value) for each
+// sample of the columns in columns (a SignalId mask), column by column.
+// Returns the chunk's length, 0 if it is malformed or not a chunk.
+template <typename Fn>
+size_t decodeSessionChunk(const uint8_t* data, size_t length, uint32_t columns, Fn&& fn) {
+  const uint8_t* in = data;
+  const uint8_t* end = data + length;
+  uint32_t start_ms, mask;
+  if (in == end || *in++ != SESSION_CHUNK_TAG) return 0;
+  if (!getVarint(in, end, start_ms) || !getVarint(in, end, mask) || (mask >> SIG_COUNT)) return 0;
+
+  uint32_t lengths[SIG_COUNT];
+  size_t total = 0;
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    lengths[s] = 0;
+    if ((mask & (1UL << s)) && !getVarint(in, end, lengths[s])) return 0;
+    total += lengths[s];
+  }
+  if (total > (size_t)(end - in)) return 0;
+
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    const uint8_t* column = in;
+    const uint8_t* column_end = in + lengths[s];
+    in = column_end;
+    if (!(columns & (1UL << s))) continue;
+
+    uint32_t time_ms = start_ms;
+    int32_t count = 0;
+    while (column < column_end) {
+      uint32_t gap, delta;
+      if (!getVarint(column, column_end, gap) || !getVarint(column, column_end, delta)) return 0;
+      time_ms += gap;
+      count += unzigzag(delta);
+      fn((SignalId)s, time_ms, count / SIGNAL_LOG_STEPS[s].counts_per_unit);
+    }
+  }
+  return in - data;
+}
@@ -0,0 +1,73 @@
+// Link G4X Monitor - Deadband change encoding of decoded signals
+#include "signal_changes.h"
+
+#include <math.h>
+
+// Steps at or below what the gauges show; deadbands at what matters on a
+// log review
+const SignalLogStep SIGNAL_LOG_STEPS[SIG_COUNT] = {
+  {1.0f, 10},       // RPM: 1 rpm, ±10
+  {10.0f, 5},       // TPS: 0.1%, ±0.5
+  {10.0f, 5},       // APS: 0.1%, ±0.5
+  {10.0f, 5},       // MGP: 0.1 kPa, ±0.5
+  {10.0f, 5},       // ECT: 0.1°C, ±0.5
+  {10.0f, 5},       // IAT: 0.1°C, ±0.5
+  {100.0f, 5},      // Battery: 0.01 V, ±0.05
+  {1000.0f, 5},     // Lambda: 0.001, ±0.005
+  {1000.0f, 5},     // Lambda target: 0.001, ±0.005
+  {10.0f, 5},       // Injector duty: 0.1%, ±0.5
+  {10.0f, 5},       // Ethanol: 0.1%, ±0.5
+  {10.0f, 20},      // Oil pressure: 0.1 kPa, ±2
+  {10.0f, 20},      // Fuel pressure: 0.1 kPa, ±2
+  {10.0f, 5},       // Oil temperature: 0.1°C, ±0.5
+  {10.0f, 5},       // Fuel temperature: 0.1°C, ±0.5
+  {10.0f, 5},       // Ignition timing: 0.1°, ±0.5
+  {10.0f, 5},       // Injector duty 2: 0.1%, ±0.5
+  {1000.0f, 5},     // Lambda 2: 0.001, ±0.005
+  {10.0f, 5},       // Vehicle speed: 0.1 km/h, ±0.5
+  {10.0f, 5},       // ECU temperature: 0.1°C, ±0.5
+  {1.0f, 0},        // Boost map: every change
+  {1.0f, 0},        // E-throttle map: every change
+  {1.0f, 0},        // Launch active
+  {1.0f, 0},        // Anti-lag active
+};
+
+void SignalChangeEncoder::restart() {
+  for (uint8_t s = 0; s < SIG_COUNT; s++) logged_[s] = 0;
+  logged_mask_ = 0;
+  last_ms_ = 0;
+}
+
+size_t SignalChangeEncoder::encode(const ECUData& data, uint32_t now_ms, uint8_t* out) {
+  stats_.samples++;
+
+  uint32_t mask = 0;
+  uint32_t deltas[SIG_COUNT];
+  uint8_t count = 0;
+  for (uint8_t s = 0; s < SIG_COUNT; s++) {
+    if (!data.valid((SignalId)s)) continue;
+
+    const SignalLogStep& step = SIGNAL_LOG_STEPS[s];
+    int32_t value = (int32_t)lroundf(signalValue(data, (SignalId)s) * step.counts_per_unit);
+    int32_t delta = value - logged_[s];
+    bool first = !(logged_mask_ & (1UL << s));
+    if (!first && delta <= step.deadband && delta >= -step.deadband) continue;
+
+    logged_[s] = value;
+    mask |= 1UL << s;
+    deltas[count++] = zigzag(delta);
+  }
+  if (!mask) return 0;
+
+  uint8_t* end = putVarint(out, now_ms - last_ms_);
+  end = putVarint(end, mask);
+  for (uint8_t i = 0; i < count; i++) end = putVarint(end, deltas[i]);
+  logged_mask_ |= mask;
+  last_ms_ = now_ms;
+
+  size_t length = end - out;
+  stats_.groups++;
+  stats_.changes += count;
+  stats_.bytes += length;
+  return length;
+}
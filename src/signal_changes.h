@@ -0,0 +1,130 @@
+// Link G4X Monitor - Deadband change encoding of decoded signals
+//
+// LOG_CHANGES logs decoded ECUData signals instead of raw frames, and
+// only when a signal has moved past its deadband since it was last
+// logged (±10 rpm, ±0.005 lambda), so a steady cruise logs next to
+// nothing. Each signal is held as a whole number of its log step (1 rpm,
+// 0.001 lambda); a logged change is the difference from the previous
+// logged count, zigzag varint encoded, so small moves take one byte.
+//
+// A sample that logs anything becomes one group:
+//   varint  milliseconds since the previous group
+//   varint  mask of the signals that follow, one bit per SignalId
+//   varint  zigzag(count - previous count) for each signal in the mask
+// After restart() every count and the time are taken against zero, so
+// the first group is a keyframe holding each valid signal absolutely.
+// The log writer restarts the encoder at every block, so each block
+// decodes on its own. Signals that are not valid (never decoded, or
+// stale) are left out. The work per sample is one pass over SIG_COUNT
+// signals and a group never exceeds SIGNAL_CHANGE_GROUP_MAX bytes.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ecu_data.h"
+
+#define VARINT_MAX_BYTES 5   // uint32_t
+#define SIGNAL_CHANGE_GROUP_MAX ((2 + SIG_COUNT) * VARINT_MAX_BYTES)
+
+// Log resolution and deadband of one signal
+struct SignalLogStep {
+  float counts_per_unit;   // 1 / log step
+  uint16_t deadband;       // In counts: logged when |change| > deadband
+};
+
+extern const SignalLogStep SIGNAL_LOG_STEPS[SIG_COUNT];
+
+// ========== VARINTS ==========
+inline uint8_t* putVarint(uint8_t* out, uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (uint8_t)value;
+  return out;
+}
+
+// false if the varint runs past end or is longer than a uint32_t
+inline bool getVarint(const uint8_t*& in, const uint8_t* end, uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 7 * VARINT_MAX_BYTES && in < end; shift += 7) {
+    uint8_t byte = *in++;
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+inline uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// ========== ENCODER ==========
+struct SignalChangeStats {
+  uint32_t samples;    // encode() calls
+  uint32_t groups;     // Samples that logged something
+  uint32_t changes;    // Signal values logged
+  uint32_t bytes;
+};
+
+class SignalChangeEncoder {
+public:
+  SignalChangeEncoder() { restart(); }
+
+  // Forget the logged values: the next group is a keyframe
+  void restart();
+
+  // Encode what moved in data into out (SIGNAL_CHANGE_GROUP_MAX bytes).
+  // Returns the group's length, 0 if nothing moved past its deadband.
+  size_t encode(const ECUData& data, uint32_t now_ms, uint8_t* out);
+
+  const SignalChangeStats& stats() const { return stats_; }
+  void resetStats() { stats_ = {}; }
+
+private:
+  int32_t logged_[SIG_COUNT];
+  uint32_t logged_mask_;      // Signals logged since restart()
+  uint32_t last_ms_;
+  SignalChangeStats stats_ = {};
+};
+
+// ========== DECODER ==========
+class SignalChangeDecoder {
+public:
+  SignalChangeDecoder() { restart(); }
+
+  // Before each block
+  void restart() {
+    for (uint8_t s = 0; s < SIG_COUNT; s++) counts_[s] = 0;
+    time_ms_ = 0;
+  }
+
+  // Decode the groups in one block's payload, calling
+  // fn(time_ms, signal, value) for every logged value. Returns false on a
+  // malformed group.
+  template <typename Fn>
+  bool decode(const uint8_t* data, size_t length, Fn&& fn) {
+    const uint8_t* end = data + length;
+    while (data < end) {
+      uint32_t elapsed_ms, mask;
+      if (!getVarint(data, end, elapsed_ms) || !getVarint(data, end, mask) || (mask >> SIG_COUNT)) return false;
+      time_ms_ += elapsed_ms;
+      for (uint8_t s = 0; s < SIG_COUNT; s++) {
+        if (!(mask & (1UL << s))) continue;
+        uint32_t delta;
+        if (!getVarint(data, end, delta)) return false;
+        counts_[s] += unzigzag(delta);
+        fn(time_ms_, (SignalId)s, counts_[s] / SIGNAL_LOG_STEPS[s].counts_per_unit);
+      }
+    }
+    return true;
+  }
+
+private:
+  int32_t counts_[SIG_COUNT];
+  uint32_t time_ms_;
+};
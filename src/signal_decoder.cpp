@@ -0,0 +1,87 @@
+// Link G4X Monitor - Table-driven CAN signal decoder
+#include "signal_decoder.h"
+
+#include <string.h>
+
+void SignalDecoder::clear() {
+  memset(slot_for_id_, NO_FRAME, sizeof(slot_for_id_));
+  memset(mux_slot_, NO_FRAME, sizeof(mux_slot_));
+  mux_count_ = 0;
+  frame_count_ = 0;
+  signal_count_ = 0;
+  signal_mask_ = 0;
+  memset(timing_, 0, sizeof(timing_));
+  memset(frame_for_signal_, NO_FRAME, sizeof(frame_for_signal_));
+}
+
+bool SignalDecoder::configure(const FrameLayout* frames, uint8_t count, uint16_t id_base) {
+  clear();
+  if (count > DECODER_MAX_FRAMES) return false;
+
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t can_id = (uint32_t)frames[i].can_id + id_base;
+    if (can_id >= CAN_STD_ID_COUNT || !assignSlot(can_id, frames[i].mux, i)) {
+      clear();
+      return false;
+    }
+    frames_[i] = frames[i];
+    frames_[i].can_id = can_id;
+    signal_count_ += frames[i].signal_count;
+    signal_mask_ |= frames[i].signal_mask;
+    for (uint32_t m = frames[i].signal_mask; m; m &= m - 1) {
+      frame_for_signal_[__builtin_ctz(m)] = i;
+    }
+  }
+
+  frame_count_ = count;
+  return true;
+}
+
+bool SignalDecoder::assignSlot(uint16_t can_id, uint16_t mux, uint8_t slot) {
+  uint8_t& entry = slot_for_id_[can_id];
+  if (mux == SIG_NOT_MULTIPLEXED) {
+    if (entry != NO_FRAME) return false;
+    entry = slot;
+    return true;
+  }
+
+  // First page of this ID claims a page table
+  if (entry == NO_FRAME) {
+    if (mux_count_ == DECODER_MAX_MUX_IDS) return false;
+    entry = MUX_TABLE | mux_count_++;
+  } else if (!(entry & MUX_TABLE)) {
+    return false;
+  }
+
+  uint8_t& page = mux_slot_[entry & ~MUX_TABLE][mux];
+  if (page != NO_FRAME) return false;
+  page = slot;
+  return true;
+}
+
+bool SignalDecoder::acceptanceFilter(uint16_t& code, uint16_t& dont_care) const {
+  if (frame_count_ == 0) return false;
+
+  uint16_t all_ones = 0x7FF;   // Bits set in every ID
+  uint16_t any_ones = 0;       // Bits set in at least one ID
+  for (uint8_t i = 0; i < frame_count_; i++) {
+    all_ones &= frames_[i].can_id;
+    any_ones |= frames_[i].can_id;
+  }
+
+  code = all_ones;
+  dont_care = all_ones ^ any_ones;
+  return true;
+}
+
+void SignalDecoder::refreshValidity(ECUData& out, uint32_t now_ms) const {
+  out.signal_valid &= signal_mask_;
+
+  for (uint32_t m = out.signal_valid; m; m &= m - 1) {
+    uint8_t signal = __builtin_ctz(m);
+    uint8_t slot = frame_for_signal_[signal];
+    if (now_ms - out.signal_updated_ms[signal] > frameTimeout(slot)) {
+      out.signal_valid &= ~(1UL << signal);
+    }
+  }
+}
@@ -0,0 +1,481 @@
+// Link G4X Monitor - Table-driven CAN signal decoder
+//
+// Each stream layout is a constexpr table of SignalDescriptor entries,
+// grouped by CAN ID. compileSignalTable() turns a table into one
+// FrameLayout per ID at compile time; every layout carries a decode
+// function the compiler has specialised for exactly that frame's signals
+// (byte order, width, sign, scale and destination are all constants).
+// SignalDecoder::configure() then drops those layouts into a flat per-ID
+// dispatch array, so decoding a frame is one array lookup and one call.
+//
+// A multiplexed frame carries a page index in byte 0 and a different set
+// of signals on each page, so one ID can carry far more channels than 8
+// bytes hold. Its descriptors name the page in their mux field and are
+// grouped by (ID, page); each page compiles to a layout of its own, and
+// the dispatch array points the ID at a 256-entry page table instead of a
+// layout, so a multiplexed frame costs one extra lookup.
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <utility>
+#include "can_ring.h"
+#include "ecu_data.h"
+
+// ========== CUSTOM STREAM IDS ==========
+const uint32_t CUSTOM_STREAM_ID_1 = 0x500;  // Primary Engine Data
+const uint32_t CUSTOM_STREAM_ID_2 = 0x501;  // Lambda & Fuel Data
+const uint32_t CUSTOM_STREAM_ID_3 = 0x502;  // Pressures & Status
+
+// ========== SIGNAL DESCRIPTORS ==========
+enum SignalFlags : uint8_t {
+  SIG_LITTLE_ENDIAN = 0x00,   // Intel byte order (Link custom streams)
+  SIG_BIG_ENDIAN = 0x01,      // Motorola byte order
+  SIG_SIGNED = 0x02           // Two's complement, sign-extended from length
+};
+
+const uint16_t SIG_NOT_MULTIPLEXED = 0x100;  // SignalDescriptor::mux for plain frames
+
+struct SignalDescriptor {
+  uint16_t can_id;      // 11-bit CAN ID
+  uint8_t start_byte;   // First byte of the field
+  uint8_t length;       // Field length in bytes (1-4)
+  uint8_t flags;        // SignalFlags
+  uint8_t bit_mask;     // Non-zero: single flag, value = (raw & mask) != 0
+  float scale;          // Physical = raw * scale + offset
+  float offset;
+  SignalId dest;        // ECUData field written
+  uint16_t mux = SIG_NOT_MULTIPLEXED;  // Page index (byte 0) for multiplexed frames
+};
+
+// Frame layouts from docs/CAN_Frame_Reference.md, as decoded by the dashboard
+inline constexpr SignalDescriptor CUSTOM_STREAM_SIGNALS[] = {
+  // Frame 0x500 - Primary Engine Data
+  {CUSTOM_STREAM_ID_1, 0, 2, SIG_LITTLE_ENDIAN, 0, 0.1f,   0.0f,   SIG_RPM},
+  {CUSTOM_STREAM_ID_1, 2, 1, SIG_LITTLE_ENDIAN, 0, 0.5f,   0.0f,   SIG_TPS},
+  {CUSTOM_STREAM_ID_1, 3, 1, SIG_LITTLE_ENDIAN, 0, 0.5f,   0.0f,   SIG_APS},
+  {CUSTOM_STREAM_ID_1, 4, 2, SIG_LITTLE_ENDIAN, 0, 0.1f,   0.0f,   SIG_MGP},
+  {CUSTOM_STREAM_ID_1, 6, 1, SIG_LITTLE_ENDIAN, 0, 1.0f,   -40.0f, SIG_ECT},
+  {CUSTOM_STREAM_ID_1, 7, 1, SIG_LITTLE_ENDIAN, 0, 1.0f,   -40.0f, SIG_IAT},
+
+  // Frame 0x501 - Lambda & Fuel Data
+  {CUSTOM_STREAM_ID_2, 0, 2, SIG_LITTLE_ENDIAN, 0, 0.001f, 0.0f,   SIG_LAMBDA},
+  {CUSTOM_STREAM_ID_2, 2, 2, SIG_LITTLE_ENDIAN, 0, 0.001f, 0.0f,   SIG_LAMBDA_TARGET},
+  {CUSTOM_STREAM_ID_2, 4, 1, SIG_LITTLE_ENDIAN, 0, 0.5f,   0.0f,   SIG_INJECTOR_DUTY},
+  {CUSTOM_STREAM_ID_2, 5, 1, SIG_LITTLE_ENDIAN, 0, 1.0f,   0.0f,   SIG_ETHANOL},
+  {CUSTOM_STREAM_ID_2, 6, 2, SIG_LITTLE_ENDIAN, 0, 0.01f,  0.0f,   SIG_BATTERY},
+
+  // Frame 0x502 - Pressures & Status
+  {CUSTOM_STREAM_ID_3, 0, 2, SIG_LITTLE_ENDIAN, 0, 0.1f,   0.0f,   SIG_OIL_PRESS},
+  {CUSTOM_STREAM_ID_3, 2, 2, SIG_LITTLE_ENDIAN, 0, 0.1f,   0.0f,   SIG_FUEL_PRESS},
+  {CUSTOM_STREAM_ID_3, 4, 1, SIG_LITTLE_ENDIAN, 0, 1.0f,   0.0f,   SIG_BOOST_MAP},
+  {CUSTOM_STREAM_ID_3, 5, 1, SIG_LITTLE_ENDIAN, 0, 1.0f,   0.0f,   SIG_ETHROTTLE_MAP},
+  {CUSTOM_STREAM_ID_3, 6, 1, SIG_LITTLE_ENDIAN, 0x01, 1.0f, 0.0f,  SIG_LAUNCH_ACTIVE},
+  {CUSTOM_STREAM_ID_3, 6, 1, SIG_LITTLE_ENDIAN, 0x02, 1.0f, 0.0f,  SIG_ANTI_LAG_ACTIVE},
+};
+
+inline constexpr uint16_t CUSTOM_STREAM_SIGNAL_COUNT = sizeof(CUSTOM_STREAM_SIGNALS) / sizeof(CUSTOM_STREAM_SIGNALS[0]);
+
+// ========== HALTECH IC7 ==========
+// Frame layouts from docs/Haltech_IC7_Protocol.md. IDs are offsets from
+// config.base_can_id (864 / 0x360 by default); all fields are big-endian.
+const uint16_t HALTECH_IC7_ENGINE = 0x00;       // 0x360 - RPM, MAP, TPS (50Hz)
+const uint16_t HALTECH_IC7_PRESSURES = 0x01;    // 0x361 - Fuel/oil pressure (50Hz)
+const uint16_t HALTECH_IC7_INJECTION = 0x02;    // 0x362 - Injector duty, timing (50Hz)
+const uint16_t HALTECH_IC7_LAMBDA = 0x08;       // 0x368 - Lambda 1/2 (20Hz)
+const uint16_t HALTECH_IC7_TEMPERATURES = 0x80; // 0x3E0 - ECT/IAT/fuel/oil temp (5Hz)
+
+const float KELVIN_TO_CELSIUS = -273.15f;
+const float ATMOSPHERIC_KPA = 101.3f;  // MAP -> gauge pressure for the boost gauge
+
+inline constexpr SignalDescriptor HALTECH_IC7_SIGNALS[] = {
+  // Primary Engine Data
+  {HALTECH_IC7_ENGINE, 0, 2, SIG_BIG_ENDIAN, 0, 1.0f, 0.0f, SIG_RPM},
+  {HALTECH_IC7_ENGINE, 2, 2, SIG_BIG_ENDIAN, 0, 0.1f, -ATMOSPHERIC_KPA, SIG_MGP},
+  {HALTECH_IC7_ENGINE, 4, 2, SIG_BIG_ENDIAN, 0, 0.1f, 0.0f, SIG_TPS},
+
+  // Pressure Data
+  {HALTECH_IC7_PRESSURES, 0, 2, SIG_BIG_ENDIAN, 0, 0.1f, 0.0f, SIG_FUEL_PRESS},
+  {HALTECH_IC7_PRESSURES, 2, 2, SIG_BIG_ENDIAN, 0, 0.1f, 0.0f, SIG_OIL_PRESS},
+
+  // Injection & Ignition
+  {HALTECH_IC7_INJECTION, 0, 2, SIG_BIG_ENDIAN, 0, 0.1f, 0.0f, SIG_INJECTOR_DUTY},
+  {HALTECH_IC7_INJECTION, 2, 2, SIG_BIG_ENDIAN, 0, 0.1f, 0.0f, SIG_INJECTOR_DUTY_2},
+  {HALTECH_IC7_INJECTION, 4, 2, SIG_BIG_ENDIAN | SIG_SIGNED, 0, 0.1f, 0.0f, SIG_IGNITION_TIMING},
+
+  // Lambda Data
+  {HALTECH_IC7_LAMBDA, 0, 2, SIG_BIG_ENDIAN, 0, 0.001f, 0.0f, SIG_LAMBDA},
+  {HALTECH_IC7_LAMBDA, 2, 2, SIG_BIG_ENDIAN, 0, 0.001f, 0.0f, SIG_LAMBDA_2},
+
+  // Temperature Data (0.1 K)
+  {HALTECH_IC7_TEMPERATURES, 0, 2, SIG_BIG_ENDIAN, 0, 0.1f, KELVIN_TO_CELSIUS, SIG_ECT},
+  {HALTECH_IC7_TEMPERATURES, 2, 2, SIG_BIG_ENDIAN, 0, 0.1f, KELVIN_TO_CELSIUS, SIG_IAT},
+  {HALTECH_IC7_TEMPERATURES, 4, 2, SIG_BIG_ENDIAN, 0, 0.1f, KELVIN_TO_CELSIUS, SIG_FUEL_TEMP},
+  {HALTECH_IC7_TEMPERATURES, 6, 2, SIG_BIG_ENDIAN, 0, 0.1f, KELVIN_TO_CELSIUS, SIG_OIL_TEMP},
+};
+
+inline constexpr uint16_t HALTECH_IC7_SIGNAL_COUNT = sizeof(HALTECH_IC7_SIGNALS) / sizeof(HALTECH_IC7_SIGNALS[0]);
+
+// ========== LINK GENERIC DASH 2 ==========
+// Frame layouts from docs/Link_G4X_Dash2Pro_Protocol.md: four
+// little-endian frames at fixed IDs 1000-1003, 20Hz each.
+const uint16_t GENERIC_DASH2_ID_1 = 1000;  // RPM, TPS, ECT, IAT, MGP, battery
+const uint16_t GENERIC_DASH2_ID_2 = 1001;  // Oil temp, ignition timing, speed
+const uint16_t GENERIC_DASH2_ID_3 = 1002;  // Oil/fuel pressure, lambda
+const uint16_t GENERIC_DASH2_ID_4 = 1003;  // ECU temperature
+
+inline constexpr SignalDescriptor GENERIC_DASH2_SIGNALS[] = {
+  // Frame 1000 - Core Engine Parameters
+  {GENERIC_DASH2_ID_1, 0, 2, SIG_LITTLE_ENDIAN, 0, 1.0f,   0.0f,   SIG_RPM},
+  {GENERIC_DASH2_ID_1, 2, 1, SIG_LITTLE_ENDIAN, 0, 0.5f,   0.0f,   SIG_TPS},
+  {GENERIC_DASH2_ID_1, 3, 1, SIG_LITTLE_ENDIAN, 0, 1.0f,   -40.0f, SIG_ECT},
+  {GENERIC_DASH2_ID_1, 4, 1, SIG_LITTLE_ENDIAN, 0, 1.0f,   -40.0f, SIG_IAT},
+  {GENERIC_DASH2_ID_1, 5, 2, SIG_LITTLE_ENDIAN, 0, 0.1f,   0.0f,   SIG_MGP},
+  {GENERIC_DASH2_ID_1, 7, 1, SIG_LITTLE_ENDIAN, 0, 0.1f,   0.0f,   SIG_BATTERY},
+
+  // Frame 1001 - Temperature, Timing & Speed
+  {GENERIC_DASH2_ID_2, 0, 2, SIG_LITTLE_ENDIAN | SIG_SIGNED, 0, 1.0f, -40.0f, SIG_OIL_TEMP},
+  {GENERIC_DASH2_ID_2, 2, 2, SIG_LITTLE_ENDIAN | SIG_SIGNED, 0, 0.1f, 0.0f,   SIG_IGNITION_TIMING},
+  {GENERIC_DASH2_ID_2, 4, 2, SIG_LITTLE_ENDIAN, 0, 0.1f,   0.0f,   SIG_VEHICLE_SPEED},
+
+  // Frame 1002 - Pressures & Lambda
+  {GENERIC_DASH2_ID_3, 0, 2, SIG_LITTLE_ENDIAN, 0, 1.0f,   0.0f,   SIG_OIL_PRESS},
+  {GENERIC_DASH2_ID_3, 2, 2, SIG_LITTLE_ENDIAN, 0, 1.0f,   0.0f,   SIG_FUEL_PRESS},
+  {GENERIC_DASH2_ID_3, 4, 2, SIG_LITTLE_ENDIAN, 0, 0.001f, 0.0f,   SIG_LAMBDA},
+
+  // Frame 1003 - System Monitoring
+  {GENERIC_DASH2_ID_4, 0, 2, SIG_LITTLE_ENDIAN | SIG_SIGNED, 0, 1.0f, -40.0f, SIG_ECU_TEMP},
+};
+
+inline constexpr uint16_t GENERIC_DASH2_SIGNAL_COUNT = sizeof(GENERIC_DASH2_SIGNALS) / sizeof(GENERIC_DASH2_SIGNALS[0]);
+
+// ========== FRAME PRIORITY ==========
+// Order in which a backlog of frames is decoded (see can_backlog.h). A
+// frame takes the class of its most urgent signal: engine speed and the
+// pressures first, temperatures and slow status last.
+enum FramePriority : uint8_t {
+  PRIORITY_CRITICAL,
+  PRIORITY_NORMAL,
+  PRIORITY_SLOW,
+  PRIORITY_CLASSES
+};
+
+const uint32_t CRITICAL_SIGNALS = (1UL << SIG_RPM) | (1UL << SIG_MGP) | (1UL << SIG_OIL_PRESS) |
+                                  (1UL << SIG_FUEL_PRESS);
+const uint32_t SLOW_SIGNALS = (1UL << SIG_ECT) | (1UL << SIG_IAT) | (1UL << SIG_OIL_TEMP) |
+                              (1UL << SIG_FUEL_TEMP) | (1UL << SIG_ECU_TEMP) | (1UL << SIG_BATTERY) |
+                              (1UL << SIG_ETHANOL);
+
+constexpr FramePriority framePriority(uint32_t signal_mask) {
+  if (signal_mask & CRITICAL_SIGNALS) return PRIORITY_CRITICAL;
+  if ((signal_mask & ~SLOW_SIGNALS) == 0) return PRIORITY_SLOW;
+  return PRIORITY_NORMAL;
+}
+
+// ========== TABLE COMPILATION ==========
+// Writes the frame's signals and stamps each one fresh at now_ms
+typedef void (*FrameDecodeFn)(const uint8_t* data, ECUData& out, uint32_t now_ms);
+
+// One CAN ID's worth of signals, produced by compileSignalTable()
+struct FrameLayout {
+  uint16_t can_id;
+  uint16_t mux;            // Page index, or SIG_NOT_MULTIPLEXED
+  uint8_t min_length;      // DLC needed to cover every signal
+  uint8_t signal_count;
+  FramePriority priority;
+  uint16_t first_signal;   // Index of the frame's first descriptor
+  uint32_t signal_mask;    // Bit per SignalId the frame writes
+  FrameDecodeFn decode;
+};
+
+static_assert(SIG_COUNT <= 32, "FrameLayout::signal_mask holds one bit per SignalId");
+
+// Descriptors of one layout: same ID and, for multiplexed frames, same page
+constexpr bool sameFrame(const SignalDescriptor& a, const SignalDescriptor& b) {
+  return a.can_id == b.can_id && a.mux == b.mux;
+}
+
+constexpr bool signalTableValid(const SignalDescriptor* table, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    const SignalDescriptor& s = table[i];
+    if (s.can_id > 0x7FF) return false;
+    if (s.length < 1 || s.length > 4) return false;
+    if (s.start_byte + s.length > 8) return false;
+    if (s.dest >= SIG_COUNT) return false;
+    // Byte 0 of a multiplexed frame is the page index
+    if (s.mux > SIG_NOT_MULTIPLEXED) return false;
+    if (s.mux != SIG_NOT_MULTIPLEXED && s.start_byte == 0) return false;
+    // Each frame's (or page's) signals must be contiguous
+    for (uint16_t j = 0; j + 1 < i; j++) {
+      if (sameFrame(table[j], s) && !sameFrame(table[j + 1], s)) return false;
+    }
+  }
+  return true;
+}
+
+constexpr uint16_t tableFrameCount(const SignalDescriptor* table, uint16_t count) {
+  uint16_t frames = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    if (i == 0 || !sameFrame(table[i], table[i - 1])) frames++;
+  }
+  return frames;
+}
+
+// Index of the first descriptor of frame n (count when n is past the end)
+constexpr uint16_t tableFrameStart(const SignalDescriptor* table, uint16_t count, uint16_t n) {
+  uint16_t frames = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    if (i == 0 || !sameFrame(table[i], table[i - 1])) {
+      if (frames == n) return i;
+      frames++;
+    }
+  }
+  return count;
+}
+
+constexpr uint8_t tableFrameMinLength(const SignalDescriptor* table, uint16_t first, uint16_t end) {
+  uint8_t length = 0;
+  for (uint16_t i = first; i < end; i++) {
+    uint8_t needed = table[i].start_byte + table[i].length;
+    if (needed > length) length = needed;
+  }
+  return length;
+}
+
+constexpr uint32_t tableFrameSignalMask(const SignalDescriptor* table, uint16_t first, uint16_t end) {
+  uint32_t mask = 0;
+  for (uint16_t i = first; i < end; i++) {
+    mask |= 1UL << table[i].dest;
+  }
+  return mask;
+}
+
+template <const SignalDescriptor* TABLE, uint16_t I>
+inline void decodeSignal(const uint8_t* data, ECUData& out, uint32_t now_ms) {
+  constexpr SignalDescriptor s = TABLE[I];
+  constexpr SignalField field = SIGNAL_FIELDS[s.dest];
+  const uint8_t* p = data + s.start_byte;
+
+  uint32_t raw = 0;
+  if constexpr (s.flags & SIG_BIG_ENDIAN) {
+    for (uint8_t b = 0; b < s.length; b++) raw = (raw << 8) | p[b];
+  } else {
+    for (uint8_t b = s.length; b > 0; b--) raw = (raw << 8) | p[b - 1];
+  }
+
+  int32_t value = (int32_t)raw;
+  if constexpr ((s.flags & SIG_SIGNED) && s.length < 4) {
+    constexpr uint32_t sign_bit = 1UL << (s.length * 8 - 1);
+    value = (int32_t)((raw ^ sign_bit) - sign_bit);
+  }
+
+  if constexpr (field.kind == KIND_FLOAT) {
+    if constexpr (s.scale == 1.0f && s.offset == 0.0f) {
+      out.*field.f = (float)value;
+    } else {
+      out.*field.f = (float)value * s.scale + s.offset;
+    }
+  } else if constexpr (field.kind == KIND_U8) {
+    out.*field.u8 = (uint8_t)((float)value * s.scale + s.offset);
+  } else if constexpr (s.bit_mask != 0) {
+    out.*field.flag = (value & s.bit_mask) != 0;
+  } else {
+    out.*field.flag = value != 0;
+  }
+  out.signal_updated_ms[s.dest] = now_ms;
+}
+
+template <const SignalDescriptor* TABLE, uint16_t FIRST, uint16_t... Is>
+inline void decodeSignals(const uint8_t* data, ECUData& out, uint32_t now_ms,
+                          std::integer_sequence<uint16_t, Is...>) {
+  (decodeSignal<TABLE, FIRST + Is>(data, out, now_ms), ...);
+}
+
+template <const SignalDescriptor* TABLE, uint16_t COUNT, uint16_t FRAME>
+void decodeFrame(const uint8_t* data, ECUData& out, uint32_t now_ms) {
+  constexpr uint16_t first = tableFrameStart(TABLE, COUNT, FRAME);
+  constexpr uint16_t end = tableFrameStart(TABLE, COUNT, FRAME + 1);
+  decodeSignals<TABLE, first>(data, out, now_ms, std::make_integer_sequence<uint16_t, end - first>{});
+}
+
+template <const SignalDescriptor* TABLE, uint16_t COUNT, uint16_t... Fs>
+constexpr std::array<FrameLayout, sizeof...(Fs)> buildFrameLayouts(std::integer_sequence<uint16_t, Fs...>) {
+  return {{FrameLayout{
+    TABLE[tableFrameStart(TABLE, COUNT, Fs)].can_id,
+    TABLE[tableFrameStart(TABLE, COUNT, Fs)].mux,
+    tableFrameMinLength(TABLE, tableFrameStart(TABLE, COUNT, Fs), tableFrameStart(TABLE, COUNT, Fs + 1)),
+    (uint8_t)(tableFrameStart(TABLE, COUNT, Fs + 1) - tableFrameStart(TABLE, COUNT, Fs)),
+    framePriority(tableFrameSignalMask(TABLE, tableFrameStart(TABLE, COUNT, Fs), tableFrameStart(TABLE, COUNT, Fs + 1))),
+    tableFrameStart(TABLE, COUNT, Fs),
+    tableFrameSignalMask(TABLE, tableFrameStart(TABLE, COUNT, Fs), tableFrameStart(TABLE, COUNT, Fs + 1)),
+    &decodeFrame<TABLE, COUNT, Fs>
+  }...}};
+}
+
+template <const SignalDescriptor* TABLE, uint16_t COUNT>
+constexpr auto compileSignalTable() {
+  static_assert(signalTableValid(TABLE, COUNT), "signal table has an invalid or ungrouped entry");
+  return buildFrameLayouts<TABLE, COUNT>(std::make_integer_sequence<uint16_t, tableFrameCount(TABLE, COUNT)>{});
+}
+
+inline constexpr auto CUSTOM_STREAM_FRAMES = compileSignalTable<CUSTOM_STREAM_SIGNALS, CUSTOM_STREAM_SIGNAL_COUNT>();
+inline constexpr auto HALTECH_IC7_FRAMES = compileSignalTable<HALTECH_IC7_SIGNALS, HALTECH_IC7_SIGNAL_COUNT>();
+inline constexpr auto GENERIC_DASH2_FRAMES = compileSignalTable<GENERIC_DASH2_SIGNALS, GENERIC_DASH2_SIGNAL_COUNT>();
+
+// ========== DECODER ==========
+#define DECODER_MAX_FRAMES 64       // Layouts, counting each page of a multiplexed frame
+#define DECODER_MAX_MUX_IDS 4       // Multiplexed IDs, one page table each
+
+// Signal staleness: a signal goes invalid once its frame has been silent
+// for STALE_INTERVALS of its measured period, never sooner than
+// STALE_MIN_TIMEOUT_MS. Until a period has been measured the frame gets
+// STALE_DEFAULT_TIMEOUT_MS.
+#define STALE_INTERVALS 3
+#define STALE_MIN_TIMEOUT_MS 100
+#define STALE_DEFAULT_TIMEOUT_MS 1000
+#define STALE_EWMA_SHIFT 3          // Period EWMA weight 1/8
+
+class SignalDecoder {
+public:
+  SignalDecoder() { clear(); }
+
+  // Stop decoding everything
+  void clear();
+
+  // Load compiled frame layouts into the dispatch array, adding id_base
+  // to every layout's ID (for base-relative protocols). Returns false
+  // (and decodes nothing) if they do not fit, if an ID appears twice, or
+  // if an ID is used both plain and multiplexed.
+  bool configure(const FrameLayout* frames, uint8_t count, uint16_t id_base = 0);
+
+  static const uint8_t NO_FRAME = 0xFF;
+
+  // Decode one frame into out, stamping its signals fresh at now_ms.
+  // Returns true if the ID is handled (a multiplexed page with no layout
+  // is handled and ignored).
+  bool decode(uint32_t can_id, const uint8_t* data, uint8_t length, ECUData& out, uint32_t now_ms) {
+    if (can_id >= CAN_STD_ID_COUNT) return false;
+    uint8_t slot = slot_for_id_[can_id];
+    if (slot == NO_FRAME) return false;
+
+    if (slot & MUX_TABLE) {
+      if (length == 0) return true;
+      slot = mux_slot_[slot & ~MUX_TABLE][data[0]];
+      if (slot == NO_FRAME) return true;
+    }
+    decodeSlot(slot, data, length, out, now_ms);
+    return true;
+  }
+
+  // The same in two steps, for callers that queue frames between them:
+  // the layout slot that decodes this frame (NO_FRAME if none does), then
+  // the decode itself
+  uint8_t slotFor(uint32_t can_id, const uint8_t* data, uint8_t length) const {
+    if (can_id >= CAN_STD_ID_COUNT) return NO_FRAME;
+    uint8_t slot = slot_for_id_[can_id];
+    if (slot == NO_FRAME || !(slot & MUX_TABLE)) return slot;
+    return length ? mux_slot_[slot & ~MUX_TABLE][data[0]] : NO_FRAME;
+  }
+
+  // Returns false (and decodes nothing) for a frame too short for the
+  // layout
+  bool decodeSlot(uint8_t slot, const uint8_t* data, uint8_t length, ECUData& out, uint32_t now_ms) {
+    if (!decodeSlotSignals(slot, data, length, out, now_ms)) return false;
+    trackPeriod(slot, now_ms);
+    return true;
+  }
+
+  // The decode alone, for a frame whose arrival already went through
+  // trackPeriod(): a backlog decodes only the newest of several frames,
+  // but every one of them is a period sample
+  bool decodeSlotSignals(uint8_t slot, const uint8_t* data, uint8_t length, ECUData& out, uint32_t now_ms) {
+    const FrameLayout& frame = frames_[slot];
+    if (length < frame.min_length) return false;
+    frame.decode(data, out, now_ms);   // Stamps the frame's signals
+    out.signal_valid |= frame.signal_mask;
+    return true;
+  }
+
+  bool fitsSlot(uint8_t slot, uint8_t length) const { return length >= frames_[slot].min_length; }
+
+  // Online period estimate, fixed point with STALE_EWMA_SHIFT fraction
+  // bits. A gap longer than the timeout is a dropout, not a period, so it
+  // only nudges the estimate by the timeout itself; no timeout is below
+  // STALE_MIN_TIMEOUT_MS, so a shorter gap needs no clamping.
+  void trackPeriod(uint8_t slot, uint32_t arrival_ms) {
+    FrameTiming& timing = timing_[slot];
+    if (timing.seen) {
+      uint32_t interval = arrival_ms - timing.last_ms;
+      if (timing.interval_ewma == 0) {
+        timing.interval_ewma = interval << STALE_EWMA_SHIFT;
+      } else {
+        if (interval > STALE_MIN_TIMEOUT_MS) {
+          uint32_t timeout = frameTimeout(slot);
+          if (interval > timeout) interval = timeout;
+        }
+        timing.interval_ewma += interval - (timing.interval_ewma >> STALE_EWMA_SHIFT);
+      }
+    }
+    timing.seen = true;
+    timing.last_ms = arrival_ms;
+  }
+
+  FramePriority slotPriority(uint8_t slot) const { return frames_[slot].priority; }
+
+  // Clear the valid bit of every signal whose frame has gone quiet, and
+  // of anything this decoder does not provide. Call once per loop.
+  void refreshValidity(ECUData& out, uint32_t now_ms) const;
+
+  // Silence after which a frame's signals go stale
+  uint32_t frameTimeout(uint8_t slot) const {
+    uint32_t interval = frameInterval(slot);
+    if (interval == 0) return STALE_DEFAULT_TIMEOUT_MS;
+
+    uint32_t timeout = interval * STALE_INTERVALS;
+    return timeout < STALE_MIN_TIMEOUT_MS ? STALE_MIN_TIMEOUT_MS : timeout;
+  }
+
+  // Measured frame period in ms (0 = fewer than two frames seen)
+  uint32_t frameInterval(uint8_t slot) const { return timing_[slot].interval_ewma >> STALE_EWMA_SHIFT; }
+
+  bool handles(uint32_t can_id) const {
+    return can_id < CAN_STD_ID_COUNT && slot_for_id_[can_id] != NO_FRAME;
+  }
+
+  // Smallest single acceptance filter covering every configured ID: an
+  // 11-bit ID passes when (id & ~dont_care) == code. Returns false when
+  // no frames are configured.
+  bool acceptanceFilter(uint16_t& code, uint16_t& dont_care) const;
+
+  // True if some configured frame writes this signal
+  bool provides(SignalId signal) const {
+    return (signal_mask_ & (1UL << signal)) != 0;
+  }
+
+  uint8_t frameCount() const { return frame_count_; }
+  uint16_t signalCount() const { return signal_count_; }
+
+private:
+  static const uint8_t MUX_TABLE = 0x80;   // slot_for_id_: index into mux_slot_, not frames_
+  static_assert(DECODER_MAX_FRAMES <= MUX_TABLE, "frame slots must leave the MUX_TABLE bit clear");
+
+  // Point can_id (or one page of it) at a frame slot
+  bool assignSlot(uint16_t can_id, uint16_t mux, uint8_t slot);
+
+  uint8_t slot_for_id_[CAN_STD_ID_COUNT];
+  uint8_t mux_slot_[DECODER_MAX_MUX_IDS][256];   // Page index -> frame slot
+  uint8_t mux_count_;
+  FrameLayout frames_[DECODER_MAX_FRAMES];
+  uint8_t frame_count_;
+  uint16_t signal_count_;
+  uint32_t signal_mask_;
+
+  // Per-frame timing and the frame that writes each signal
+  struct FrameTiming {
+    uint32_t last_ms;
+    uint32_t interval_ewma;
+    bool seen;
+  };
+  FrameTiming timing_[DECODER_MAX_FRAMES];
+  uint8_t frame_for_signal_[SIG_COUNT];
+};
@@ -0,0 +1,70 @@
+// Link G4X Monitor - Display unit conversion
+//
+// Decoded values are always metric. Every conversion to the selected
+// unit system is affine (display = metric * scale + offset), so the
+// branching on the unit system happens once, in buildDisplayScales(),
+// when the units change; the gauge redraw then applies one precomputed
+// multiply-add per signal. Inline so the redraw path and the benchmark
+// suite run the same arithmetic.
+#pragma once
+
+#include "ecu_data.h"
+
+enum UnitSystem {
+  METRIC = 0,    // Celsius, kPa, km/h
+  IMPERIAL = 1   // Fahrenheit, PSI, mph
+};
+
+// What a signal measures, as far as display units are concerned
+enum DisplayQuantity : uint8_t {
+  QTY_UNITLESS,        // Shown as decoded (rpm, %, V, lambda, deg)
+  QTY_TEMPERATURE,     // °C / °F
+  QTY_BOOST_PRESSURE,  // kPa / PSI
+  QTY_FLUID_PRESSURE,  // bar / PSI (oil, fuel)
+  QTY_SPEED            // km/h / mph
+};
+
+constexpr DisplayQuantity signalQuantity(SignalId signal) {
+  switch (signal) {
+    case SIG_ECT:
+    case SIG_IAT:
+    case SIG_OIL_TEMP:
+    case SIG_FUEL_TEMP:
+    case SIG_ECU_TEMP:
+      return QTY_TEMPERATURE;
+    case SIG_MGP:
+      return QTY_BOOST_PRESSURE;
+    case SIG_OIL_PRESS:
+    case SIG_FUEL_PRESS:
+      return QTY_FLUID_PRESSURE;
+    case SIG_VEHICLE_SPEED:
+      return QTY_SPEED;
+    default:
+      return QTY_UNITLESS;
+  }
+}
+
+struct DisplayScale {
+  float scale;
+  float offset;
+
+  float apply(float metric) const { return metric * scale + offset; }
+};
+
+inline DisplayScale displayScale(DisplayQuantity quantity, UnitSystem units) {
+  bool imperial = units == IMPERIAL;
+  switch (quantity) {
+    case QTY_TEMPERATURE: return imperial ? DisplayScale{9.0f / 5.0f, 32.0f} : DisplayScale{1.0f, 0.0f};
+    case QTY_BOOST_PRESSURE: return imperial ? DisplayScale{0.145038f, 0.0f} : DisplayScale{1.0f, 0.0f};
+    case QTY_FLUID_PRESSURE: return imperial ? DisplayScale{0.145038f, 0.0f} : DisplayScale{0.01f, 0.0f};
+    case QTY_SPEED: return imperial ? DisplayScale{0.621371f, 0.0f} : DisplayScale{1.0f, 0.0f};
+    default: return DisplayScale{1.0f, 0.0f};
+  }
+}
+
+// One coefficient pair per SignalId for the given unit system
+inline void buildDisplayScales(UnitSystem units, DisplayScale (&scales)[SIG_COUNT]) {
+  for (uint8_t signal = 0; signal < SIG_COUNT; signal++) {
+    scales[signal] = displayScale(signalQuantity((SignalId)signal), units);
+  }
+}